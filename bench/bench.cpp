@@ -0,0 +1,359 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       bench.cpp
+ * @brief      Time the warehouse code paths on generated databases
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <datasetgenerator.hpp>
+#include <tab.hpp>
+#include <connection.hpp>
+#include <exporter.hpp>
+#include <schema.hpp>
+#include <searchscheduler.hpp>
+#include <workerpool.hpp>
+#include <dbprofile.hpp>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTemporaryFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSqlQuery>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+enum
+{
+   /** @brief Give up waiting for a tab after this time */
+   Timeout=600000,
+};
+
+
+/** @brief Samples of one measurement
+ */
+struct CResult
+{
+   QString name;
+   QString table;
+   QVector<double> msecs;
+};
+
+
+static double msecs(const QElapsedTimer &timer)
+{
+   return( timer.nsecsElapsed() / 1000000.0 );
+}
+
+
+/** @brief Run 'trigger' and the event loop until 'tab' emitted 'listed()'
+ *         and/or 'counted()'
+ *
+ * The signals are connected before 'trigger' runs, so signals emitted by it
+ * directly are not lost.
+ * @return false on timeout
+ */
+static bool waitFor(CWarehouseTab *tab, const std::function<void()> &trigger
+                    , bool listed, bool counted)
+{
+   QEventLoop loop;
+   QTimer timeout;
+
+   auto check=[&](){
+      if( !listed && !counted )
+      {
+         loop.quit();
+      }
+   };
+   QObject::connect(tab, &CWarehouseTab::listed, &loop, [&](){ listed=false; check(); });
+   QObject::connect(tab, &CWarehouseTab::counted, &loop, [&](){ counted=false; check(); });
+   QObject::connect(&timeout, &QTimer::timeout, &loop, [&](){ loop.exit(1); });
+
+   trigger();
+
+   // Quitting before 'exec()' would be ignored
+   if( !listed && !counted )
+   {
+      return(true);
+   }
+
+   timeout.setSingleShot(true);
+   timeout.start(Timeout);
+
+   if( loop.exec() != 0 )
+   {
+      qWarning("Timeout waiting for tab '%s'", qPrintable( tab->table() ));
+      return(false);
+   }
+
+   return(true);
+}
+
+
+static QJsonObject toJson(const CResult &result)
+{
+   QVector<double> sorted=result.msecs;
+   QJsonArray samples;
+   QJsonObject object;
+
+   std::sort(sorted.begin(), sorted.end());
+   for(double sample: result.msecs)
+   {
+      samples.append(sample);
+   }
+
+   object["name"]=result.name;
+   if(!result.table.isEmpty())
+   {
+      object["table"]=result.table;
+   }
+   object["samples"]=samples;
+   if(!sorted.isEmpty())
+   {
+      object["min"]=sorted.first();
+      object["median"]=sorted[sorted.size() / 2];
+      object["max"]=sorted.last();
+   }
+
+   return(object);
+}
+
+
+int main(int argc, char * argv[])
+{
+   // The tabs are real widgets, but nothing is shown
+   if( qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") )
+   {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+   }
+   QApplication app(argc, argv);
+   QCoreApplication::setApplicationName("warehouse_bench");
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Benchmark of warehouse on a generated database");
+   parser.addHelpOption();
+
+   QCommandLineOption oRows( QStringList() << "r" << "rows"
+                             , "Rows of the main table, e.g. 1k, 100k or 10M", "rows", "100k" );
+   parser.addOption( oRows );
+   QCommandLineOption oSeed( "seed", "Seed of the generator", "seed", "1" );
+   parser.addOption( oSeed );
+   QCommandLineOption oDatabase( "database"
+                             , "Database to use; generated if it does not exist"
+                             , "file" );
+   parser.addOption( oDatabase );
+   QCommandLineOption oGenerate( "generate", "Generate the database also if it exists" );
+   parser.addOption( oGenerate );
+   QCommandLineOption oRepeat( "repeat", "Repetitions of every measurement", "n", "5" );
+   parser.addOption( oRepeat );
+   QCommandLineOption oSearch( "search", "Text typed into the search box", "text", "Capa" );
+   parser.addOption( oSearch );
+   QCommandLineOption oProfile( "profile"
+                             , "Connection tuning: " + CDbProfile::profiles().join(", ")
+                             , "profile" );
+   parser.addOption( oProfile );
+   QCommandLineOption oOutput( QStringList() << "o" << "output"
+                             , "Write the JSON results to <file>; stdout by default", "file" );
+   parser.addOption( oOutput );
+
+   parser.process(app);
+
+   bool ok;
+   qint64 rows=CDatasetGenerator::parseRows( parser.value( oRows ), &ok );
+   if(!ok)
+   {
+      qFatal("Invalid number of rows '%s'", qPrintable( parser.value( oRows ) ));
+   }
+   if( parser.isSet( oProfile ) && !CDbProfile::setProfile( parser.value( oProfile ) ) )
+   {
+      qFatal("Unknown profile '%s'", qPrintable( parser.value( oProfile ) ));
+   }
+   int repeat=qMax(1, parser.value( oRepeat ).toInt());
+   QString search=parser.value( oSearch );
+   QString fileName=parser.value( oDatabase );
+   if(fileName.isEmpty())
+   {
+      fileName=QDir::temp().filePath( QString("warehouse_bench_%1.sqlite")
+                                      .arg( parser.value( oRows ) ) );
+   }
+
+   QVector<CResult> results;
+   QElapsedTimer timer;
+
+   // Typing is measured without the debounce time
+   CSearchScheduler::setDebounce(0);
+
+   if( parser.isSet( oGenerate ) || !QFileInfo::exists(fileName) )
+   {
+      CDatasetGenerator generator(rows, parser.value( oSeed ).toUInt());
+      timer.start();
+      if( !generator.generate(fileName) )
+      {
+         qFatal("Could not generate '%s'", qPrintable(fileName));
+      }
+      results.append( { "generate", QString(), { msecs(timer) } } );
+   }
+
+   // Opening, tuning and reading the schema
+   timer.start();
+   QSqlError err=CConnection::openDefault(fileName);
+   if( err.type() != QSqlError::NoError )
+   {
+      qFatal("Could not open database: %s", qPrintable( err.text() ));
+   }
+   results.append( { "startup", QString(), { msecs(timer) } } );
+
+   for(const QString &table: QStringList( { "Parts", "Location" } ))
+   {
+      CResult opened{ "tab_open", table, {} };
+      CResult keystroke{ "search_keystroke", table, {} };
+      CResult added{ "add", table, {} };
+      CResult removed{ "remove", table, {} };
+      CResult counted{ "count", table, {} };
+
+      if( CSchema::table(table).isNull() )
+      {
+         qWarning("No table '%s'; not generated by warehouse_bench?", qPrintable(table));
+         continue;
+      }
+
+      for(int i1=0; i1<repeat; i1++)
+      {
+         // Built like a tab shown the first time; done when list and counts are there
+         CWarehouseTab *tab=new CWarehouseTab(table);
+         timer.start();
+         if( !waitFor(tab, [tab](){ tab->build(); }, true, true) )
+         {
+            return(1);
+         }
+         opened.msecs.append( msecs(timer) );
+
+         // One search per typed character, as without debounce time
+         QLineEdit *line=tab->findChild<QLineEdit *>("lineSearch");
+         for(int i2=1; line && ( i2<=search.size() ); i2++)
+         {
+            timer.start();
+            if( !waitFor(tab, [&](){ line->setText( search.left(i2) ); }, true, false) )
+            {
+               return(1);
+            }
+            keystroke.msecs.append( msecs(timer) );
+         }
+         if( line && !waitFor(tab, [line](){ line->clear(); }, true, false) )
+         {
+            return(1);
+         }
+
+         // The added record is selected, so it is the one removed
+         QPushButton *pushAdd=tab->findChild<QPushButton *>("pushAdd");
+         QPushButton *pushRemove=tab->findChild<QPushButton *>("pushRemove");
+         if( pushAdd && pushRemove )
+         {
+            timer.start();
+            emit pushAdd->pressed();
+            added.msecs.append( msecs(timer) );
+
+            timer.start();
+            emit pushRemove->pressed();
+            removed.msecs.append( msecs(timer) );
+         }
+
+         timer.start();
+         if( !waitFor(tab, [tab](){ tab->reload(); }, true, true) )
+         {
+            return(1);
+         }
+         counted.msecs.append( msecs(timer) );
+
+         delete tab;
+      }
+
+      results << opened << keystroke << added << removed << counted;
+
+      CResult exported{ "export_csv", table, {} };
+      for(int i1=0; i1<repeat; i1++)
+      {
+         QTemporaryFile file;
+         CExporter exporter(CExporter::FormatCsv);
+         if( !file.open() )
+         {
+            break;
+         }
+         timer.start();
+         exporter.write(table, &file);
+         exported.msecs.append( msecs(timer) );
+      }
+      results << exported;
+   }
+
+   QJsonObject report;
+   QJsonArray measurements;
+   QSqlQuery version;
+   if( version.exec("SELECT sqlite_version()") && version.next() )
+   {
+      report["sqlite"]=version.value(0).toString();
+   }
+   if( version.exec("PRAGMA journal_mode") && version.next() )
+   {
+      report["journal_mode"]=version.value(0).toString();
+   }
+   version.finish();
+   report["benchmark"]="warehouse";
+   report["database"]=fileName;
+   report["rows"]=rows;
+   report["qt"]=QString(qVersion());
+   report["threads"]=CWorkerPool::threads();
+   for(const CResult &result: results)
+   {
+      measurements.append( toJson(result) );
+   }
+   report["results"]=measurements;
+
+   QFile output( parser.value( oOutput ) );
+   bool opened;
+   if( parser.value( oOutput ).isEmpty() )
+   {
+      opened=output.open(stdout, QIODevice::WriteOnly);
+   }
+   else
+   {
+      opened=output.open(QIODevice::WriteOnly);
+   }
+   if(!opened)
+   {
+      qFatal("Could not open '%s'", qPrintable( output.fileName() ));
+   }
+   output.write( QJsonDocument(report).toJson() );
+   output.close();
+
+   // Quitting ends the workers and closes their connections
+   QTimer::singleShot(0, &app, &QCoreApplication::quit);
+
+   return( app.exec() );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,215 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       datasetgenerator.cpp
+ * @brief      Create databases of a given size for benchmarking
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <datasetgenerator.hpp>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFile>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+enum
+{
+   /** @brief Rows per transaction */
+   BatchSize=100000,
+};
+
+
+static const char *s_words[]=
+{
+   "Resistor", "Capacitor", "Diode", "Transistor", "Relay", "Fuse", "Switch",
+   "Connector", "Cable", "Socket", "Crystal", "Inductor", "Sensor", "Display",
+   "Motor", "Battery", "Screw", "Nut", "Washer", "Spacer", "Bracket", "Hinge",
+   "Spring", "Gear", "Bearing", "Shaft", "Pulley", "Belt", "Valve", "Pump",
+   "red", "green", "blue", "black", "white", "small", "large", "tiny", "heavy",
+   "metal", "plastic", "ceramic", "steel", "brass", "copper", "round", "flat",
+   "long", "short", "shielded", "sealed", "spare", "used", "new", "boxed",
+};
+
+
+CDatasetGenerator::CDatasetGenerator(qint64 rows, quint32 seed)
+   :m_rows(rows)
+   ,m_random(seed)
+{
+}
+
+
+qint64 CDatasetGenerator::parseRows(const QString &text, bool *ok)
+{
+   QString number=text.trimmed();
+   qint64 factor=1;
+   bool valid;
+
+   if( number.endsWith('k', Qt::CaseInsensitive) )
+   {
+      factor=1000;
+      number.chop(1);
+   }
+   else if( number.endsWith('M') )
+   {
+      factor=1000000;
+      number.chop(1);
+   }
+
+   qint64 rows=number.toLongLong(&valid) * factor;
+   valid=valid && ( rows > 0 );
+   if(ok)
+   {
+      *ok=valid;
+   }
+
+   return( valid ? rows : 0 );
+}
+
+
+QString CDatasetGenerator::word()
+{
+   return( s_words[ m_random.bounded( int( sizeof(s_words) / sizeof(s_words[0]) ) ) ] );
+}
+
+
+QString CDatasetGenerator::description(int words)
+{
+   QStringList text;
+
+   for(int i1=0; i1<words; i1++)
+   {
+      text << word();
+   }
+
+   return( text.join(' ') + '.' );
+}
+
+
+bool CDatasetGenerator::fill(QSqlDatabase &db, const QString &table, qint64 rows
+                             , int words, const QStringList &references
+                             , const QVector<qint64> &sizes)
+{
+   QStringList columns( { "id", "Name", "Description", "Number" } );
+   QStringList placeholders;
+   QSqlQuery query(db);
+
+   QString create=QString("CREATE TABLE \"%1\" (\n"
+                          "\t\"id\"\tINTEGER,\n"
+                          "\t\"Name\"\tTEXT,\n"
+                          "\t\"Description\"\tTEXT,\n"
+                          "\t\"Number\"\tINTEGER,\n").arg(table);
+   for(const QString &reference: references)
+   {
+      QString column=reference + "_id_Name";
+      create += QString("\t\"%1\"\tINTEGER,\n").arg(column);
+      columns << column;
+   }
+   create += "\tPRIMARY KEY(\"id\")\n)";
+
+   if( !query.exec(create) )
+   {
+      qWarning("Could not create '%s': %s", qPrintable(table)
+               , qPrintable(query.lastError().text()));
+      return(false);
+   }
+
+   for(int i1=0; i1<columns.size(); i1++)
+   {
+      placeholders << "?";
+   }
+   query.prepare( QString("INSERT INTO \"%1\" (\"%2\") VALUES (%3)")
+                  .arg(table, columns.join("\", \""), placeholders.join(", ")) );
+
+   db.transaction();
+   for(qint64 id=1; id<=rows; id++)
+   {
+      query.bindValue(0, id);
+      query.bindValue(1, QString("%1 %2 %3").arg(word(), word()).arg(id));
+      query.bindValue(2, description(words));
+      query.bindValue(3, m_random.bounded(10000));
+      for(int i1=0; i1<references.size(); i1++)
+      {
+         qint64 key=1 + m_random.bounded( int( sizes[i1] ) );
+         // One in a thousand points nowhere
+         if( ( i1 == 0 ) && ( m_random.bounded(1000) == 0 ) )
+         {
+            key += sizes[i1];
+         }
+         query.bindValue(4 + i1, key);
+      }
+
+      if( !query.exec() )
+      {
+         qWarning("Could not fill '%s': %s", qPrintable(table)
+                  , qPrintable(query.lastError().text()));
+         db.rollback();
+         return(false);
+      }
+
+      if( id % BatchSize == 0 )
+      {
+         db.commit();
+         db.transaction();
+         if( id % ( BatchSize * 10 ) == 0 )
+         {
+            qWarning("%s: %lld rows", qPrintable(table), id);
+         }
+      }
+   }
+
+   return(db.commit());
+}
+
+
+bool CDatasetGenerator::generate(const QString &fileName)
+{
+   bool ret=false;
+   qint64 locations=qMax<qint64>(10, m_rows / 100);
+   qint64 categories=qMax<qint64>(10, m_rows / 1000);
+   qint64 packages=20;
+
+   QFile::remove(fileName);
+
+   {
+      QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE", "generator");
+      db.setDatabaseName(fileName);
+      if( !db.open() )
+      {
+         qWarning("Could not create '%s': %s", qPrintable(fileName)
+                  , qPrintable(db.lastError().text()));
+      }
+      else
+      {
+         // Nothing to recover if this fails; the file is created again
+         QSqlQuery query(db);
+         query.exec("PRAGMA journal_mode=OFF");
+         query.exec("PRAGMA synchronous=OFF");
+
+         ret=fill(db, "Location", locations, 12, {}, {})
+             && fill(db, "Categories", categories, 12, {}, {})
+             && fill(db, "Packages", packages, 12, {}, {})
+             && fill(db, "Parts", m_rows, 24, { "Location", "Categories", "Packages" }
+                     , { locations, categories, packages } );
+         db.close();
+      }
+   }
+   QSqlDatabase::removeDatabase("generator");
+
+   return(ret);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
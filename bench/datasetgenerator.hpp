@@ -0,0 +1,66 @@
+#ifndef WAREHOUSE_DATASETGENERATOR_HPP
+#define WAREHOUSE_DATASETGENERATOR_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       datasetgenerator.hpp
+ * @brief      Create databases of a given size for benchmarking
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSqlDatabase>
+#include <QRandomGenerator>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Writes a database like 'example/example.sqlite' with many rows
+ *
+ * 'Parts' gets the requested number of rows and references 'Location',
+ * 'Categories' and 'Packages' by '<Table>_id_Name' columns. The referenced
+ * tables get a hundredth, a thousandth and a fixed number of rows. Every
+ * table has a 'Description' of some sentences. One Part in a thousand has a
+ * dangling Location, so the missing rows panel has work too. The same seed
+ * gives the same database.
+ */
+class CDatasetGenerator
+{
+public:
+   explicit CDatasetGenerator(qint64 rows, quint32 seed=1);
+
+   /** @brief Parse a number of rows like '1k', '100k' or '10M'
+    */
+   static qint64 parseRows(const QString &text, bool *ok=nullptr);
+
+   /** @brief Create 'fileName'; an existing file is replaced
+    */
+   bool generate(const QString &fileName);
+
+   qint64 rows() const { return(m_rows); }
+
+private:
+   qint64 m_rows;
+   QRandomGenerator m_random;
+
+   QString word();
+   QString description(int words);
+   bool fill(QSqlDatabase &db, const QString &table, qint64 rows, int words
+             , const QStringList &references, const QVector<qint64> &sizes);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_DATASETGENERATOR_HPP
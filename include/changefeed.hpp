@@ -0,0 +1,158 @@
+#ifndef WAREHOUSE_CHANGEFEED_HPP
+#define WAREHOUSE_CHANGEFEED_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       changefeed.hpp
+ * @brief      Rows changed in the database, by this or other processes
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QTimer>
+#include <QHash>
+#include <QSqlDatabase>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief One row inserted, updated or deleted
+ */
+struct CChange
+{
+   enum Op
+   {
+      Insert,
+      Update,
+      Delete,
+      /** @brief Some rows of the table changed; 'rowid' is -1 */
+      Unknown,
+   };
+
+   QString table;
+   qint64 rowid=-1;
+   Op op=Unknown;
+   /** @brief Object which wrote the row, see CChangeOrigin; null if unknown */
+   const void *origin=nullptr;
+};
+
+typedef QVector<CChange> CChanges;
+
+
+/** @brief Tags the changes written while it exists with 'origin'
+ *
+ * A tab ignores the rows it wrote itself, it shows them already.
+ */
+class CChangeOrigin
+{
+public:
+   explicit CChangeOrigin(const void *origin);
+   ~CChangeOrigin();
+
+   /** @brief Origin of the writes of the calling thread
+    */
+   static const void *current();
+
+private:
+   const void *m_previous;
+};
+
+
+/** @brief Feed of changed rows for the GUI thread
+ *
+ * Writes of this process are reported by the update hook of SQLite, after
+ * their transaction was committed; rolled back rows are dropped, also when
+ * the COMMIT itself fails. Other
+ * processes are noticed by polling 'PRAGMA data_version' of every file; the
+ * rows they changed are not known, so every table of that file is reported
+ * once as 'Unknown'. More than 'MaxRows' rows of a table in one pass, e.g.
+ * an import, are reported as 'Unknown' too. With CWriteQueue running, its
+ * connection is polled, since the default one sees the commits of the writer.
+ * The hooks need Qt linked to the same SQLite library as warehouse.
+ * Without them the writers of this process report the tables they wrote by
+ * 'written()', which are reported as 'Unknown' like those of other
+ * processes. Connections never hooked, like those of the worker pool, report
+ * by 'reportTable()'.
+ */
+class CChangeFeed : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum
+   {
+      /** @brief Rows per table and pass reported one by one */
+      MaxRows=1000,
+   };
+
+   static CChangeFeed *instance();
+
+   /** @brief Report the writes of connection 'db'
+    *
+    * @return false if the hook could not be installed
+    */
+   static bool install(const QSqlDatabase &db);
+
+   /** @brief Writes of this process are reported row by row
+    */
+   static bool isInstalled();
+
+   /** @brief Rows of 'table' were committed by this process for 'origin'
+    *
+    * To be called after the COMMIT succeeded, in the thread of the
+    * connection. With the hooks it releases the rows reported by them, which
+    * are dropped if the COMMIT fails; commits of the GUI thread are released
+    * without it. Thread safe.
+    */
+   static void written(const QString &table, const void *origin);
+
+   /** @brief Rows of 'table' were changed in an unknown way for 'origin'
+    *
+    * For connections without hooks, e.g. of an import on the worker pool;
+    * reported as 'Unknown' in any case. Thread safe.
+    */
+   static void reportTable(const QString &table, const void *origin);
+
+   /** @brief Check for other processes every 'msec'; 0 to disable
+    */
+   static void setPollInterval(int msec);
+   static int pollInterval();
+
+   /** @brief Start checking for other processes
+    */
+   void watch();
+
+signals:
+   /** @brief Rows were changed; emitted in the GUI thread
+    */
+   void changed(const CChanges &changes);
+
+private slots:
+   void poll();
+   void dispatch();
+
+private:
+   QTimer m_timer;
+   /** @brief data_version per schema at the last poll */
+   QHash<QString, qint64> m_versions;
+
+   explicit CChangeFeed(QObject *parent = nullptr);
+   /** @brief Report the files whose 'versions' changed since the last poll */
+   void compare(const QHash<QString, qint64> &versions);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_CHANGEFEED_HPP
@@ -0,0 +1,96 @@
+#ifndef WAREHOUSE_CONNECTION_HPP
+#define WAREHOUSE_CONNECTION_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       connection.hpp
+ * @brief      Additional database connections for worker threads
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+struct sqlite3;
+
+
+/** @brief Opens connections to the same file as the default connection
+ *
+ * A QSqlDatabase may only be used by the thread which created it. Threads
+ * therefore open their own connection with an unique name.
+ * Files attached to the default connection are attached to every connection
+ * opened afterwards, so attaching is meant for startup.
+ * In read only mode the files are opened immutable: SQLite neither locks
+ * nor checks them for changes, so nobody may write them meanwhile. In memory
+ * mode they are copied into memory databases shared by all connections.
+ */
+class CConnection
+{
+public:
+   /** @brief Open 'databaseFile' as default connection, tune it and read the
+    *         schema; no widgets needed
+    */
+   static QSqlError openDefault(const QString &databaseFile);
+
+   /** @brief Open the files read only and immutable; before opening
+    */
+   static void setReadOnly(bool readOnly);
+   static bool isReadOnly();
+
+   /** @brief Copy the files into memory when opening; implies read only
+    */
+   static void setInMemory(bool inMemory);
+   static bool isInMemory();
+
+   /** @brief Attach 'databaseFile' to the default connection as 'schema'
+    *
+    * Without 'schema' the base name of the file is used, made unique and
+    * valid as identifier. The schema is read again.
+    */
+   static QSqlError attach(const QString &databaseFile, const QString &schema=QString());
+
+   /** @brief Get connection 'name'; opened on first use by calling thread
+    */
+   static QSqlDatabase open(const QString &name);
+
+   /** @brief Close and remove connection 'name'
+    */
+   static void close(const QString &name);
+
+   /** @brief SQLite handle of 'db' for the C API
+    *
+    * Null unless Qt uses the same SQLite library as warehouse; only then the
+    * handle may be passed to it.
+    */
+   static sqlite3 *handle(const QSqlDatabase &db);
+
+   /** @brief Quote 'name' for use as table name in SQL, e.g. '"Parts"'
+    *
+    * Names of attached files, '<schema>.<table>', are quoted part by part.
+    */
+   static QString escapeTable(const QString &name
+                              , const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Quote 'name' for use as column or schema name in SQL
+    */
+   static QString escapeField(const QString &name
+                              , const QSqlDatabase &db=QSqlDatabase::database());
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_CONNECTION_HPP
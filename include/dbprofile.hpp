@@ -0,0 +1,75 @@
+#ifndef WAREHOUSE_DBPROFILE_HPP
+#define WAREHOUSE_DBPROFILE_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       dbprofile.hpp
+ * @brief      Tuning of the SQLite connections
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief PRAGMAs applied to every connection
+ *
+ * A profile is a preset of PRAGMAs:
+ *   - 'default': SQLite defaults, rollback journal
+ *   - 'read':    WAL, 256 MiB mmap, 64 MiB page cache; for browsing
+ *   - 'write':   WAL, synchronous=NORMAL; for data entry
+ *   - 'safe':    WAL, synchronous=FULL
+ * Single PRAGMAs can be overridden. Settings are read from the table
+ * 'warehouse_settings' (key/value; key 'profile' or a PRAGMA name) of the
+ * database first, then from the command line.
+ */
+class CDbProfile
+{
+public:
+   /** @brief Select preset 'name'
+    *
+    * @return false if there is no such preset
+    */
+   static bool setProfile(const QString &name);
+   static QStringList profiles();
+
+   /** @brief Override a PRAGMA, e.g. "cache_size=-32768"
+    *
+    * @return false if not a known PRAGMA or an invalid value
+    */
+   static bool set(const QString &assignment);
+
+   /** @brief Read the settings table of 'db'; command line settings win
+    */
+   static void load(QSqlDatabase db);
+
+   /** @brief Apply the PRAGMAs to an open connection
+    */
+   static void apply(QSqlDatabase db);
+
+   /** @brief Check if 'table' is the settings table
+    */
+   static bool isSettingsTable(const QString &table);
+
+private:
+   static QMap<QString, QString> preset(const QString &name);
+   static bool valid(const QString &pragma, const QString &value);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_DBPROFILE_HPP
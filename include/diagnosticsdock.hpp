@@ -0,0 +1,62 @@
+#ifndef WAREHOUSE_DIAGNOSTICSDOCK_HPP
+#define WAREHOUSE_DIAGNOSTICSDOCK_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       diagnosticsdock.hpp
+ * @brief      Dock showing the query statistics and slow queries
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QDockWidget>
+#include <QTreeWidget>
+#include <QTimer>
+#include <QDateTime>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Latency histograms per table and kind of query
+ *
+ * The statistics of CQueryProfiler are read again every second while the
+ * dock is visible. The plan of the slowest statement is shown below its row,
+ * the plans of the slow queries below theirs.
+ */
+class CDiagnosticsDock : public QDockWidget
+{
+   Q_OBJECT
+
+public:
+   explicit CDiagnosticsDock(QWidget *parent = nullptr);
+
+public slots:
+   void refresh();
+
+protected:
+   void showEvent(QShowEvent *event) override;
+   void hideEvent(QHideEvent *event) override;
+
+private:
+   QTreeWidget *m_stats;
+   QTreeWidget *m_slow;
+   QTimer m_timer;
+   /** @brief Time of the newest slow query shown */
+   QDateTime m_latest;
+
+   static QString histogram(const QVector<qint64> &buckets);
+   static QString msecs(qint64 nsecs);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_DIAGNOSTICSDOCK_HPP
@@ -0,0 +1,93 @@
+#ifndef WAREHOUSE_EDITBUFFER_HPP
+#define WAREHOUSE_EDITBUFFER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       editbuffer.hpp
+ * @brief      Collect edits of a table and write them in one transaction
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QVariant>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Edits of a table waiting to be written
+ *
+ * In the default mode every edited field is written immediately, each in its
+ * own transaction with a sync to disk. In batched mode the edits are kept
+ * here; later edits of the same field replace earlier ones. All rows are
+ * written in a single transaction when the flush interval elapsed, when
+ * 'Save' is pressed or, with an interval of 0, when another row is selected.
+ */
+class CEditBuffer : public QObject
+{
+   Q_OBJECT
+
+public:
+   explicit CEditBuffer(const QString &table, QObject *parent = nullptr);
+
+   /** @brief Globally enable batched editing, e.g. from command line
+    */
+   static void setEnabled(bool enabled);
+   static bool isEnabled();
+
+   /** @brief Time after the first edit until writing; 0 for on row change
+    */
+   static void setFlushInterval(int msec);
+   static int flushInterval();
+
+   /** @brief Remember 'value' for 'column' of row 'id'
+    */
+   void set(qint64 id, const QString &column, const QVariant &value);
+
+   /** @brief Pending values of row 'id'
+    */
+   QHash<QString, QVariant> values(qint64 id) const;
+
+   /** @brief Forget the edits of row 'id', e.g. when it is removed
+    */
+   void discard(qint64 id);
+
+   bool isDirty() const { return(!m_rows.isEmpty()); }
+   bool isDirty(qint64 id) const { return(m_rows.contains(id)); }
+   QSet<qint64> dirtyIds() const;
+
+public slots:
+   /** @brief Write all edits in one transaction
+    */
+   bool flush();
+
+   /** @brief Drop all edits
+    */
+   void revert();
+
+signals:
+   void dirtyChanged(bool dirty);
+   void flushed(const QList<qint64> &ids);
+   void flushFailed(const QString &error);
+
+private:
+   QString m_table;
+   QHash< qint64, QHash<QString, QVariant> > m_rows;
+   QTimer m_timer;
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_EDITBUFFER_HPP
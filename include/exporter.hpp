@@ -0,0 +1,87 @@
+#ifndef WAREHOUSE_EXPORTER_HPP
+#define WAREHOUSE_EXPORTER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       exporter.hpp
+ * @brief      Write tables as Textile, CSV or JSON Lines without a GUI
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+#include <QIODevice>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Streams whole tables to a file or stdout
+ *
+ * All columns are written; foreign keys '<Table>_id_<Column>' are resolved
+ * to the Name of the referenced record by a join, so SQLite does the
+ * lookups. Rows are read with a forward only query and written through a
+ * buffer of 'BufferSize' bytes, so memory does not grow with the table.
+ */
+class CExporter
+{
+public:
+   enum Format
+   {
+      FormatTextile,
+      FormatCsv,
+      FormatJsonLines,
+   };
+   enum { BufferSize=1<<20 };
+
+   explicit CExporter(Format format);
+
+   /** @brief Get format by name 'textile', 'csv' or 'jsonl'
+    */
+   static bool parseFormat(const QString &name, Format &format);
+   static QStringList formats();
+   static QString suffix(Format format);
+
+   /** @brief Write 'table' to 'device'
+    *
+    * @return number of rows written, -1 on error
+    */
+   qint64 write(const QString &table, QIODevice *device);
+
+   /** @brief Export 'tables' ('*' for all) to 'output'
+    *
+    * 'output' is a file or empty for stdout; when several tables are
+    * exported it is a directory receiving '<table>.<suffix>' files.
+    * @return exit code for main()
+    */
+   static int run(const QStringList &tables, Format format, const QString &output);
+
+private:
+   Format m_format;
+   QByteArray m_buffer;
+   QIODevice *m_device=nullptr;
+   bool m_failed=false;
+   /** @brief Quoted column names followed by ':' for JSON Lines */
+   QVector<QByteArray> m_keys;
+
+   void writeHeader(const QStringList &columns);
+   void writeValue(const QVariant &value, int column);
+   void appendEscaped(QByteArray &buffer, const QByteArray &text) const;
+   bool flush(bool force);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_EXPORTER_HPP
@@ -0,0 +1,58 @@
+#ifndef WAREHOUSE_FORMMODEL_HPP
+#define WAREHOUSE_FORMMODEL_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       formmodel.hpp
+ * @brief      Table model of the form, reading the columns shown only
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+
+#include "queryprofiler.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Model of the record shown in the form of a tab
+ *
+ * With a projection only the given columns are read; the others are
+ * selected as NULL, so positions and field indexes stay those of the
+ * table. Written rows contain the edited fields only, the columns not read
+ * are not overwritten. Tables without primary key are read completely, as
+ * their rows are found by all values.
+ */
+class CFormModel : public CProfiledTableModel
+{
+   Q_OBJECT
+
+public:
+   explicit CFormModel(QObject *parent = nullptr);
+
+   /** @brief Read 'columns' only; all if empty. After 'setTable()'
+    */
+   void setProjection(const QStringList &columns);
+
+protected:
+   QString selectStatement() const override;
+
+private:
+   /** @brief Column list of the select; empty for all */
+   QString m_projection;
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_FORMMODEL_HPP
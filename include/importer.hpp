@@ -0,0 +1,130 @@
+#ifndef WAREHOUSE_IMPORTER_HPP
+#define WAREHOUSE_IMPORTER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       importer.hpp
+ * @brief      Insert rows from CSV or JSON Lines files into a table
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include <QVariant>
+#include <QIODevice>
+#include <QAtomicInt>
+#include <QSqlDatabase>
+#include <schema.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Result of an import
+ */
+struct CImportReport
+{
+   qint64 inserted=0;
+   qint64 rejectedCount=0;
+   /** @brief Line in the file and reason, limited to 'rejectLimit' entries */
+   QVector< QPair<qint64, QString> > rejected;
+   /** @brief Columns of the file which are not in the table */
+   QStringList ignored;
+   /** @brief Line and keys not in the table of JSON Lines records, which are
+    *         inserted without them; limited to 'rejectLimit' entries */
+   QVector< QPair<qint64, QString> > unknown;
+   /** @brief The file could not be read or a batch not be committed;
+    *         'inserted' counts the rows committed before */
+   QString error;
+   qint64 msecs=0;
+};
+
+
+/** @brief Bulk insert into one table
+ *
+ * Columns of the file are mapped to columns of the table by name; the
+ * first line of a CSV file names them, in JSON Lines the keys of each
+ * record do, and columns missing in a record keep their default. Foreign
+ * keys '<Table>_id_<Column>' contain the Name of the referenced record, as
+ * written by the export; the Names are read once into a hash per referenced
+ * table. Rows are inserted by prepared statements in transactions of up to
+ * 'BatchSize' rows, committed after 'BatchMsecs' at the latest so edits of
+ * the GUI waiting for the lock get in well before the busy timeout. Rows which can not be resolved or violate a constraint
+ * are rejected and reported; the others are inserted.
+ * The table is looked up when the importer is created, so 'run()' may be
+ * called with the connection of a worker, see CWorkerPool.
+ */
+class CImporter : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum Format
+   {
+      FormatCsv,
+      FormatJsonLines,
+   };
+   enum { BatchSize=20000, BatchMsecs=200, ProgressRows=1000 };
+
+   explicit CImporter(const QString &table, QObject *parent = nullptr);
+
+   /** @brief Guess the format from the suffix of 'fileName'
+    */
+   static Format formatOf(const QString &fileName);
+
+   /** @brief Import 'device'
+    */
+   CImportReport run(QIODevice *device, Format format, int rejectLimit=1000
+                     , const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Import file 'fileName'
+    */
+   CImportReport run(const QString &fileName, int rejectLimit=1000
+                     , const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Import 'fileNames' and print the reports, e.g. from command line
+    *
+    * Without 'table' the table is named like the file, e.g. 'Parts.csv'.
+    * @return exit code for main(); 2 if rows were rejected
+    */
+   static int importFiles(const QStringList &fileNames, const QString &table);
+
+public slots:
+   /** @brief Stop before the next row; rows inserted so far are kept
+    *
+    * May be called from another thread than the one running the import.
+    */
+   void cancel() { m_canceled.storeRelease(1); }
+
+signals:
+   /** @brief Emitted every 'ProgressRows' records, from the importing thread
+    */
+   void progress(qint64 rows, qint64 bytesRead, qint64 bytesTotal);
+
+private:
+   QString m_table;
+   CTableInfoPtr m_info;
+   QAtomicInt m_canceled;
+   /** @brief Name to id for the referenced tables */
+   QHash< QString, QHash<QString, qint64> > m_names;
+
+   const QHash<QString, qint64> &names(const QString &table, const QSqlDatabase &db);
+   bool readCsvRecord(QIODevice *device, QStringList &fields, qint64 &line);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_IMPORTER_HPP
@@ -0,0 +1,90 @@
+#ifndef WAREHOUSE_INDEXADVISOR_HPP
+#define WAREHOUSE_INDEXADVISOR_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       indexadvisor.hpp
+ * @brief      Propose or create indexes for the queries issued by the tabs
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+#include <QTextStream>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Checks the query plans of the generated queries
+ *
+ * For every table the advisor builds the same statements the tab issues:
+ * the row count and first page of the list, unfiltered and searched, the id
+ * lookup of the form, the Name order of the relation combos and the reverse
+ * lookup of every foreign key '<Table>_id_<Column>'. 'EXPLAIN QUERY PLAN' shows where SQLite has to
+ * scan a table, build an automatic index or sort in a temporary b-tree;
+ * those columns get an index '<table>__idx_<column>'.
+ * The indexes are created inside a transaction to measure the statements
+ * again. Unless 'create' is given, the transaction is rolled back.
+ */
+class CIndexAdvisor
+{
+public:
+   CIndexAdvisor();
+
+   /** @brief Analyze all tables and print the report to 'out'
+    *
+    * @return false if creating an index failed
+    */
+   bool run(bool create, QTextStream &out);
+
+private:
+   struct Candidate
+   {
+      QString table;
+      QString column;
+      /** @brief Name of the table in the plan; the alias of a join */
+      QString alias;
+      /** @brief The statement sorts by the column */
+      bool order=false;
+   };
+
+   struct Probe
+   {
+      QString table;
+      QString title;
+      QString statement;
+      QVariantList values;
+      QVector<Candidate> candidates;
+      QStringList plan;
+      qint64 nsecs=-1;
+      QStringList planAfter;
+      qint64 nsecsAfter=-1;
+   };
+
+   QVector<Probe> m_probes;
+
+   QVector<Probe> probes(const QString &table) const;
+   QVariant sample(const QString &table, const QString &column) const;
+   bool isIndexed(const QString &table, const QString &column) const;
+   bool isWeak(const Probe &probe, const Candidate &candidate) const;
+   QStringList plan(const Probe &probe) const;
+   qint64 measure(const Probe &probe) const;
+   static QString indexName(const Candidate &candidate);
+   static QString createStatement(const Candidate &candidate);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_INDEXADVISOR_HPP
@@ -0,0 +1,192 @@
+#ifndef WAREHOUSE_QUERYPROFILER_HPP
+#define WAREHOUSE_QUERYPROFILER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       queryprofiler.hpp
+ * @brief      Latency statistics and slow query log of all queries
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlTableModel>
+#include <QLoggingCategory>
+#include <functional>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Timings of startup, building tabs, imports and exports and other
+ *         progress messages; debug messages are off by default, see README.md
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcTiming)
+
+
+/** @brief Statistics of one kind of query of one table
+ */
+struct CQueryStats
+{
+   QString table;
+   int kind=0;
+   qint64 count=0;
+   qint64 nsecs=0;
+   qint64 maxNsecs=0;
+   qint64 rows=0;
+   /** @brief Number of queries per latency bucket, see bucketLimit() */
+   QVector<qint64> buckets;
+   /** @brief Slowest statement so far and its plan */
+   QString slowest;
+   QStringList plan;
+};
+
+
+/** @brief A query which took longer than the threshold
+ */
+struct CSlowQuery
+{
+   QDateTime time;
+   QString table;
+   int kind=0;
+   QString sql;
+   qint64 nsecs=0;
+   int rows=0;
+   QStringList plan;
+};
+
+
+/** @brief Collects the latency of the queries of all tabs
+ *
+ * Queries are recorded from the GUI thread and from the workers, so the
+ * statistics are guarded by a mutex. The plan is only explained for a
+ * statement which is slower than the threshold or the slowest of its kind so
+ * far, so a query costs a second statement only rarely. Plans are cached by
+ * statement.
+ */
+class CQueryProfiler
+{
+public:
+   enum Kind
+   {
+      Select,
+      Filter,
+      Relation,
+      Count,
+      Insert,
+      Update,
+      Delete,
+      Kinds
+   };
+
+   enum
+   {
+      /** @brief Latency buckets; the last one has no upper limit */
+      Buckets=12
+   };
+
+   /** @brief Log queries slower than 'msec', e.g. from command line; negative
+    *         to log none
+    */
+   static void setThreshold(int msec);
+   static int threshold();
+
+   /** @brief Record a query which ran 'nsecs' on 'db' in the calling thread
+    */
+   static void record(const QString &table, Kind kind, const QString &sql
+                      , const QVariantList &values, const QSqlDatabase &db
+                      , qint64 nsecs, int rows);
+
+   /** @brief Copy of the statistics, ordered by table and kind
+    */
+   static QVector<CQueryStats> stats();
+
+   /** @brief Latest slow queries, oldest first
+    */
+   static QVector<CSlowQuery> slowQueries();
+
+   static void reset();
+
+   static QString kindName(int kind);
+
+   /** @brief Upper limit of 'bucket' in microseconds; -1 for the last one
+    */
+   static qint64 bucketLimit(int bucket);
+
+private:
+   static QStringList explain(const QString &sql, const QVariantList &values
+                              , const QSqlDatabase &db);
+};
+
+
+/** @brief Measures a query from construction to 'finish()'
+ *
+ * The values are only needed to explain the statement, they have to be the
+ * ones bound to it. 'db' is the connection of the query, so a slow statement
+ * is explained by the thread and connection which ran it.
+ */
+class CQueryTimer
+{
+public:
+   CQueryTimer(const QString &table, CQueryProfiler::Kind kind, const QString &sql
+               , const QVariantList &values, const QSqlDatabase &db);
+
+   /** @brief Records with 0 rows if not finished, e.g. on error
+    */
+   ~CQueryTimer();
+
+   void finish(int rows);
+
+private:
+   QString m_table;
+   CQueryProfiler::Kind m_kind;
+   QString m_sql;
+   QVariantList m_values;
+   QSqlDatabase m_db;
+   QElapsedTimer m_timer;
+   bool m_finished=false;
+};
+
+
+/** @brief Table model recording its selects and writes
+ *
+ * Writes are reported to CChangeFeed with the model as origin.
+ */
+class CProfiledTableModel : public QSqlTableModel
+{
+   Q_OBJECT
+
+public:
+   explicit CProfiledTableModel(QObject *parent = nullptr);
+
+   bool select() override;
+
+protected:
+   bool insertRowIntoTable(const QSqlRecord &values) override;
+   bool updateRowInTable(int row, const QSqlRecord &values) override;
+   bool deleteRowFromTable(int row) override;
+
+private:
+   /** @brief Time 'statement', which runs 'sql', and report the row written
+    */
+   bool write(CQueryProfiler::Kind kind, const QString &sql
+              , const std::function<bool()> &statement);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_QUERYPROFILER_HPP
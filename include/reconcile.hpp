@@ -0,0 +1,110 @@
+#ifndef WAREHOUSE_RECONCILE_HPP
+#define WAREHOUSE_RECONCILE_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       reconcile.hpp
+ * @brief      Count visible/total rows and find rows hidden by broken keys
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QVector>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QPair>
+
+#include "searchindex.hpp"
+#include "rowmodel.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Result of one reconciliation pass
+ */
+struct CReconcileReport
+{
+   /** @brief Rows matching the filter that have all their foreign keys */
+   int visible=0;
+   /** @brief All rows of the table */
+   int total=0;
+   /** @brief Number of rows hidden because a foreign key does not resolve */
+   int missingCount=0;
+   /** @brief id/Name of the hidden rows, limited to 'missingLimit' entries */
+   QVector< QPair<qint64, QString> > missing;
+};
+
+
+/** @brief Compares a table with its relational view
+ *
+ * QSqlRelationalTableModel inner-joins every relation, so rows with a NULL or
+ * dangling foreign key silently disappear from the view. Instead of comparing
+ * both row sets in the GUI, the reconciler left-joins each relation once and
+ * lets SQLite count the rows whose joined key is NULL. The joins hit the
+ * primary key of the referenced table, so a pass is linear in the table size.
+ */
+class CReconciler
+{
+public:
+   explicit CReconciler(const QString &table);
+
+   /** @brief Register a relation as set up by CWarehouseTab::updateRelation
+    */
+   void addRelation(const QString &column, const QString &foreignTable);
+   void clearRelations();
+
+   /** @brief Count rows and collect the hidden ones
+    *
+    * 'filter' is the WHERE expression of the model (may be empty). It may
+    * reference the table by its plain name.
+    */
+   CReconcileReport run(const QString &filter=QString()
+                        , int missingLimit=1000) const;
+
+   /** @brief Statements of 'run()'; built with the default connection
+    */
+   QString countStatement(const QString &filter=QString()) const;
+   QString missingStatement(int missingLimit=1000) const;
+
+   /** @brief Run the statements on 'db', e.g. on a worker thread
+    */
+   static CReconcileReport execute(const QString &countStatement
+                        , const QString &missingStatement, const QSqlDatabase &db);
+
+   /** @brief Check if row 'id' is hidden due to missing keys
+    */
+   bool isMissing(qint64 id) const;
+
+   /** @brief Query listing id/Name of the rows visible in the view
+    *
+    * Like the relational model it only returns rows whose relations resolve.
+    */
+   CRowQuery rowQuery(const CSearchClause &clause) const;
+
+private:
+   struct Relation
+   {
+      QString column;
+      QString foreignTable;
+   };
+
+   QString m_table;
+   QVector<Relation> m_relations;
+
+   QString joinClause() const;
+   QString missingCondition() const;
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_RECONCILE_HPP
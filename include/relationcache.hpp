@@ -0,0 +1,151 @@
+#ifndef WAREHOUSE_RELATIONCACHE_HPP
+#define WAREHOUSE_RELATIONCACHE_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       relationcache.hpp
+ * @brief      Shared id/Name models of the tables referenced by foreign keys
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QPair>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QHash>
+#include <QString>
+
+#include "changefeed.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief id/Name of the rows of a referenced table, ordered by Name
+ *
+ * Rows are read in pages with a keyset condition '(Name, id) > (?, ?)' when
+ * a view scrolls to the end, so the cost does not depend on the size of the
+ * table. With a prefix only Names starting with it are listed; the range
+ * 'Name >= prefix AND Name < next' can use an index on Name.
+ * Rows changed in the database are patched into the rows read so far, see
+ * CChangeFeed.
+ */
+class CLookupModel : public QAbstractTableModel
+{
+   Q_OBJECT
+
+public:
+   enum Column
+   {
+      ColumnId=0,
+      ColumnName,
+      ColumnCount
+   };
+   enum { PageSize=100 };
+
+   explicit CLookupModel(const QString &table, QObject *parent = nullptr);
+
+   const QString &table() const { return(m_table); }
+
+   /** @brief List only Names starting with 'prefix'; empty for all
+    */
+   void setPrefix(const QString &prefix);
+
+   /** @brief Row showing record 'id'; -1 if not read yet
+    */
+   int rowOf(qint64 id) const;
+   qint64 rowId(int row) const;
+
+   /** @brief Name of record 'id' by point lookup; independent of the pages
+    */
+   QString name(qint64 id) const;
+
+   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+   QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+   bool canFetchMore(const QModelIndex &parent) const override;
+   void fetchMore(const QModelIndex &parent) override;
+
+public slots:
+   /** @brief Forget the rows read so far and read the first page again
+    */
+   void reload();
+
+   /** @brief Reload once control returns to the event loop
+    *
+    * Several changes in a row, e.g. a flush of many edits, cause one reload.
+    */
+   void invalidate();
+
+private slots:
+   /** @brief Patch the rows changed in the database
+    */
+   void changed(const CChanges &changes);
+
+private:
+   typedef QVector< QPair<qint64, QString> > Rows;
+
+   QString m_table;
+   QString m_prefix;
+   Rows m_rows;
+   QHash<qint64, int> m_index;
+   bool m_atEnd=false;
+   bool m_pending=false;
+
+   /** @brief Read the page after the last row read so far
+    */
+   Rows readPage();
+   void append(const Rows &rows);
+
+   /** @brief Name of record 'id' from the database; null if there is none
+    */
+   QVariant readName(qint64 id) const;
+
+   /** @brief Move, add or remove the row of 'change'
+    */
+   void patch(const CChange &change);
+   void reindex();
+};
+
+
+/** @brief Process wide cache of lookup models
+ *
+ * Every combo box of a foreign key referencing the same table shares one
+ * model, no matter in how many columns and tabs it is used. Its first page
+ * is read when it is requested the first time; the model is released with
+ * its last user. The models follow the changes of their table, so all combo
+ * boxes listing it show them.
+ */
+class CRelationCache
+{
+public:
+   /** @brief Shared model of 'table'; keep the pointer as long as it is used
+    */
+   static QSharedPointer<CLookupModel> model(const QString &table);
+
+   /** @brief Table 'table' was changed in an unknown way; reload its model
+    *         if it is in use
+    */
+   static void invalidate(const QString &table);
+
+   /** @brief Number of models in use, for diagnostics
+    */
+   static int count();
+
+private:
+   static QHash< QString, QWeakPointer<CLookupModel> > &models();
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_RELATIONCACHE_HPP
@@ -0,0 +1,84 @@
+#ifndef WAREHOUSE_RELATIONCOMBO_HPP
+#define WAREHOUSE_RELATIONCOMBO_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       relationcombo.hpp
+ * @brief      Combo box editing a foreign key by the Name of the record
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QComboBox>
+#include <QCompleter>
+#include <QSharedPointer>
+#include <QVariant>
+
+#include "relationcache.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Combo box showing the Names of a shared lookup model
+ *
+ * The form model holds the plain id of the foreign key. 'currentId' is the
+ * user property, so QDataWidgetMapper reads and writes the id while the
+ * Name is shown. The id survives reloads of the lookup model.
+ *
+ * The popup lists the shared model page by page while scrolling. Typing
+ * asks a completer model of its own for Names starting with the text, one
+ * page at a time; it is created on the first key and dropped when the text
+ * is cleared, so combo boxes nobody types into do not follow changes. The Name of the current id is resolved by point lookup,
+ * so it does not have to be among the rows read.
+ */
+class CRelationCombo : public QComboBox
+{
+   Q_OBJECT
+   Q_PROPERTY(QVariant currentId READ currentId WRITE setCurrentId USER true)
+
+public:
+   explicit CRelationCombo(QWidget *parent = nullptr);
+
+   /** @brief Show the rows of the lookup model 'lookup'
+    */
+   void setLookup(const QSharedPointer<CLookupModel> &lookup);
+
+   /** @brief Drop lookup model and id, e.g. before the combo box is reused
+    */
+   void reset();
+
+   QVariant currentId() const { return(m_currentId); }
+   void setCurrentId(const QVariant &id);
+
+signals:
+   /** @brief The user selected another record
+    */
+   void currentIdEdited(const QVariant &id);
+
+protected:
+   void focusOutEvent(QFocusEvent *event) override;
+
+private:
+   QSharedPointer<CLookupModel> m_lookup;
+   CLookupModel *m_matches=nullptr;
+   QCompleter *m_completer=nullptr;
+   QVariant m_currentId;
+
+   void select();
+   void choose(const QVariant &id);
+   void createMatches();
+   void dropMatches();
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_RELATIONCOMBO_HPP
@@ -0,0 +1,115 @@
+#ifndef WAREHOUSE_ROWCOUNTER_HPP
+#define WAREHOUSE_ROWCOUNTER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       rowcounter.hpp
+ * @brief      Numbers of rows, counted once and kept up to date
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+
+#include "changefeed.hpp"
+#include "rowmodel.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Process wide counters of rows
+ *
+ * The rows of a table are counted once on the worker pool; afterwards the
+ * inserted and deleted rows reported by CChangeFeed are added and
+ * subtracted, so asking costs nothing. Tables changed in an unknown way are
+ * counted again; without the update hook these are all tables written.
+ * Rows changed while counting may be missed by the count; its number is
+ * shown anyway and the table is counted again after 'RecountMsecs', so
+ * steady writes do not keep a worker counting.
+ * Asking for the number never starts counting, 'request()' does.
+ * The numbers of rows of the latest searches are kept until any table
+ * changes, so going back to a search does not count again.
+ */
+class CRowCounter : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum
+   {
+      /** @brief Searches whose number of rows is kept */
+      MaxQueries=64,
+      /** @brief Wait before counting a table changed while counting */
+      RecountMsecs=1000,
+   };
+
+   static CRowCounter *instance();
+
+   /** @brief Rows of 'table'; -1 if not known yet
+    */
+   static qint64 count(const QString &table);
+
+   /** @brief Count 'table' unless the number is known; 'counted()' follows
+    */
+   static void request(const QString &table);
+
+   /** @brief Count 'table' again, e.g. on reload; 'counted()' follows
+    */
+   static void recount(const QString &table);
+
+   /** @brief 'table' is being counted, 'counted()' follows
+    */
+   static bool isCounting(const QString &table);
+
+   /** @brief Number of rows of 'query' if known; -1 otherwise
+    *
+    * Thread safe. 'generation' is needed to remember the number counted.
+    */
+   static qint64 cached(const CRowQuery &query, int *generation);
+
+   /** @brief Keep 'count' of 'query' unless tables changed since 'cached()'
+    */
+   static void remember(const CRowQuery &query, qint64 count, int generation);
+
+signals:
+   /** @brief Number of rows of 'table' is known or changed
+    */
+   void counted(const QString &table, qint64 count);
+
+private slots:
+   void changed(const CChanges &changes);
+
+private:
+   struct Entry
+   {
+      qint64 count=-1;
+      bool counting=false;
+      /** @brief Changed while counting; count again */
+      bool stale=false;
+      /** @brief 'recount()' while counting; count again at once */
+      bool again=false;
+      /** @brief Counting again after 'RecountMsecs' */
+      bool waiting=false;
+   };
+
+   QHash<QString, Entry> m_tables;
+
+   explicit CRowCounter(QObject *parent = nullptr);
+   void start(const QString &table);
+   void finished(const QString &table, qint64 count);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_ROWCOUNTER_HPP
@@ -0,0 +1,262 @@
+#ifndef WAREHOUSE_ROWMODEL_HPP
+#define WAREHOUSE_ROWMODEL_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       rowmodel.hpp
+ * @brief      Read only model of the rows listed at the left of a tab
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QString>
+#include <QVariant>
+#include <QCache>
+#include <QSet>
+#include <QPair>
+#include <QSqlQuery>
+
+#include <queryprofiler.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief One row of the list, just enough to show and identify it
+ */
+struct CRow
+{
+   qint64 id;
+   QString name;
+   /** @brief Value of the sort key, needed to continue after this row */
+   QVariant key;
+};
+
+typedef QVector<CRow> CRows;
+
+
+/** @brief Query listing the rows of a tab
+ *
+ * Rows are ordered by 'key' and the id. Pages are read with a keyset
+ * condition '(key, id) > (last key, last id)', so reading a page costs the
+ * same no matter how far down the list it is.
+ * Row values can not compare NULL keys, which SQLite sorts first. Rows
+ * after a NULL key, or the NULL keys behind the others in descending
+ * order, are read by the ranges 'AfterNull', 'Null' and 'NotNull', each of
+ * them an index range as well.
+ */
+struct CRowQuery
+{
+   /** @brief Rows of a statement besides 'where'; see 'rangeStatement()'
+    */
+   enum Range
+   {
+      All,
+      /** @brief After key and id bound, in the direction of reading */
+      After,
+      /** @brief Key NULL and after the id bound */
+      AfterNull,
+      Null,
+      NotNull,
+      /** @brief Key less than the value bound */
+      Less,
+      /** @brief Key not less than the value bound */
+      NotLess,
+   };
+
+   /** @brief Table and joins, e.g. '"Parts" JOIN "Location" r0 ON ...' */
+   QString from;
+   /** @brief WHERE expression; empty for all rows */
+   QString where;
+   /** @brief Sort key; empty to sort by id only */
+   QString key;
+   /** @brief Sorted from the largest key and id */
+   bool descending=false;
+   /** @brief Qualified id and name columns */
+   QString id;
+   QString name;
+   /** @brief Values bound to the placeholders in 'from' and 'where' */
+   QVariantList values;
+   /** @brief Table of the rows, for the query statistics */
+   QString table;
+   /** @brief Number of rows if known, e.g. all rows of the table; -1 to count */
+   qint64 count=-1;
+
+   QString countStatement() const;
+
+   /** @brief Read a page; with 'after' the last key and id have to be bound
+    */
+   QString pageStatement(bool after, int limit) const;
+
+   /** @brief Read the rows of 'range'; backwards with 'reverse'
+    *
+    * The values of 'range' are bound after 'values', then limit and offset.
+    */
+   QString rangeStatement(Range range, bool reverse) const;
+
+   /** @brief Count the rows of 'range'
+    */
+   QString rangeCountStatement(Range range, bool reverse) const;
+
+   /** @brief Read one row if it is part of the result; the id is bound last
+    */
+   QString rowStatement() const;
+};
+
+
+/** @brief Model holding a window of the result of the latest search
+ *
+ * Only the pages near the visible part are kept in a LRU cache. The number
+ * of rows is counted once per query by the search worker, which also
+ * delivers the first page.
+ */
+class CRowModel : public QAbstractTableModel
+{
+   Q_OBJECT
+
+public:
+   enum Column
+   {
+      ColumnId,
+      ColumnName,
+      ColumnCount
+   };
+
+   enum
+   {
+      /** @brief Rows per page */
+      PageSize=256
+   };
+
+   explicit CRowModel(QObject *parent = nullptr);
+
+   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+   QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+   QVariant headerData(int section, Qt::Orientation orientation
+                       , int role = Qt::DisplayRole) const override;
+
+   /** @brief Maximum number of pages kept in memory
+    */
+   void setMaxPages(int pages);
+
+   /** @brief Show the result of 'query'
+    */
+   void setQuery(const CRowQuery &query, int count, const CRows &firstPage);
+   const CRowQuery &query() const { return(m_query); }
+
+   /** @brief id of 'row' or -1 if out of range
+    */
+   qint64 rowId(int row) const;
+
+   /** @brief Row showing 'id' or -1 if not in one of the cached pages
+    */
+   int rowOf(qint64 id) const;
+
+   /** @brief Update the name after the record was edited
+    *
+    * Sorted by Name the row moves, so the pages are read again.
+    */
+   void setName(qint64 id, const QString &name);
+
+   /** @brief Read row 'id' as listed; false if it is not part of the result
+    */
+   bool fetch(qint64 id, CRow *data) const;
+
+   /** @brief Row at which 'data' is listed in the order of the query
+    *
+    * Counted in the index, the rows before are not read. -1 on errors.
+    */
+   int position(const CRow &data) const;
+
+   /** @brief Drop the pages read, e.g. after rows were written behind
+    */
+   void invalidate();
+
+   /** @brief Show rows 'ids' bold, e.g. because of unsaved edits
+    */
+   void setMarked(const QSet<qint64> &ids);
+
+   /** @brief Insert a row without reading the query again
+    *
+    * Only the pages from 'row' on are read again when needed.
+    */
+   void insertRowAt(int row, const CRow &data);
+
+   /** @brief Remove a row without reading the query again
+    */
+   void removeRowAt(int row);
+
+   /** @brief Row of the first Name starting with 'prefix'
+    *
+    * Only if sorted by Name; counts and seeks in the index of the Names
+    * instead of reading the rows before. -1 if not sorted by Name or no
+    * Name starts with 'prefix'. Compares binary like the index, so it is
+    * case sensitive.
+    */
+   int seek(const QString &prefix) const;
+
+   /** @brief Rows starting with the text typed into the view
+    *
+    * The first ones at or after 'start', from the first row again with
+    * 'Qt::MatchWrap'; case sensitive like 'seek()'. Sorted by Name by
+    * 'seek()', which finds one row; otherwise only the rows read are
+    * searched.
+    */
+   QModelIndexList match(const QModelIndex &start, int role, const QVariant &value
+                         , int hits = 1
+                         , Qt::MatchFlags flags = Qt::MatchFlags(Qt::MatchStartsWith|Qt::MatchWrap)) const override;
+
+private:
+   struct Bound
+   {
+      bool valid=false;
+      QVariant key;
+      qint64 id=0;
+   };
+
+   CRowQuery m_query;
+   int m_count=0;
+   QSet<qint64> m_marked;
+   mutable QCache<int, CRows> m_pages;
+   /** @brief Last key of the page before; index 0 is always valid */
+   mutable QVector<Bound> m_bounds;
+
+   const CRow *row(int row) const;
+   CRows *page(int page) const;
+   bool bound(int page) const;
+
+   /** @brief Append up to 'limit' rows of 'range' after skipping 'offset'
+    */
+   bool read(CRowQuery::Range range, const QVariantList &bound, bool reverse
+             , int offset, int limit, CRows *rows) const;
+   qint64 countRange(CRowQuery::Range range, const QVariantList &bound, bool reverse) const;
+
+   /** @brief Ranges of the rows following 'from', in the order of walking
+    */
+   QVector<QPair<CRowQuery::Range, QVariantList>> ranges(const Bound &from
+                                                         , bool reverse) const;
+
+   /** @brief Append up to 'limit' rows following 'from', skipping 'offset'
+    *
+    * Backwards with 'reverse'; from the start or end if 'from' is not valid.
+    */
+   bool walk(const Bound &from, bool reverse, int offset, int limit, CRows *rows) const;
+   CQueryProfiler::Kind kind() const;
+   void remember(int page, const CRows &rows) const;
+   void forget(int page);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_ROWMODEL_HPP
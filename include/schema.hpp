@@ -0,0 +1,145 @@
+#ifndef WAREHOUSE_SCHEMA_HPP
+#define WAREHOUSE_SCHEMA_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       schema.hpp
+ * @brief      Catalog of tables and columns, read once per schema version
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QVariant>
+#include <QSqlRecord>
+#include <QSqlDatabase>
+#include <QSharedPointer>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief One column and what the naming conventions say about it
+ */
+struct CColumnInfo
+{
+   QString name;
+   /** @brief Text of the label in the form; the name up to the first '_' */
+   QString label;
+   QVariant::Type type=QVariant::Invalid;
+   /** @brief Referenced table for '<Table>_id_<Column>'; empty otherwise
+    *
+    * In a workspace it may be a table of another file, see CSchema.
+    */
+   QString foreignTable;
+   bool multiLine=false;
+
+   bool isForeignKey() const { return(!foreignTable.isEmpty()); }
+};
+
+
+/** @brief Columns of one table in the order of the table
+ */
+struct CTableInfo
+{
+   QString name;
+   /** @brief Text of the CREATE statement, to see if the table changed */
+   QString sql;
+   /** @brief Empty record, e.g. for inserting */
+   QSqlRecord record;
+   QVector<CColumnInfo> columns;
+   QHash<QString, int> indexes;
+
+   /** @brief Position of column 'name'; -1 if there is none
+    */
+   int indexOf(const QString &name) const { return(indexes.value(name, -1)); }
+   bool contains(const QString &name) const { return(indexes.contains(name)); }
+};
+
+typedef QSharedPointer<const CTableInfo> CTableInfoPtr;
+
+
+/** @brief Catalog of all tables of the database
+ *
+ * The descriptors are built when the database is opened and are not changed
+ * afterwards, so every tab, the search index and the advisor share them.
+ * 'refresh()' compares 'PRAGMA schema_version' and reads the catalog again
+ * if it changed, e.g. after creating a search index; tables whose CREATE
+ * statement is the same keep their descriptor.
+ * Tables of attached databases are named '<schema>.<table>', which SQLite
+ * and the Qt driver accept wherever a table name is expected. A foreign key
+ * '<Table>_id_<Column>' refers to 'Table' of the same file if it has one,
+ * otherwise to the one of the main file or of the first attached file
+ * having it, so e.g. the files of several sites can share one 'Categories'.
+ * The catalog is used from the GUI thread only.
+ */
+class CSchema
+{
+public:
+   /** @brief Read all tables of 'db'
+    */
+   static bool load(const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Read the catalog again if the schema version changed
+    *
+    * @return true if the catalog was read again
+    */
+   static bool refresh();
+
+   /** @brief Names of all tables in the order of the database
+    */
+   static QStringList tables();
+
+   /** @brief 'main' and the names of the attached databases
+    */
+   static QStringList schemas();
+
+   /** @brief Schema of 'table'; 'main' for tables without one
+    */
+   static QString schemaOf(const QString &table);
+
+   /** @brief 'table' without schema, e.g. for statements that do not allow one
+    */
+   static QString baseName(const QString &table);
+
+   /** @brief Statement 'PRAGMA <schema>.<pragma>(<table>)'
+    */
+   static QString pragma(const QString &pragma, const QString &table);
+
+   /** @brief Descriptor of 'table'; null if there is no such table
+    */
+   static CTableInfoPtr table(const QString &table);
+
+   /** @brief Naming convention '<Table>_id_<Column>' of foreign keys
+    */
+   static bool isForeignKey(const QString &name);
+   static QString foreignKeyTable(const QString &name);
+
+   /** @brief Columns edited in a multi line widget
+    */
+   static bool isMultiLine(const QString &name);
+
+private:
+   static QString schemaVersion(const QSqlDatabase &db);
+   static QString resolve(const QString &foreignTable, const QString &schema
+                          , const QSet<QString> &tables);
+   static bool isResolved(const CTableInfoPtr &info, const QSet<QString> &tables);
+   static CTableInfoPtr readTable(const QSqlDatabase &db, const QString &table
+                                  , const QString &sql, const QSet<QString> &tables);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_SCHEMA_HPP
@@ -0,0 +1,122 @@
+#ifndef WAREHOUSE_SEARCHINDEX_HPP
+#define WAREHOUSE_SEARCHINDEX_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       searchindex.hpp
+ * @brief      Optional FTS5 full text index behind the search box of a tab
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Parameterized part of a search query
+ *
+ * The values are bound in order of their placeholders, first in 'join', then
+ * in 'where'.
+ */
+struct CSearchClause
+{
+   /** @brief Additional join, e.g. the full text match */
+   QString join;
+   /** @brief WHERE expression; empty for all rows */
+   QString where;
+   /** @brief ORDER BY expression; empty for id order */
+   QString order;
+   QVariantList values;
+};
+
+
+/** @brief Full text index for one table
+ *
+ * The index is an external content FTS5 table named '<table>__fts' which is
+ * kept in sync by triggers on the table itself. So also other programs
+ * writing the database update the index.
+ * When FTS5 is not compiled into SQLite or the index is disabled, the search
+ * falls back to LIKE over all columns.
+ */
+class CSearchIndex
+{
+public:
+   explicit CSearchIndex(const QString &table);
+
+   /** @brief Globally enable maintaining the index, e.g. from command line
+    */
+   static void setEnabled(bool enabled);
+   static bool isEnabled();
+
+   /** @brief Check if SQLite supports FTS5
+    */
+   static bool isAvailable();
+
+   /** @brief Check if 'table' is one of the tables created for an index
+    *
+    * Only the indexes found by 'readIndexes()' or opened are known. Thread
+    * safe, also called by the update hook.
+    */
+   static bool isIndexTable(const QString &table);
+
+   /** @brief Note the FTS5 tables of all files; after CSchema::load()
+    */
+   static void readIndexes(const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Create the index or recreate it when the columns changed
+    *
+    * @return true if the index can be used for searching
+    */
+   bool open();
+   bool isActive() const { return(m_active); }
+
+   /** @brief Clause selecting the rows matching 'line'
+    */
+   CSearchClause clause(const QString &line) const;
+
+   /** @brief Clause selecting the row with id 'line'
+    */
+   CSearchClause idClause(const QString &line) const;
+
+   /** @brief Quote a string as SQL literal using the driver
+    */
+   static QString literal(const QString &value);
+
+   /** @brief Smallest text after all texts starting with 'prefix'
+    *
+    * 'Name >= prefix AND Name < end' are the texts starting with 'prefix' in
+    * the binary order of an index, i.e. the order of the UTF-8 bytes. Unlike
+    * 'LIKE prefix%' it is case sensitive. Empty if there is no such text,
+    * i.e. all following texts start with 'prefix'.
+    */
+   static QString prefixEnd(const QString &prefix);
+
+private:
+   QString m_table;
+   QString m_index;
+   QStringList m_columns;
+   bool m_active=false;
+
+   void readColumns();
+   QString createStatement() const;
+   bool create();
+   void drop();
+   QString matchExpression(const QString &line) const;
+   CSearchClause likeClause(const QString &line) const;
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_SEARCHINDEX_HPP
@@ -0,0 +1,88 @@
+#ifndef WAREHOUSE_SEARCHSCHEDULER_HPP
+#define WAREHOUSE_SEARCHSCHEDULER_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       searchscheduler.hpp
+ * @brief      Debounced searching on a worker thread
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+#include "rowmodel.hpp"
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Runs the search queries of a tab without blocking the GUI
+ *
+ * Requests are collected for the debounce time, so typing a word results in
+ * a single query. The query is executed by CWorkerPool, so the searches of
+ * several tabs run at the same time. Every request gets a new generation
+ * number; outdated results are dropped. A running count or page is
+ * interrupted every 'ProgressSteps' SQLite instructions once it is outdated.
+ * If Qt uses another SQLite than warehouse, see CConnection::handle(), it
+ * stops after the running statement.
+ */
+class CSearchScheduler : public QObject
+{
+   Q_OBJECT
+
+public:
+   enum
+   {
+      /** @brief SQLite instructions between checks for a newer request */
+      ProgressSteps=10000,
+   };
+
+   explicit CSearchScheduler(QObject *parent = nullptr);
+   ~CSearchScheduler();
+
+   /** @brief Set debounce time for all schedulers, e.g. from command line
+    */
+   static void setDebounce(int msec);
+   static int debounce();
+
+   /** @brief Queue a query; replaces a not yet started one
+    */
+   void schedule(const CRowQuery &query);
+
+   /** @brief Start the queued query immediately
+    */
+   void flush();
+
+   /** @brief Drop the queued query and outdate a running one
+    */
+   void cancel();
+
+signals:
+   /** @brief Number of rows and first page of the latest query
+    */
+   void resultReady(const CRowQuery &query, int count, const CRows &firstPage);
+   void searchFailed(const QString &error);
+
+private:
+   QTimer m_timer;
+   CRowQuery m_query;
+   QSharedPointer<QAtomicInt> m_generation;
+
+   void start();
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_SEARCHSCHEDULER_HPP
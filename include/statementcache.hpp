@@ -0,0 +1,63 @@
+#ifndef WAREHOUSE_STATEMENTCACHE_HPP
+#define WAREHOUSE_STATEMENTCACHE_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       statementcache.hpp
+ * @brief      Cache of prepared statements per connection
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QSharedPointer>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Keeps statements prepared which are issued over and over
+ *
+ * Preparing costs parsing and planning in SQLite each time. Statements are
+ * kept per thread and connection, as a connection and its queries may only
+ * be used by the thread which opened it; no lock is needed. The returned
+ * query is the one of the cache unless that one is still active, e.g. when
+ * the same statement is used while iterating over it; then a new one is
+ * prepared. It has to be 'finish()'ed after use, so the statement does not
+ * keep the read transaction open.
+ * A connection has to be removed from the cache before it is closed, by the
+ * thread which used it.
+ */
+class CStatementCache
+{
+public:
+   enum
+   {
+      /** @brief Statements kept per connection */
+      MaxStatements=256,
+   };
+
+   /** @brief Get statement 'sql' prepared for 'db'
+    */
+   static QSharedPointer<QSqlQuery> prepare(const QString &sql
+                            , const QSqlDatabase &db=QSqlDatabase::database());
+
+   /** @brief Drop the statements of connection 'connectionName' kept by the
+    *         calling thread
+    */
+   static void clear(const QString &connectionName);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_STATEMENTCACHE_HPP
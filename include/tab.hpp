@@ -18,12 +18,23 @@
 
 
 #include <QWidget>
-#include <QSqlRelationalTableModel>
+#include <QSqlTableModel>
 #include <QGroupBox>
 #include <QTableView>
 #include <QGridLayout>
 #include <QDataWidgetMapper>
 #include <QItemDelegate>
+#include <QScrollArea>
+#include <QTimer>
+
+#include "reconcile.hpp"
+#include "searchindex.hpp"
+#include "searchscheduler.hpp"
+#include "rowmodel.hpp"
+#include "editbuffer.hpp"
+#include "formmodel.hpp"
+#include "schema.hpp"
+#include "changefeed.hpp"
 
 
 /*--- Declaration ----------------------------------------------------------*/
@@ -38,16 +49,54 @@ class CWarehouseTab : public QWidget
    Q_OBJECT
 
 public:
+   enum
+   {
+      /** @brief Changed rows patched one by one; beyond the list is read again */
+      MaxPatches=64,
+      /** @brief Rows of the form built at once when scrolling */
+      FormularChunk=16,
+      /** @brief Widgets of a hidden form are given back after this time */
+      ReleaseDelay=60000,
+   };
+
    explicit CWarehouseTab(const QString &table, QWidget *parent = nullptr);
    ~CWarehouseTab();
+
+   /** @brief Create model, form and counts; done on first show
+    */
+   void build();
+   bool isBuilt() const { return(m_built); }
+
+   const QString &table() const { return(m_table); }
+
+   /** @brief Search as if 'text' was typed; used before building too
+    */
+   void setSearchText(const QString &text);
+
+   /** @brief Read counters and list again after rows were changed outside
+    */
+   void reload();
+
+   /** @brief Load record 'id' into the form
+    */
+   bool showRecord(qint64 id);
    int adjustCWarehouseTable();
    void buildFormular(QGroupBox *groupBox
-            , QSqlRelationalTableModel *model, QTableView *CWarehouseTable);
+            , QSqlTableModel *model, QTableView *CWarehouseTable);
    
    /** @bried Show error in dialog box
     */
    void showError(const QSqlError &err);
 
+signals:
+   /** @brief The list shows the result of the latest search
+    */
+   void listed();
+
+   /** @brief The counters of the latest pass are shown
+    */
+   void counted();
+
 private slots:
    
    /** @bried Slot for signal when Add/'+' was pressed
@@ -60,27 +109,119 @@ private slots:
    void searchChanged( const QString &line );
    void searchChangedId(const QString &line);
 
+   /** @brief Slot for the result of the latest search
+    */
+   void resultReady(const CRowQuery &query, int count, const CRows &firstPage);
+   void currentRowChanged(const QModelIndex &current);
+
+   /** @brief Select the current record again after the rows moved
+    */
+   void keepCurrentRow();
+
+   /** @bried Slot for signal when a field of the record was edited
+    */
+   void recordChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+   /** @brief Patch list, counts and record with the rows written elsewhere
+    */
+   void changed(const CChanges &changes);
+
+   /** @brief Total of 'table' is known or changed
+    */
+   void totalCounted(const QString &table);
+
+   /** @brief Header of the list was clicked; sort by that column
+    */
+   void sortChanged(int section, Qt::SortOrder order);
+   void dirtyChanged(bool dirty);
+   void revertPressed();
+
+   /** @brief Build the rows of the form up to one screen below the visible
+    */
+   void growFormular();
+
+   /** @brief Give the widgets of the form back to CWidgetPool
+    */
+   void releaseFormular();
+
+protected:
+   void showEvent(QShowEvent *event) override;
+   void hideEvent(QHideEvent *event) override;
+   bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
    Ui::Tab *ui;
-   QSqlRelationalTableModel *model;
+   bool m_built=false;
+   CFormModel *model=nullptr;
    QString m_table;
+   CTableInfoPtr m_schema;
    QDataWidgetMapper *m_mapper;
    QGridLayout *m_gridLayout;
+   QScrollArea *m_scrollArea=nullptr;
+   /** @brief Rows of the form built so far; the first ones */
+   int m_formularRows=0;
+   QTimer m_releaseTimer;
+   CReconciler m_reconciler;
+   CSearchIndex m_searchIndex;
+   CSearchScheduler m_search;
+   CSearchClause m_clause;
+   /** @brief Column of the list sorted by; -1 for the order of the search */
+   int m_sortColumn=-1;
+   Qt::SortOrder m_sortOrder=Qt::AscendingOrder;
+   CReconcileReport m_report;
+   /** @brief A count runs on a worker; only the latest generation is used */
+   bool m_reconciling=false;
+   int m_reconcileGeneration=0;
+   CRowModel *m_rows;
+   qint64 m_currentId=-1;
+   int m_currentRow=0;
+   CEditBuffer *m_edits=nullptr;
+   /** @brief Edits are written by CWriteQueue */
+   bool m_writeBehind=false;
+   /** @brief Values queued per row and not committed yet */
+   QHash<qint64, QHash<QString, QVariant>> m_pending;
+   /** @brief Inserts queued; the record shown is not the new one yet */
+   int m_pendingInserts=0;
+   bool m_loading=false;
    
    
    /** @bried Create an Qt widget depending on the data type of 'field'
     */
-   QWidget *createFormularWidget(QGroupBox *groupBox
-                              , QSqlField &field, QModelIndex &index ) const;
-   bool isForeignKey(const QString &name) const;
-   QString foreignKeyTable(const QString &name) const;
+   QWidget *createFormularWidget(QWidget *parent, const CColumnInfo &column) const;
+
+   /** @brief Label and editor of column 'row', mapped to the record
+    */
+   void buildRow(int row);
    void updateCount() const;
-   bool isMultiLine(const QString &name) const;
+
+   /** @brief Queue the edited columns 'first' to 'last' of the record
+    */
+   void writeBehind(int first, int last);
+   void reconcile();
+   void showReport();
+
+   /** @brief Add row 'id' to list and counters without reading all again
+    *
+    * With 'select' it becomes the current row, as after pressing Add.
+    */
+   void rowInserted(qint64 id, bool select);
+
+   /** @brief Remove row 'id' from list and counters
+    */
+   void rowRemoved(qint64 id);
+
+   /** @brief Show the current Name of row 'id'
+    */
+   void rowUpdated(qint64 id);
    void updateRelation();
 
-public:
-   void dump();
+   /** @brief Run the current search again, e.g. after add/remove
+    */
+   void refresh(bool immediate);
 
+   /** @brief Mark fields and rows with edits which are not written yet
+    */
+   void markDirty();
 };
 
 
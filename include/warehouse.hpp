@@ -22,6 +22,10 @@
 
 #include "ui_warehouse.h"
 
+class CWarehouseTab;
+class CWorkspaceSearch;
+struct CImportReport;
+
 
 /*--- Declaration ----------------------------------------------------------*/
 
@@ -32,28 +36,82 @@ class CWarehouse: public QMainWindow
 {
     Q_OBJECT
 public:
-    CWarehouse(const QString &databaseFile);
+    /** @brief Open the first file; the others are attached as workspace
+     */
+    CWarehouse(const QStringList &databaseFiles);
+
+    /** @brief Time since start of the application, for startup metrics
+     */
+    static QElapsedTimer &startupTimer();
+
+    /** @brief Build the tab next to the current one when idle
+     */
+    void setPrefetch(bool prefetch);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+    /** @brief Input of the user postpones prefetching
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
     
 private:
     /** @brief initializes the database by loading file
      */
-    QSqlError initDb(const QString &databaseFile) const;
+    QSqlError initDb(const QStringList &databaseFiles) const;
+
+    /** @brief Tabs of the current file; all tabs without workspace
+     */
+    QTabWidget *currentGroup() const;
         
 private slots:
     /** @brief Show the "About"-Window
      */
     void about();
 
+    /** @brief Build the tab which will likely be shown next
+     */
+    void prefetch();
+
+    /** @brief Ask for a file and insert its rows into a table
+     */
+    void importFile();
+
+    /** @brief Search the table of the current tab in all files
+     */
+    void searchWorkspace(const QString &text);
+
+    /** @brief Show record 'id' of a workspace search in the tab of 'table'
+     */
+    void showFound(const QString &table, qint64 id);
+
+    /** @brief Show the number of rows of 'table' in the title of its tab
+     */
+    void totalCounted(const QString &table, qint64 count);
+
 private:
+    enum
+    {
+       /** @brief Prefetching starts after this time without input */
+       PrefetchQuiet=500,
+    };
+
     void showError(const QSqlError &err);
     void fillFormular(QGroupBox *groupBox, QSqlRelationalTableModel *model, QTableView *table);
     Ui::Warehouse ui;
-    void addTab(const QString &table);
+    void addTab(QTabWidget *group, const QString &table);
 
     void createMenuBar();
+    /** @brief Tell the user how the import into 'table' went
+     */
+    void showImportReport(const QString &table, const CImportReport &report);
 
-public:
-    void dump(const QString name);
+    QList<CWarehouseTab *> m_tabs;
+    QHash<CWarehouseTab *, QTabWidget *> m_groups;
+    CWorkspaceSearch *m_workspaceSearch=nullptr;
+    QTimer m_prefetchTimer;
+    bool m_prefetch=true;
+    bool m_painted=false;
 };
 
 
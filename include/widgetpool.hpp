@@ -0,0 +1,63 @@
+#ifndef WAREHOUSE_WIDGETPOOL_HPP
+#define WAREHOUSE_WIDGETPOOL_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       widgetpool.hpp
+ * @brief      Form widgets kept for reuse by other tabs
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QWidget>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Process wide pool of labels and editors of the forms
+ *
+ * A tab gives back the widgets of its form when it is closed or was hidden
+ * for a while; the next form takes them instead of creating new ones. The
+ * widgets are emptied when given back, the taker sets all other
+ * properties. Only used by the GUI thread.
+ */
+class CWidgetPool
+{
+public:
+   enum Kind
+   {
+      Label,
+      LineEdit,
+      SpinBox,
+      TextEdit,
+      RelationCombo,
+      Kinds,
+   };
+
+   enum
+   {
+      /** @brief Widgets kept per kind; more are deleted */
+      MaxWidgets=256,
+   };
+
+   /** @brief Widget of 'kind' with parent 'parent'; created if none is kept
+    */
+   static QWidget *take(Kind kind, QWidget *parent);
+
+   /** @brief Keep 'widget' for reuse; it must have been taken by 'take()'
+    */
+   static void release(QWidget *widget);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_WIDGETPOOL_HPP
@@ -0,0 +1,67 @@
+#ifndef WAREHOUSE_WORKERPOOL_HPP
+#define WAREHOUSE_WORKERPOOL_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       workerpool.hpp
+ * @brief      Threads reading the database, each with its own connection
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QSqlDatabase>
+#include <QThreadPool>
+#include <functional>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Pool of threads for the queries of all tabs
+ *
+ * Every thread opens its own connection on first use and keeps it until the
+ * application quits, so the queries of several tabs run at the same time.
+ * SQLite allows concurrent readers; in WAL mode (profiles 'read', 'write'
+ * and 'safe') also while another connection writes.
+ * Jobs must not touch widgets or the default connection. SQL text has to be
+ * built before, e.g. identifiers are escaped with the default connection.
+ * Queries are local to the job, so none of them outlives the connection.
+ */
+class CWorkerPool
+{
+public:
+   /** @brief Set the number of threads, e.g. from command line; 0 for one
+    *         per core
+    */
+   static void setThreads(int threads);
+   static int threads();
+
+   /** @brief Run 'job' on a worker with the connection of that worker
+    */
+   static void start(const std::function<void(const QSqlDatabase &db)> &job);
+
+   /** @brief No job is running or waiting
+    */
+   static bool isIdle();
+
+   /** @brief Wait for all jobs and close the connections of the workers
+    *
+    * Done when the application quits; 'start()' creates a new pool.
+    */
+   static void shutdown();
+
+private:
+   static QThreadPool *pool();
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_WORKERPOOL_HPP
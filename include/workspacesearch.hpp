@@ -0,0 +1,70 @@
+#ifndef WAREHOUSE_WORKSPACESEARCH_HPP
+#define WAREHOUSE_WORKSPACESEARCH_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       workspacesearch.hpp
+ * @brief      Dock showing the search results of all files of a workspace
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QDockWidget>
+#include <QTreeWidget>
+#include <QHash>
+#include <QStringList>
+
+#include <searchscheduler.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Results of one search in the tables of the same name of all files
+ *
+ * Every table gets a CSearchScheduler, so typing is debounced and the
+ * queries of the files run at the same time on the worker pool; no tab is
+ * built for it. The files are listed with their number of matches and the
+ * first page of matching Names, in the order of the tables given.
+ */
+class CWorkspaceSearch : public QDockWidget
+{
+   Q_OBJECT
+
+public:
+   explicit CWorkspaceSearch(QWidget *parent = nullptr);
+
+   /** @brief Search 'text' in 'tables'; an empty text clears the results
+    */
+   void search(const QStringList &tables, const QString &text);
+
+   const QString &text() const { return(m_text); }
+
+signals:
+   /** @brief A row of the results was activated
+    */
+   void activated(const QString &table, qint64 id);
+
+private slots:
+   void resultReady(const CRowQuery &query, int count, const CRows &firstPage);
+
+private:
+   QTreeWidget *m_results;
+   QString m_text;
+   QStringList m_tables;
+   QHash<QString, CSearchScheduler *> m_schedulers;
+
+   QTreeWidgetItem *item(const QString &table);
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_WORKSPACESEARCH_HPP
@@ -0,0 +1,97 @@
+#ifndef WAREHOUSE_WRITEQUEUE_HPP
+#define WAREHOUSE_WRITEQUEUE_HPP
+/**---------------------------------------------------------------------------
+ *
+ * @file       writequeue.hpp
+ * @brief      Writes of the tabs, committed in groups by a thread of its own
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QVariant>
+#include <QSqlDatabase>
+#include <functional>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Write-behind queue with group commit
+ *
+ * Inserts, updates and deletes are pushed onto a lock free stack by the GUI
+ * thread and return at once. A writer thread with a connection of its own
+ * takes all writes queued so far and executes them in one transaction, so
+ * the sync to disk is paid once per group; writes queued meanwhile form the
+ * next group. Every write has a savepoint, a failing one does not roll back
+ * the others. Completion and errors are reported to the GUI thread after
+ * the commit, unless the receiver was deleted meanwhile.
+ * The statements are prepared once per text and kept by the writer.
+ * The update hook of CChangeFeed is installed on the writer connection and
+ * its 'PRAGMA data_version' is polled instead of the one of the default
+ * connection, which changes with every commit of the writer.
+ */
+class CWriteQueue
+{
+public:
+   enum
+   {
+      /** @brief Prepared statements kept by the writer */
+      MaxStatements=128,
+   };
+
+   /** @brief Called in the GUI thread; 'id' of the row, 'error' empty if ok
+    */
+   typedef std::function<void(qint64 id, const QString &error)> Callback;
+
+   /** @brief Globally enable writing behind, e.g. from command line
+    */
+   static void setEnabled(bool enabled);
+   static bool isEnabled();
+
+   /** @brief The writer thread is running
+    */
+   static bool isRunning();
+
+   /** @brief Start the writer thread; stopped when the application quits
+    */
+   static void start();
+
+   /** @brief Insert a row of 'values' into 'table'
+    */
+   static void insert(const QString &table, const QHash<QString, QVariant> &values
+                      , const void *origin, QObject *receiver, const Callback &done);
+
+   /** @brief Set 'values' of row 'id'
+    */
+   static void update(const QString &table, qint64 id, const QHash<QString, QVariant> &values
+                      , const void *origin, QObject *receiver, const Callback &done);
+
+   /** @brief Delete row 'id'
+    */
+   static void remove(const QString &table, qint64 id
+                      , const void *origin, QObject *receiver, const Callback &done);
+
+   /** @brief Run 'job' with the writer connection after the current group
+    */
+   static void run(const std::function<void(const QSqlDatabase &db)> &job);
+
+   /** @brief Write what is queued and end the thread; done when quitting
+    */
+   static void stop();
+};
+
+
+/*--- Fin ------------------------------------------------------------------*/
+#endif // ? ! WAREHOUSE_WRITEQUEUE_HPP
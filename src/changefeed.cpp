@@ -0,0 +1,411 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       changefeed.cpp
+ * @brief      Rows changed in the database, by this or other processes
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <changefeed.hpp>
+#include <connection.hpp>
+#include <schema.hpp>
+#include <searchindex.hpp>
+#include <writequeue.hpp>
+#include <QSqlQuery>
+#include <QThreadStorage>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+#include <QDebug>
+#include <sqlite3.h>
+#include <atomic>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+/** @brief Changes of one connection, or the committed ones of all
+ */
+struct CPending
+{
+   CChanges changes;
+   QHash<QString, int> counts;
+   /** @brief Position of the 'Unknown' change of a table */
+   QHash<QString, int> unknown;
+
+   /** @brief Add 'change'; beyond 'MaxRows' the table is reported once
+    */
+   void add(const CChange &change)
+   {
+      int &count=counts[change.table];
+
+      if( count > CChangeFeed::MaxRows )
+      {
+         // Written by several, so the writer can not skip it
+         CChange &merged=changes[ unknown.value(change.table) ];
+         if( merged.origin != change.origin )
+         {
+            merged.origin=nullptr;
+         }
+         return;
+      }
+      if( ( count == CChangeFeed::MaxRows ) || ( change.op == CChange::Unknown ) )
+      {
+         count=CChangeFeed::MaxRows + 1;
+         unknown.insert(change.table, changes.size());
+         changes.append( { change.table, -1, CChange::Unknown, change.origin } );
+         return;
+      }
+      count++;
+      changes.append(change);
+   }
+
+   void clear()
+   {
+      changes.clear();
+      counts.clear();
+      unknown.clear();
+   }
+};
+
+
+static int s_pollInterval=1000;
+/** @brief Set by the thread of the connection, read by the GUI thread */
+static std::atomic<bool> s_installed(false);
+/** @brief Guards the changes; hooks run in the thread writing */
+static QMutex s_mutex;
+/** @brief Changes of transactions not committed yet, per connection */
+static QHash<void *, CPending> s_pending;
+/** @brief Changes whose COMMIT is running or may have failed, per connection */
+static QHash<void *, CPending> s_committing;
+/** @brief Thread of the connection of a 's_committing' entry */
+static QHash<void *, QThread *> s_committers;
+static CPending s_committed;
+static bool s_scheduled=false;
+static QThreadStorage<const void *> s_origin;
+
+
+CChangeOrigin::CChangeOrigin(const void *origin)
+   :m_previous( current() )
+{
+   s_origin.setLocalData(origin);
+}
+
+
+CChangeOrigin::~CChangeOrigin()
+{
+   s_origin.setLocalData(m_previous);
+}
+
+
+const void *CChangeOrigin::current()
+{
+   return( s_origin.hasLocalData() ? s_origin.localData() : nullptr );
+}
+
+
+static void updateHook(void *handle, int op, const char *database
+                       , const char *table, sqlite3_int64 rowid)
+{
+   CChange change;
+
+   change.table=QString::fromUtf8(table);
+   // Shadow tables of the search index are of no interest
+   if( CSearchIndex::isIndexTable(change.table) )
+   {
+      return;
+   }
+   if( qstrcmp(database, "main") != 0 )
+   {
+      change.table=QString::fromUtf8(database) + "." + change.table;
+   }
+   change.rowid=rowid;
+   change.op=( op == SQLITE_INSERT ) ? CChange::Insert
+           : ( op == SQLITE_DELETE ) ? CChange::Delete : CChange::Update;
+   change.origin=CChangeOrigin::current();
+
+   QMutexLocker locker(&s_mutex);
+   s_pending[handle].add(change);
+}
+
+
+/** @brief Queue 'dispatch()' unless it is queued already; 's_mutex' locked
+ */
+static void schedule()
+{
+   if(!s_scheduled)
+   {
+      s_scheduled=true;
+      QMetaObject::invokeMethod(CChangeFeed::instance(), "dispatch", Qt::QueuedConnection);
+   }
+}
+
+
+/** @brief The COMMIT of 'handle' succeeded; 's_mutex' locked
+ */
+static void confirm(void *handle)
+{
+   for(const CChange &change: s_committing.take(handle).changes)
+   {
+      s_committed.add(change);
+   }
+   s_committers.remove(handle);
+   schedule();
+}
+
+
+static int commitHook(void *handle)
+{
+   QMutexLocker locker(&s_mutex);
+   CPending pending=s_pending.take(handle);
+
+   if( pending.changes.isEmpty() )
+   {
+      return(0);
+   }
+
+   // The COMMIT may still fail, e.g. busy or on I/O errors; the changes are
+   // kept until it is known to be done
+   CPending &committing=s_committing[handle];
+   for(const CChange &change: pending.changes)
+   {
+      committing.add(change);
+   }
+   s_committers.insert(handle, QThread::currentThread());
+   if( QThread::currentThread() == CChangeFeed::instance()->thread() )
+   {
+      // Done when the GUI thread gets to 'dispatch()'
+      schedule();
+   }
+
+   // Anything else turns the COMMIT into a ROLLBACK
+   return(0);
+}
+
+
+static void rollbackHook(void *handle)
+{
+   QMutexLocker locker(&s_mutex);
+   s_pending.remove(handle);
+   // Also a failed COMMIT ends up here
+   s_committing.remove(handle);
+   s_committers.remove(handle);
+}
+
+
+CChangeFeed::CChangeFeed(QObject *parent)
+   :QObject(parent)
+{
+   connect(&m_timer, &QTimer::timeout, this, &CChangeFeed::poll);
+}
+
+
+CChangeFeed *CChangeFeed::instance()
+{
+   // Created by the GUI thread when opening the database
+   static CChangeFeed *feed=new CChangeFeed(qApp);
+
+   return(feed);
+}
+
+
+bool CChangeFeed::install(const QSqlDatabase &db)
+{
+   instance();
+
+   // The hooks only work with the library Qt uses itself
+   sqlite3 *sqlite=CConnection::handle(db);
+   if(!sqlite)
+   {
+      qWarning("Qt uses another SQLite than %s; writes of this process are reported by table"
+               , sqlite3_libversion());
+      return(false);
+   }
+   sqlite3_update_hook(sqlite, updateHook, sqlite);
+   sqlite3_commit_hook(sqlite, commitHook, sqlite);
+   sqlite3_rollback_hook(sqlite, rollbackHook, sqlite);
+   s_installed=true;
+
+   return(true);
+}
+
+
+bool CChangeFeed::isInstalled()
+{
+   return(s_installed);
+}
+
+
+void CChangeFeed::written(const QString &table, const void *origin)
+{
+   QMutexLocker locker(&s_mutex);
+
+   // With the hooks the rows are known; the COMMIT of the calling thread is
+   // done now
+   if(s_installed)
+   {
+      for(void *handle: s_committers.keys( QThread::currentThread() ))
+      {
+         confirm(handle);
+      }
+      return;
+   }
+
+   s_committed.add( { table, -1, CChange::Unknown, origin } );
+   schedule();
+}
+
+
+void CChangeFeed::reportTable(const QString &table, const void *origin)
+{
+   QMutexLocker locker(&s_mutex);
+
+   s_committed.add( { table, -1, CChange::Unknown, origin } );
+   schedule();
+}
+
+
+void CChangeFeed::setPollInterval(int msec)
+{
+   s_pollInterval=msec;
+}
+
+
+int CChangeFeed::pollInterval()
+{
+   return(s_pollInterval);
+}
+
+
+void CChangeFeed::watch()
+{
+   m_versions.clear();
+   poll();
+   if( s_pollInterval > 0 )
+   {
+      m_timer.start(s_pollInterval);
+   }
+}
+
+
+/** @brief data_version of 'schemas' as seen by connection 'db'
+ *
+ * The catalog belongs to the GUI thread, so the schemas are passed.
+ */
+static QHash<QString, qint64> versions(const QSqlDatabase &db, const QStringList &schemas)
+{
+   QSqlQuery query(db);
+   QHash<QString, qint64> versions;
+
+   for(const QString &schema: schemas)
+   {
+      if( query.exec( QString("PRAGMA %1.data_version")
+                      .arg( CConnection::escapeField(schema, db) ) )
+          && query.next() )
+      {
+         versions.insert(schema, query.value(0).toLongLong());
+      }
+   }
+   query.finish();
+
+   return(versions);
+}
+
+
+void CChangeFeed::poll()
+{
+   // Commits of the writer would look like another process to the default
+   // connection; the writer itself only sees the others
+   QStringList schemas=CSchema::schemas();
+
+   if( CWriteQueue::isRunning() )
+   {
+      QPointer<CChangeFeed> feed(this);
+      CWriteQueue::run( [=](const QSqlDatabase &db){
+         QHash<QString, qint64> current=versions(db, schemas);
+         QMetaObject::invokeMethod(qApp, [=](){
+            if(feed)
+            {
+               feed->compare(current);
+            }
+         }, Qt::QueuedConnection);
+      } );
+      return;
+   }
+
+   compare( versions( QSqlDatabase::database(), schemas ) );
+}
+
+
+void CChangeFeed::compare(const QHash<QString, qint64> &versions)
+{
+   CPending pending;
+
+   // Changes only if another connection committed
+   for(auto it=versions.constBegin(); it!=versions.constEnd(); ++it)
+   {
+      const QString &schema=it.key();
+      qint64 version=it.value();
+      bool known=m_versions.contains(schema);
+      qint64 previous=m_versions.value(schema);
+      m_versions.insert(schema, version);
+      if( !known || ( version == previous ) )
+      {
+         continue;
+      }
+
+      // Also commits of workers of this process without hooks, e.g. imports
+      for(const QString &table: CSchema::tables())
+      {
+         if( ( CSchema::schemaOf(table) == schema )
+             && !CSearchIndex::isIndexTable( CSchema::baseName(table) ) )
+         {
+            pending.add( { table, -1, CChange::Unknown, nullptr } );
+         }
+      }
+   }
+
+   if( !pending.changes.isEmpty() )
+   {
+      emit changed(pending.changes);
+   }
+}
+
+
+void CChangeFeed::dispatch()
+{
+   CChanges changes;
+
+   {
+      QMutexLocker locker(&s_mutex);
+      // The COMMITs of this thread returned meanwhile; one still open failed
+      for(void *handle: s_committers.keys( thread() ))
+      {
+         if( sqlite3_get_autocommit( static_cast<sqlite3 *>(handle) ) )
+         {
+            confirm(handle);
+         }
+      }
+      changes=s_committed.changes;
+      s_committed.clear();
+      s_scheduled=false;
+   }
+
+   if( !changes.isEmpty() )
+   {
+      emit changed(changes);
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,358 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       connection.cpp
+ * @brief      Additional database connections for worker threads
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <connection.hpp>
+#include <dbprofile.hpp>
+#include <statementcache.hpp>
+#include <schema.hpp>
+#include <changefeed.hpp>
+#include <searchindex.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlDriver>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QPair>
+#include <QUrl>
+#include <QDebug>
+#include <sqlite3.h>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+/** @brief Name given to ATTACH and schema name of the attached databases */
+static QList<QPair<QString, QString>> s_attached;
+/** @brief Guards 's_attached'; workers open connections concurrently */
+static QMutex s_mutex;
+static bool s_readOnly=false;
+static bool s_inMemory=false;
+
+
+void CConnection::setReadOnly(bool readOnly)
+{
+   s_readOnly=readOnly;
+}
+
+
+bool CConnection::isReadOnly()
+{
+   return( s_readOnly || s_inMemory );
+}
+
+
+void CConnection::setInMemory(bool inMemory)
+{
+   s_inMemory=inMemory;
+}
+
+
+bool CConnection::isInMemory()
+{
+   return(s_inMemory);
+}
+
+
+/** @brief URI opening 'databaseFile' without locking; nobody may write it
+ */
+static QString readOnlyUri(const QString &databaseFile)
+{
+   QUrl url=QUrl::fromLocalFile( QFileInfo(databaseFile).absoluteFilePath() );
+   url.setQuery("mode=ro&immutable=1");
+
+   return( url.toString(QUrl::FullyEncoded) );
+}
+
+
+/** @brief URI of the copy of schema 'schema'; shared by all connections
+ */
+static QString memoryUri(const QString &schema)
+{
+   return( QString("file:warehouse-%1?mode=memory&cache=shared").arg(schema) );
+}
+
+
+/** @brief Copy 'databaseFile' into schema 'schema' of 'db' by the backup API
+ */
+static QSqlError copyToMemory(QSqlDatabase db, const QString &schema
+                              , const QString &databaseFile)
+{
+   QString connection=QString("snapshot-%1").arg(schema);
+   QSqlError err;
+
+   {
+      QSqlDatabase source=QSqlDatabase::addDatabase("QSQLITE", connection);
+      source.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_OPEN_URI");
+      source.setDatabaseName( readOnlyUri(databaseFile) );
+
+      if( !source.open() )
+      {
+         err=source.lastError();
+      }
+      else
+      {
+         sqlite3 *from=CConnection::handle(source);
+         sqlite3 *to=CConnection::handle(db);
+         sqlite3_backup *backup=( from && to )
+               ? sqlite3_backup_init(to, schema.toUtf8().constData(), from, "main") : nullptr;
+
+         if(!backup)
+         {
+            err=QSqlError(QString(), to ? QString::fromUtf8(sqlite3_errmsg(to))
+                                        : QString("Qt uses another SQLite library")
+                          , QSqlError::ConnectionError);
+         }
+         else
+         {
+            // All pages in one step; nobody else uses the copy yet
+            sqlite3_backup_step(backup, -1);
+            if( sqlite3_backup_finish(backup) != SQLITE_OK )
+            {
+               err=QSqlError(QString(), QString::fromUtf8(sqlite3_errmsg(to))
+                             , QSqlError::ConnectionError);
+            }
+         }
+         source.close();
+      }
+   }
+   QSqlDatabase::removeDatabase(connection);
+
+   return(err);
+}
+
+
+QSqlError CConnection::openDefault(const QString &databaseFile)
+{
+   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+   QElapsedTimer timer;
+
+   timer.start();
+   if(s_inMemory)
+   {
+      db.setConnectOptions("QSQLITE_OPEN_URI");
+      db.setDatabaseName( memoryUri("main") );
+   }
+   else if(s_readOnly)
+   {
+      db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_OPEN_URI");
+      db.setDatabaseName( readOnlyUri(databaseFile) );
+   }
+   else
+   {
+      db.setDatabaseName(databaseFile);
+   }
+
+   if (!db.open())
+      return db.lastError();
+
+   if(s_inMemory)
+   {
+      QSqlError err=copyToMemory(db, "main", databaseFile);
+      if( err.type() != QSqlError::NoError )
+      {
+         return(err);
+      }
+      qCDebug(lcTiming, "Copied '%s' into memory in %lld ms", qPrintable(databaseFile)
+              , timer.elapsed());
+   }
+
+   // Journal, cache and sync settings of the deployment
+   CDbProfile::load(db);
+   CDbProfile::apply(db);
+
+   // The writer and the GUI thread write with hooked connections; workers
+   // report the tables they wrote by CChangeFeed::reportTable()
+   CChangeFeed::install(db);
+
+   // Tables and columns for all users
+   CSchema::load(db);
+   CSearchIndex::readIndexes(db);
+
+   return QSqlError();
+}
+
+
+static QSqlError attachTo(QSqlDatabase db, const QString &databaseFile
+                          , const QString &schema)
+{
+   QSqlQuery query(db);
+
+   query.prepare( QString("ATTACH DATABASE ? AS %1")
+                  .arg( CConnection::escapeField(schema, db) ) );
+   query.addBindValue(databaseFile);
+   if( !query.exec() )
+   {
+      return( query.lastError() );
+   }
+
+   return( QSqlError() );
+}
+
+
+QSqlError CConnection::attach(const QString &databaseFile, const QString &schema)
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QStringList schemas=CSchema::schemas();
+   QString name=schema;
+
+   if( !QFileInfo::exists(databaseFile) )
+   {
+      // ATTACH would create an empty file
+      return( QSqlError(QString(), QString("No such file '%1'").arg(databaseFile)
+                        , QSqlError::ConnectionError) );
+   }
+
+   if(name.isEmpty())
+   {
+      QString base=QFileInfo(databaseFile).completeBaseName();
+      base.replace(QRegularExpression("[^A-Za-z0-9_]"), "_");
+      if( base.isEmpty() || base[0].isDigit() )
+      {
+         base.prepend('_');
+      }
+      name=base;
+      for(int i1=2; schemas.contains(name, Qt::CaseInsensitive); i1++)
+      {
+         name=QString("%1_%2").arg(base).arg(i1);
+      }
+   }
+
+   // Attached like the main file
+   QString target=databaseFile;
+   if(s_inMemory)
+   {
+      target=memoryUri(name);
+   }
+   else if(s_readOnly)
+   {
+      target=readOnlyUri(databaseFile);
+   }
+
+   QSqlError err=attachTo(db, target, name);
+   if( ( err.type() == QSqlError::NoError ) && s_inMemory )
+   {
+      err=copyToMemory(db, name, databaseFile);
+   }
+   if( err.type() != QSqlError::NoError )
+   {
+      return(err);
+   }
+
+   {
+      QMutexLocker locker(&s_mutex);
+      s_attached.append( { target, name } );
+   }
+
+   // The journal mode applies to the attached file only if set again
+   CDbProfile::apply(db);
+   CSchema::load(db);
+   CSearchIndex::readIndexes(db);
+
+   return( QSqlError() );
+}
+
+
+QSqlDatabase CConnection::open(const QString &name)
+{
+   if( QSqlDatabase::contains(name) )
+   {
+      return( QSqlDatabase::database(name) );
+   }
+
+   QSqlDatabase db=QSqlDatabase::cloneDatabase(
+            QString(QSqlDatabase::defaultConnection), name);
+
+   if( !db.open() )
+   {
+      qWarning("Could not open connection '%s': %s", qPrintable(name)
+               , qPrintable(db.lastError().text()));
+   }
+   else
+   {
+      QList<QPair<QString, QString>> attached;
+      {
+         QMutexLocker locker(&s_mutex);
+         attached=s_attached;
+      }
+
+      // Same files as the main connection, so the same table names work
+      for(const auto &file: attached)
+      {
+         QSqlError err=attachTo(db, file.first, file.second);
+         if( err.type() != QSqlError::NoError )
+         {
+            qWarning("Could not attach '%s' to '%s': %s", qPrintable(file.first)
+                     , qPrintable(name), qPrintable(err.text()));
+         }
+      }
+
+      // Same tuning as the main connection, including the busy timeout
+      CDbProfile::apply(db);
+   }
+
+   return(db);
+}
+
+
+void CConnection::close(const QString &name)
+{
+   CStatementCache::clear(name);
+   {
+      QSqlDatabase db=QSqlDatabase::database(name, false);
+      db.close();
+   }
+   QSqlDatabase::removeDatabase(name);
+}
+
+
+sqlite3 *CConnection::handle(const QSqlDatabase &db)
+{
+   QVariant value=db.driver()->handle();
+
+   if( !value.isValid() || ( qstrcmp(value.typeName(), "sqlite3*") != 0 ) )
+   {
+      return(nullptr);
+   }
+
+   // Only the library Qt uses itself can work on the handle
+   QSqlQuery query(db);
+   if( !query.exec("SELECT sqlite_version()") || !query.next()
+       || ( query.value(0).toString() != QString::fromUtf8(sqlite3_libversion()) ) )
+   {
+      return(nullptr);
+   }
+
+   return( *static_cast<sqlite3 **>( value.data() ) );
+}
+
+
+QString CConnection::escapeTable(const QString &name, const QSqlDatabase &db)
+{
+   return( db.driver()->escapeIdentifier(name, QSqlDriver::TableName) );
+}
+
+
+QString CConnection::escapeField(const QString &name, const QSqlDatabase &db)
+{
+   return( db.driver()->escapeIdentifier(name, QSqlDriver::FieldName) );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,218 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       dbprofile.cpp
+ * @brief      Tuning of the SQLite connections
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <dbprofile.hpp>
+#include <connection.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static const char *s_settingsTable="warehouse_settings";
+
+static QMutex s_mutex;
+static QString s_profile="default";
+/** @brief Overrides from command line; they win over the settings table */
+static QMap<QString, QString> s_commandLine;
+static QString s_commandLineProfile;
+static QMap<QString, QString> s_pragmas;
+
+
+QMap<QString, QString> CDbProfile::preset(const QString &name)
+{
+   QMap<QString, QString> pragmas;
+
+   // Always wait for other writers instead of failing
+   pragmas["busy_timeout"]="5000";
+
+   if(name == "read")
+   {
+      pragmas["journal_mode"]="wal";
+      pragmas["synchronous"]="normal";
+      pragmas["mmap_size"]="268435456";
+      pragmas["cache_size"]="-65536";
+      pragmas["temp_store"]="memory";
+   }
+   else if(name == "write")
+   {
+      pragmas["journal_mode"]="wal";
+      pragmas["synchronous"]="normal";
+      pragmas["cache_size"]="-16384";
+      pragmas["temp_store"]="memory";
+   }
+   else if(name == "safe")
+   {
+      pragmas["journal_mode"]="wal";
+      pragmas["synchronous"]="full";
+   }
+
+   return(pragmas);
+}
+
+
+QStringList CDbProfile::profiles()
+{
+   return( QStringList() << "default" << "read" << "write" << "safe" );
+}
+
+
+bool CDbProfile::valid(const QString &pragma, const QString &value)
+{
+   static const QStringList pragmas=QStringList()
+         << "journal_mode" << "synchronous" << "mmap_size" << "cache_size"
+         << "temp_store" << "busy_timeout";
+   static const QRegularExpression values("^-?[A-Za-z0-9_]+$");
+
+   return( pragmas.contains(pragma) && values.match(value).hasMatch() );
+}
+
+
+bool CDbProfile::setProfile(const QString &name)
+{
+   QMutexLocker locker(&s_mutex);
+
+   if(!profiles().contains(name))
+   {
+      return(false);
+   }
+
+   s_commandLineProfile=name;
+   s_profile=name;
+   s_pragmas=preset(name);
+   s_pragmas.insert(s_commandLine);
+
+   return(true);
+}
+
+
+bool CDbProfile::set(const QString &assignment)
+{
+   QMutexLocker locker(&s_mutex);
+   QString pragma=assignment.section('=', 0, 0).trimmed().toLower();
+   QString value=assignment.section('=', 1).trimmed();
+
+   if(!valid(pragma, value))
+   {
+      return(false);
+   }
+
+   s_commandLine[pragma]=value;
+   s_pragmas[pragma]=value;
+
+   return(true);
+}
+
+
+void CDbProfile::load(QSqlDatabase db)
+{
+   QMutexLocker locker(&s_mutex);
+   QMap<QString, QString> settings;
+   QString profile=s_profile;
+
+   if( !db.tables().contains(s_settingsTable) )
+   {
+      s_pragmas=preset(profile);
+      s_pragmas.insert(s_commandLine);
+      return;
+   }
+
+   QSqlQuery query(db);
+   if( !query.exec( QString("SELECT key, value FROM %1").arg(s_settingsTable) ) )
+   {
+      qWarning("Could not read '%s': %s", s_settingsTable
+               , qPrintable(query.lastError().text()));
+   }
+   while(query.next())
+   {
+      QString key=query.value(0).toString().trimmed().toLower();
+      QString value=query.value(1).toString().trimmed();
+
+      if( ( key == "profile" ) && profiles().contains(value) )
+      {
+         profile=value;
+      }
+      else if(valid(key, value))
+      {
+         settings[key]=value;
+      }
+      else
+      {
+         qWarning("Ignoring setting '%s'='%s'", qPrintable(key), qPrintable(value));
+      }
+   }
+
+   // A profile given on the command line replaces the one of the database
+   if(!s_commandLineProfile.isEmpty())
+   {
+      profile=s_commandLineProfile;
+   }
+
+   s_profile=profile;
+   s_pragmas=preset(profile);
+   s_pragmas.insert(settings);
+   s_pragmas.insert(s_commandLine);
+}
+
+
+void CDbProfile::apply(QSqlDatabase db)
+{
+   QMap<QString, QString> pragmas;
+   QString profile;
+
+   {
+      QMutexLocker locker(&s_mutex);
+      pragmas=s_pragmas.isEmpty() ? preset(s_profile) : s_pragmas;
+      profile=s_profile;
+   }
+
+   if( CConnection::isReadOnly() )
+   {
+      // Nothing is written; switching to WAL would need write access
+      pragmas.remove("journal_mode");
+      pragmas.remove("synchronous");
+      pragmas["query_only"]="1";
+   }
+
+   for(auto it=pragmas.constBegin(); it!=pragmas.constEnd(); ++it)
+   {
+      // Values are checked by 'valid()'; PRAGMAs can not be bound
+      QSqlQuery query(db);
+      if( !query.exec( QString("PRAGMA %1=%2").arg(it.key(), it.value()) ) )
+      {
+         qWarning("Could not set PRAGMA %s: %s", qPrintable(it.key())
+                  , qPrintable(query.lastError().text()));
+      }
+   }
+
+   qCDebug(lcTiming, "Applied profile '%s' to connection '%s'", qPrintable(profile)
+           , qPrintable(db.connectionName()));
+}
+
+
+bool CDbProfile::isSettingsTable(const QString &table)
+{
+   return( table == s_settingsTable );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
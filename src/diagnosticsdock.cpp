@@ -0,0 +1,215 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       diagnosticsdock.cpp
+ * @brief      Dock showing the query statistics and slow queries
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <diagnosticsdock.hpp>
+#include <queryprofiler.hpp>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QPushButton>
+#include <QFontDatabase>
+#include <QSet>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+enum
+{
+   ColumnTable,
+   ColumnKind,
+   ColumnCount,
+   ColumnMean,
+   ColumnMax,
+   ColumnRows,
+   ColumnHistogram,
+};
+
+
+enum
+{
+   ColumnSlowTime,
+   ColumnSlowTable,
+   ColumnSlowKind,
+   ColumnSlowMsecs,
+   ColumnSlowRows,
+   ColumnSlowStatement,
+};
+
+
+CDiagnosticsDock::CDiagnosticsDock(QWidget *parent)
+   :QDockWidget(tr("Diagnostics"), parent)
+{
+   QWidget *widget=new QWidget(this);
+   QVBoxLayout *layout=new QVBoxLayout(widget);
+   QSplitter *splitter=new QSplitter(Qt::Vertical, widget);
+   QHBoxLayout *buttons=new QHBoxLayout();
+   QPushButton *reset=new QPushButton(tr("Reset"), widget);
+   QStringList limits;
+
+   setObjectName("diagnostics");
+
+   m_stats=new QTreeWidget(splitter);
+   m_stats->setHeaderLabels( { tr("Table"), tr("Query"), tr("Count"), tr("Mean ms")
+                               , tr("Max ms"), tr("Rows"), tr("Histogram") } );
+   for(int i1=0; i1<CQueryProfiler::Buckets; i1++)
+   {
+      qint64 limit=CQueryProfiler::bucketLimit(i1);
+      limits << ( ( limit < 0 ) ? QString("more") : QString("< %1 ms").arg(limit / 1000.0) );
+   }
+   m_stats->headerItem()->setToolTip( ColumnHistogram, limits.join("\n") );
+
+   m_slow=new QTreeWidget(splitter);
+   m_slow->setHeaderLabels( { tr("Time"), tr("Table"), tr("Query"), tr("ms")
+                              , tr("Rows"), tr("Statement") } );
+
+   buttons->addStretch();
+   buttons->addWidget(reset);
+   layout->addWidget(splitter);
+   layout->addLayout(buttons);
+   setWidget(widget);
+
+   connect(reset, &QPushButton::pressed, this, [this](){
+      CQueryProfiler::reset();
+      refresh();
+   });
+   connect(&m_timer, &QTimer::timeout, this, &CDiagnosticsDock::refresh);
+}
+
+
+void CDiagnosticsDock::showEvent(QShowEvent *event)
+{
+   // Only read while somebody looks at it
+   refresh();
+   m_timer.start(1000);
+   QDockWidget::showEvent(event);
+}
+
+
+void CDiagnosticsDock::hideEvent(QHideEvent *event)
+{
+   m_timer.stop();
+   QDockWidget::hideEvent(event);
+}
+
+
+QString CDiagnosticsDock::msecs(qint64 nsecs)
+{
+   return( QString::number(nsecs / 1000000.0, 'f', 2) );
+}
+
+
+QString CDiagnosticsDock::histogram(const QVector<qint64> &buckets)
+{
+   static const QString bars=QString::fromUtf8(" ▁▂▃▄▅▆▇█");
+   QString text;
+   qint64 max=1;
+
+   for(qint64 count: buckets)
+   {
+      max=qMax(max, count);
+   }
+
+   // Any non-empty bucket gets at least the lowest bar
+   for(qint64 count: buckets)
+   {
+      int bar=count ? int( 1 + ( count * ( bars.size() - 2 ) ) / max ) : 0;
+      text += bars[bar];
+   }
+
+   return(text);
+}
+
+
+void CDiagnosticsDock::refresh()
+{
+   QFont fixed=QFontDatabase::systemFont(QFontDatabase::FixedFont);
+   QSet<QString> expanded;
+
+   // Keep the rows opened by the user open
+   for(int i1=0; i1<m_stats->topLevelItemCount(); i1++)
+   {
+      QTreeWidgetItem *item=m_stats->topLevelItem(i1);
+      if(item->isExpanded())
+      {
+         expanded << item->text(ColumnTable) + '\n' + item->text(ColumnKind);
+      }
+   }
+   m_stats->clear();
+
+   for(const CQueryStats &stats: CQueryProfiler::stats())
+   {
+      QTreeWidgetItem *item=new QTreeWidgetItem(m_stats);
+      item->setText( ColumnTable, stats.table );
+      item->setText( ColumnKind, CQueryProfiler::kindName(stats.kind) );
+      item->setText( ColumnCount, QString::number(stats.count) );
+      item->setText( ColumnMean, msecs( stats.nsecs / qMax<qint64>(stats.count, 1) ) );
+      item->setText( ColumnMax, msecs(stats.maxNsecs) );
+      item->setText( ColumnRows, QString::number(stats.rows) );
+      item->setText( ColumnHistogram, histogram(stats.buckets) );
+      item->setFont( ColumnHistogram, fixed );
+
+      // Slowest statement and its plan
+      if(!stats.slowest.isEmpty())
+      {
+         QTreeWidgetItem *statement=new QTreeWidgetItem(item);
+         statement->setText( ColumnTable, stats.slowest );
+         statement->setFirstColumnSpanned(true);
+         for(const QString &step: stats.plan)
+         {
+            QTreeWidgetItem *plan=new QTreeWidgetItem(statement);
+            plan->setText( ColumnTable, step );
+            plan->setFirstColumnSpanned(true);
+         }
+      }
+      item->setExpanded( expanded.contains( stats.table + '\n'
+                                            + CQueryProfiler::kindName(stats.kind) ) );
+   }
+
+   QVector<CSlowQuery> slow=CQueryProfiler::slowQueries();
+   QDateTime latest=slow.isEmpty() ? QDateTime() : slow.last().time;
+   if( ( m_slow->topLevelItemCount() == slow.size() ) && ( latest == m_latest ) )
+   {
+      // Nothing new; the list would only lose its state
+      return;
+   }
+
+   m_latest=latest;
+   m_slow->clear();
+   // Newest first
+   for(int i1=slow.size()-1; i1>=0; i1--)
+   {
+      const CSlowQuery &query=slow[i1];
+      QTreeWidgetItem *item=new QTreeWidgetItem(m_slow);
+      item->setText( ColumnSlowTime, query.time.toString("hh:mm:ss.zzz") );
+      item->setText( ColumnSlowTable, query.table );
+      item->setText( ColumnSlowKind, CQueryProfiler::kindName(query.kind) );
+      item->setText( ColumnSlowMsecs, msecs(query.nsecs) );
+      item->setText( ColumnSlowRows, QString::number(query.rows) );
+      item->setText( ColumnSlowStatement, query.sql );
+      item->setToolTip( ColumnSlowStatement, query.sql );
+      for(const QString &step: query.plan)
+      {
+         QTreeWidgetItem *plan=new QTreeWidgetItem(item);
+         plan->setText( ColumnSlowTime, step );
+         plan->setFirstColumnSpanned(true);
+      }
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
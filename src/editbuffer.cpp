@@ -0,0 +1,210 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       editbuffer.cpp
+ * @brief      Collect edits of a table and write them in one transaction
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <editbuffer.hpp>
+#include <connection.hpp>
+#include <statementcache.hpp>
+#include <queryprofiler.hpp>
+#include <changefeed.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static bool s_enabled=false;
+static int s_flushInterval=2000;
+
+
+CEditBuffer::CEditBuffer(const QString &table, QObject *parent)
+   :QObject(parent)
+   ,m_table(table)
+{
+   m_timer.setSingleShot(true);
+   connect(&m_timer, &QTimer::timeout, this, &CEditBuffer::flush);
+}
+
+
+void CEditBuffer::setEnabled(bool enabled)
+{
+   s_enabled=enabled;
+}
+
+
+bool CEditBuffer::isEnabled()
+{
+   return(s_enabled);
+}
+
+
+void CEditBuffer::setFlushInterval(int msec)
+{
+   s_flushInterval=msec;
+}
+
+
+int CEditBuffer::flushInterval()
+{
+   return(s_flushInterval);
+}
+
+
+void CEditBuffer::set(qint64 id, const QString &column, const QVariant &value)
+{
+   bool wasDirty=isDirty();
+
+   m_rows[id][column]=value;
+
+   // Counting from the first edit, so continuous typing still gets written
+   if( ( s_flushInterval > 0 ) && !m_timer.isActive() )
+   {
+      m_timer.start(s_flushInterval);
+   }
+
+   if(!wasDirty)
+   {
+      emit dirtyChanged(true);
+   }
+}
+
+
+QHash<QString, QVariant> CEditBuffer::values(qint64 id) const
+{
+   return( m_rows.value(id) );
+}
+
+
+void CEditBuffer::discard(qint64 id)
+{
+   if( m_rows.remove(id) && !isDirty() )
+   {
+      m_timer.stop();
+      emit dirtyChanged(false);
+   }
+}
+
+
+QSet<qint64> CEditBuffer::dirtyIds() const
+{
+   QSet<qint64> ids;
+
+   for(auto it=m_rows.constBegin(); it!=m_rows.constEnd(); ++it)
+   {
+      ids.insert(it.key());
+   }
+
+   return(ids);
+}
+
+
+bool CEditBuffer::flush()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QString table=CConnection::escapeTable(m_table, db);
+
+   m_timer.stop();
+
+   if(!isDirty())
+   {
+      return(true);
+   }
+
+   if(!db.transaction())
+   {
+      emit flushFailed(db.lastError().text());
+      return(false);
+   }
+
+   // The tab shows these values already
+   CChangeOrigin origin(this);
+
+   for(auto it=m_rows.constBegin(); it!=m_rows.constEnd(); ++it)
+   {
+      QStringList assignments;
+
+      for(auto field=it.value().constBegin(); field!=it.value().constEnd(); ++field)
+      {
+         assignments << CConnection::escapeField(field.key(), db) + "=?";
+      }
+
+      // Mostly the same fields are edited, so the statement is reused
+      QSharedPointer<QSqlQuery> query=CStatementCache::prepare(
+               QString("UPDATE %1 SET %2 WHERE id=?").arg(table, assignments.join(", "))
+               , db );
+      for(const QVariant &value: it.value())
+      {
+         query->addBindValue(value);
+      }
+      query->addBindValue(it.key());
+
+      CQueryTimer timer(m_table, CQueryProfiler::Update, query->lastQuery()
+                        , it.value().values() << it.key(), db);
+      bool ok=query->exec();
+      QString error=query->lastError().text();
+      query->finish();
+      timer.finish(ok ? 1 : 0);
+      if(!ok)
+      {
+         db.rollback();
+         qWarning("Could not save '%s' %lld: %s", qPrintable(m_table)
+                  , it.key(), qPrintable(error));
+         emit flushFailed(error);
+         return(false);
+      }
+   }
+
+   // Most of the time is spent syncing to disk
+   CQueryTimer commitTimer(m_table, CQueryProfiler::Update, "COMMIT", QVariantList(), db);
+   if(!db.commit())
+   {
+      // Otherwise every later statement of the connection would join it
+      QString error=db.lastError().text();
+      db.rollback();
+      emit flushFailed(error);
+      return(false);
+   }
+   commitTimer.finish(m_rows.size());
+   CChangeFeed::written(m_table, this);
+
+   QList<qint64> ids=m_rows.keys();
+   m_rows.clear();
+   qCDebug(lcTiming, "Saved %d row(s) of '%s'", int(ids.size()), qPrintable(m_table));
+
+   emit flushed(ids);
+   emit dirtyChanged(false);
+
+   return(true);
+}
+
+
+void CEditBuffer::revert()
+{
+   m_timer.stop();
+
+   if(isDirty())
+   {
+      m_rows.clear();
+      emit dirtyChanged(false);
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
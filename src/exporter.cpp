@@ -0,0 +1,436 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       exporter.cpp
+ * @brief      Write tables as Textile, CSV or JSON Lines without a GUI
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <exporter.hpp>
+#include <connection.hpp>
+#include <schema.hpp>
+#include <searchindex.hpp>
+#include <dbprofile.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFile>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstdio>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CExporter::CExporter(Format format)
+   :m_format(format)
+{
+}
+
+
+bool CExporter::parseFormat(const QString &name, Format &format)
+{
+   QString lower=name.toLower();
+
+   if( lower == "textile" )
+   {
+      format=FormatTextile;
+   }
+   else if( lower == "csv" )
+   {
+      format=FormatCsv;
+   }
+   else if( ( lower == "jsonl" ) || ( lower == "json" ) )
+   {
+      format=FormatJsonLines;
+   }
+   else
+   {
+      return(false);
+   }
+
+   return(true);
+}
+
+
+QStringList CExporter::formats()
+{
+   return( { "textile", "csv", "jsonl" } );
+}
+
+
+QString CExporter::suffix(Format format)
+{
+   switch(format)
+   {
+      case FormatTextile:
+         return("textile");
+      case FormatCsv:
+         return("csv");
+      case FormatJsonLines:
+         return("jsonl");
+   }
+
+   return(QString());
+}
+
+
+bool CExporter::flush(bool force)
+{
+   if( m_failed || ( !force && ( m_buffer.size() < BufferSize ) ) )
+   {
+      return(!m_failed);
+   }
+
+   if( m_device->write(m_buffer) != m_buffer.size() )
+   {
+      qWarning("Could not write: %s", qPrintable(m_device->errorString()));
+      m_failed=true;
+   }
+   m_buffer.resize(0);
+
+   return(!m_failed);
+}
+
+
+void CExporter::appendEscaped(QByteArray &buffer, const QByteArray &text) const
+{
+   switch(m_format)
+   {
+      case FormatTextile:
+      {
+         // Cells are separated by '|' and end with the line
+         for(char c: text)
+         {
+            if( c == '|' )
+               buffer += "&#124;";
+            else if( c == '\n' )
+               buffer += "<br>";
+            else if( c != '\r' )
+               buffer += c;
+         }
+         break;
+      }
+      case FormatCsv:
+      {
+         bool quote=false;
+         for(char c: text)
+         {
+            if( ( c == ',' ) || ( c == '"' ) || ( c == '\n' ) || ( c == '\r' ) )
+            {
+               quote=true;
+               break;
+            }
+         }
+         if(!quote)
+         {
+            buffer += text;
+            break;
+         }
+         buffer += '"';
+         for(char c: text)
+         {
+            if( c == '"' )
+               buffer += '"';
+            buffer += c;
+         }
+         buffer += '"';
+         break;
+      }
+      case FormatJsonLines:
+      {
+         static const char hex[]="0123456789abcdef";
+         buffer += '"';
+         for(char c: text)
+         {
+            unsigned char u=(unsigned char)c;
+            if( c == '"' )
+               buffer += "\\\"";
+            else if( c == '\\' )
+               buffer += "\\\\";
+            else if( c == '\n' )
+               buffer += "\\n";
+            else if( c == '\r' )
+               buffer += "\\r";
+            else if( c == '\t' )
+               buffer += "\\t";
+            else if( u < 0x20 )
+            {
+               buffer += "\\u00";
+               buffer += hex[u >> 4];
+               buffer += hex[u & 0xf];
+            }
+            else
+               buffer += c;
+         }
+         buffer += '"';
+         break;
+      }
+   }
+}
+
+
+void CExporter::writeHeader(const QStringList &columns)
+{
+   m_keys.clear();
+
+   for(int i1=0; i1<columns.size(); i1++)
+   {
+      switch(m_format)
+      {
+         case FormatTextile:
+            m_buffer += "|_. ";
+            appendEscaped(m_buffer, columns[i1].toUtf8());
+            m_buffer += ' ';
+            break;
+         case FormatCsv:
+            if(i1)
+               m_buffer += ',';
+            appendEscaped(m_buffer, columns[i1].toUtf8());
+            break;
+         case FormatJsonLines:
+         {
+            // No header line; every object repeats the keys
+            QByteArray key( i1 ? "," : "{" );
+            appendEscaped(key, columns[i1].toUtf8());
+            key += ':';
+            m_keys.append(key);
+            break;
+         }
+      }
+   }
+
+   if( m_format == FormatTextile )
+   {
+      m_buffer += "|\n";
+   }
+   else if( m_format == FormatCsv )
+   {
+      m_buffer += '\n';
+   }
+}
+
+
+void CExporter::writeValue(const QVariant &value, int column)
+{
+   switch(m_format)
+   {
+      case FormatTextile:
+         m_buffer += "| ";
+         break;
+      case FormatCsv:
+         if(column)
+            m_buffer += ',';
+         break;
+      case FormatJsonLines:
+         m_buffer += m_keys[column];
+         break;
+   }
+
+   if( value.isNull() )
+   {
+      if( m_format == FormatJsonLines )
+      {
+         m_buffer += "null";
+      }
+   }
+   else
+   {
+      switch( value.userType() )
+      {
+         case QMetaType::Int:
+         case QMetaType::UInt:
+         case QMetaType::LongLong:
+         case QMetaType::ULongLong:
+            m_buffer += QByteArray::number( value.toLongLong() );
+            break;
+         case QMetaType::Double:
+            m_buffer += QByteArray::number( value.toDouble(), 'g', 17 );
+            break;
+         case QMetaType::QByteArray:
+            // Blobs as text
+            appendEscaped( m_buffer, value.toByteArray().toBase64() );
+            break;
+         default:
+            appendEscaped( m_buffer, value.toString().toUtf8() );
+            break;
+      }
+   }
+
+   if( m_format == FormatTextile )
+   {
+      m_buffer += ' ';
+   }
+}
+
+
+qint64 CExporter::write(const QString &table, QIODevice *device)
+{
+   CTableInfoPtr info=CSchema::table(table);
+   QString escaped=CConnection::escapeTable(table);
+   QStringList columns;
+   QStringList names;
+   QString joins;
+   QElapsedTimer timer;
+   qint64 rows=0;
+
+   if(info.isNull())
+   {
+      qWarning("Could not find table '%s'.", qPrintable(table));
+      return(-1);
+   }
+
+   timer.start();
+   m_device=device;
+   m_failed=false;
+   m_buffer.resize(0);
+   m_buffer.reserve(BufferSize + 4096);
+
+   // Relations are resolved by SQLite; a dangling key gives NULL
+   for(const CColumnInfo &column: info->columns)
+   {
+      names << column.name;
+      if( column.isForeignKey() )
+      {
+         QString alias=QString("r%1").arg(columns.size());
+         joins += QString(" LEFT JOIN %1 %2 ON %2.id = %3.%4")
+               .arg(CConnection::escapeTable(column.foreignTable), alias, escaped
+                    , CConnection::escapeField(column.name));
+         columns << alias + ".Name";
+      }
+      else
+      {
+         columns << escaped + "." + CConnection::escapeField(column.name);
+      }
+   }
+
+   // Forward only; the driver does not keep the rows already read
+   QSqlQuery query;
+   query.setForwardOnly(true);
+   if( !query.exec( QString("SELECT %1 FROM %2%3 ORDER BY %2.id")
+                    .arg(columns.join(", "), escaped, joins) ) )
+   {
+      qWarning("Could not export '%s': %s", qPrintable(table)
+               , qPrintable(query.lastError().text()));
+      return(-1);
+   }
+
+   writeHeader(names);
+   while( query.next() )
+   {
+      for(int i1=0; i1<names.size(); i1++)
+      {
+         writeValue(query.value(i1), i1);
+      }
+      switch(m_format)
+      {
+         case FormatTextile:
+            m_buffer += "|\n";
+            break;
+         case FormatCsv:
+            m_buffer += '\n';
+            break;
+         case FormatJsonLines:
+            m_buffer += ( names.isEmpty() ? "{}\n" : "}\n" );
+            break;
+      }
+      rows++;
+      if( !flush(false) )
+      {
+         return(-1);
+      }
+   }
+
+   if( !flush(true) )
+   {
+      return(-1);
+   }
+
+   qCDebug(lcTiming, "Exported %lld rows of '%s' in %lld ms", rows, qPrintable(table)
+           , timer.elapsed());
+
+   return(rows);
+}
+
+
+int CExporter::run(const QStringList &tables, Format format, const QString &output)
+{
+   CExporter exporter(format);
+   QStringList names;
+
+   for(const QString &table: tables)
+   {
+      if( table != "*" )
+      {
+         names << table;
+         continue;
+      }
+      for(const QString &name: CSchema::tables())
+      {
+         if( !CSearchIndex::isIndexTable(name) && !CDbProfile::isSettingsTable(name) )
+         {
+            names << name;
+         }
+      }
+   }
+
+   if( names.size() == 1 )
+   {
+      QFile file(output);
+      bool opened;
+      if(output.isEmpty())
+      {
+         opened=file.open(stdout, QIODevice::WriteOnly);
+      }
+      else
+      {
+         opened=file.open(QIODevice::WriteOnly);
+      }
+      if(!opened)
+      {
+         qWarning("Could not open '%s': %s", qPrintable(output)
+                  , qPrintable(file.errorString()));
+         return(1);
+      }
+      return( ( exporter.write(names[0], &file) < 0 ) ? 1 : 0 );
+   }
+
+   // One file per table
+   if( output.isEmpty() || !QDir().mkpath(output) )
+   {
+      qWarning("Several tables need an output directory");
+      return(1);
+   }
+
+   for(const QString &table: names)
+   {
+      QFile file( QDir(output).filePath(table + "." + suffix(format)) );
+      if( !file.open(QIODevice::WriteOnly) )
+      {
+         qWarning("Could not open '%s': %s", qPrintable(file.fileName())
+                  , qPrintable(file.errorString()));
+         return(1);
+      }
+      if( exporter.write(table, &file) < 0 )
+      {
+         return(1);
+      }
+   }
+
+   return(0);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,80 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       formmodel.cpp
+ * @brief      Table model of the form, reading the columns shown only
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <formmodel.hpp>
+#include <connection.hpp>
+#include <QSqlRecord>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CFormModel::CFormModel(QObject *parent)
+   :CProfiledTableModel(parent)
+{
+}
+
+
+void CFormModel::setProjection(const QStringList &columns)
+{
+   QSqlRecord table=database().record( tableName() );
+   QStringList fields;
+   bool all=true;
+
+   for(int i1=0; i1<table.count(); i1++)
+   {
+      QString field=CConnection::escapeField(table.fieldName(i1), database());
+      if( columns.contains( table.fieldName(i1) ) )
+      {
+         fields << field;
+      }
+      else
+      {
+         fields << "NULL AS " + field;
+         all=false;
+      }
+   }
+
+   m_projection=( columns.isEmpty() || all ) ? QString() : fields.join(", ");
+}
+
+
+QString CFormModel::selectStatement() const
+{
+   if( m_projection.isEmpty() || primaryKey().isEmpty() )
+   {
+      return( CProfiledTableModel::selectStatement() );
+   }
+
+   QString statement=QString("SELECT %1 FROM %2").arg( m_projection
+         , CConnection::escapeTable(tableName(), database()) );
+
+   if( !filter().isEmpty() )
+   {
+      statement += " WHERE " + filter();
+   }
+   QString order=orderByClause();
+   if( !order.isEmpty() )
+   {
+      statement += " " + order;
+   }
+
+   return(statement);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
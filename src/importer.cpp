@@ -0,0 +1,527 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       importer.cpp
+ * @brief      Insert rows from CSV or JSON Lines files into a table
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <importer.hpp>
+#include <connection.hpp>
+#include <schema.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonParseError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CImporter::CImporter(const QString &table, QObject *parent)
+   :QObject(parent)
+   ,m_table(table)
+   ,m_info(CSchema::table(table))
+{
+}
+
+
+CImporter::Format CImporter::formatOf(const QString &fileName)
+{
+   QString suffix=QFileInfo(fileName).suffix().toLower();
+
+   if( ( suffix == "jsonl" ) || ( suffix == "json" ) || ( suffix == "ndjson" ) )
+   {
+      return(FormatJsonLines);
+   }
+
+   return(FormatCsv);
+}
+
+
+const QHash<QString, qint64> &CImporter::names(const QString &table
+                                               , const QSqlDatabase &db)
+{
+   auto it=m_names.find(table);
+
+   if( it != m_names.end() )
+   {
+      return(*it);
+   }
+
+   // One pass per referenced table; the rows are looked up in memory
+   QHash<QString, qint64> &names=m_names[table];
+   QSqlQuery query(db);
+   query.setForwardOnly(true);
+   if( !query.exec( QString("SELECT id, Name FROM %1 ORDER BY id DESC")
+                    .arg(CConnection::escapeTable(table, db)) ) )
+   {
+      qWarning("Could not read '%s': %s", qPrintable(table)
+               , qPrintable(query.lastError().text()));
+   }
+   while(query.next())
+   {
+      // Descending, so the lowest id wins for duplicate Names
+      names.insert( query.value(1).toString(), query.value(0).toLongLong() );
+   }
+
+   return(names);
+}
+
+
+bool CImporter::readCsvRecord(QIODevice *device, QStringList &fields, qint64 &line)
+{
+   QByteArray field;
+   bool quoted=false;
+   bool any=false;
+
+   fields.clear();
+
+   while( !device->atEnd() )
+   {
+      QByteArray text=device->readLine();
+      line++;
+      any=true;
+
+      for(int i1=0; i1<text.size(); i1++)
+      {
+         char c=text[i1];
+
+         if(quoted)
+         {
+            if( c != '"' )
+            {
+               field += c;
+            }
+            else if( ( i1+1 < text.size() ) && ( text[i1+1] == '"' ) )
+            {
+               field += '"';
+               i1++;
+            }
+            else
+            {
+               quoted=false;
+            }
+         }
+         else if( c == '"' )
+         {
+            quoted=true;
+         }
+         else if( c == ',' )
+         {
+            fields << QString::fromUtf8(field);
+            field.resize(0);
+         }
+         else if( ( c != '\r' ) && ( c != '\n' ) )
+         {
+            field += c;
+         }
+      }
+
+      // A quoted field may contain line breaks
+      if(!quoted)
+      {
+         break;
+      }
+   }
+
+   if(any)
+   {
+      fields << QString::fromUtf8(field);
+   }
+
+   return(any);
+}
+
+
+CImportReport CImporter::run(const QString &fileName, int rejectLimit
+                             , const QSqlDatabase &db)
+{
+   QFile file(fileName);
+
+   if( !file.open(QIODevice::ReadOnly) )
+   {
+      CImportReport report;
+      report.error=QString("Could not open '%1': %2").arg(fileName, file.errorString());
+      return(report);
+   }
+
+   return( run(&file, formatOf(fileName), rejectLimit, db) );
+}
+
+
+CImportReport CImporter::run(QIODevice *device, Format format, int rejectLimit
+                             , const QSqlDatabase &db)
+{
+   CImportReport report;
+   const CTableInfoPtr &info=m_info;
+   QSqlDatabase connection=db;
+   QElapsedTimer timer;
+   QElapsedTimer batchTimer;
+   QStringList keys;
+   // Column of a CSV field; -1 if the table has none
+   QVector<int> columnOf;
+   // Statement per set of columns; records of JSON Lines may have other keys
+   QHash<QString, QSqlQuery> statements;
+   qint64 line=0;
+   qint64 records=0;
+   int batch=0;
+
+   auto reject=[&](qint64 line, const QString &reason){
+      report.rejectedCount++;
+      if( report.rejected.size() < rejectLimit )
+      {
+         report.rejected.append( { line, reason } );
+      }
+   };
+
+   auto ignore=[&](const QString &key){
+      if( !report.ignored.contains(key) )
+      {
+         report.ignored << key;
+      }
+   };
+
+   // Prepared INSERT for the columns 'indexes'; null if it could not be prepared
+   auto statement=[&](const QVector<int> &indexes, QString &reason) -> QSqlQuery * {
+      QStringList columns;
+      QStringList placeholders;
+      for(int index: indexes)
+      {
+         columns << CConnection::escapeField(info->columns[index].name, db);
+         placeholders << "?";
+      }
+      QString key=columns.join(", ");
+      auto it=statements.find(key);
+      if( it == statements.end() )
+      {
+         QSqlQuery query(db);
+         if( !query.prepare( QString("INSERT INTO %1 (%2) VALUES (%3)")
+                             .arg(CConnection::escapeTable(m_table, db), key
+                                  , placeholders.join(", ")) ) )
+         {
+            reason=query.lastError().text();
+            return(nullptr);
+         }
+         it=statements.insert(key, query);
+      }
+      return(&*it);
+   };
+
+   timer.start();
+   m_canceled.storeRelease(0);
+   m_names.clear();
+
+   if(info.isNull())
+   {
+      report.error=QString("No table '%1'").arg(m_table);
+      return(report);
+   }
+
+   // The first line of CSV names the columns; JSON Lines names them per record
+   QStringList fields;
+   QJsonObject object;
+   QVector<int> csvColumns;
+   qint64 recordLine=0;
+   if( format == FormatCsv )
+   {
+      if( !readCsvRecord(device, keys, line) )
+      {
+         report.error="File is empty";
+         return(report);
+      }
+      if( !keys.isEmpty() && keys[0].startsWith(QChar(0xfeff)) )
+      {
+         keys[0].remove(0, 1);
+      }
+      for(const QString &key: keys)
+      {
+         int index=info->indexOf(key);
+         if( ( index < 0 ) || csvColumns.contains(index) )
+         {
+            ignore(key);
+            columnOf << -1;
+            continue;
+         }
+         columnOf << index;
+         csvColumns << index;
+      }
+      if(csvColumns.isEmpty())
+      {
+         report.error="No column of the file is in table " + m_table;
+         return(report);
+      }
+      QString reason;
+      if( !statement(csvColumns, reason) )
+      {
+         report.error=reason;
+         return(report);
+      }
+   }
+
+   // Text of a column to the value to bind; false if it can not be resolved
+   auto convert=[&](const CColumnInfo &column, const QVariant &text
+                    , QVariant &value, QString &reason) -> bool {
+      if( text.isNull() || ( text.toString().isEmpty() ) )
+      {
+         value=QVariant();
+         return(true);
+      }
+      if( !column.isForeignKey() )
+      {
+         value=text;
+         return(true);
+      }
+      const QHash<QString, qint64> &ids=names(column.foreignTable, db);
+      auto it=ids.constFind(text.toString());
+      if( it == ids.constEnd() )
+      {
+         reason=QString("No %1 named '%2'").arg(column.foreignTable, text.toString());
+         return(false);
+      }
+      value=*it;
+      return(true);
+   };
+
+   // The rows of the batch are lost if the COMMIT fails
+   auto commit=[&]() -> bool {
+      if( connection.commit() )
+      {
+         batch=0;
+         return(true);
+      }
+      report.error=QString("Could not commit the rows up to line %1: %2")
+            .arg(recordLine).arg(connection.lastError().text());
+      connection.rollback();
+      report.inserted-=batch;
+      batch=0;
+      return(false);
+   };
+
+   connection.transaction();
+   batchTimer.start();
+
+   while( !m_canceled.loadAcquire() )
+   {
+      QVector<int> indexes;
+      QVector<QVariant> values;
+      QString reason;
+      bool valid=true;
+
+      if( ( ++records % ProgressRows ) == 0 )
+      {
+         emit progress(report.inserted, device->pos(), device->size());
+      }
+
+      if( format == FormatCsv )
+      {
+         recordLine=line+1;
+         if( !readCsvRecord(device, fields, line) )
+         {
+            break;
+         }
+         if( ( fields.size() == 1 ) && fields[0].isEmpty() )
+         {
+            continue;
+         }
+         if( fields.size() != columnOf.size() )
+         {
+            reject(recordLine, QString("%1 fields instead of %2")
+                   .arg(fields.size()).arg(columnOf.size()));
+            continue;
+         }
+         indexes=csvColumns;
+         values.resize(indexes.size());
+         for(int i1=0, position=0; valid && ( i1<fields.size() ); i1++)
+         {
+            if( columnOf[i1] >= 0 )
+            {
+               valid=convert(info->columns[columnOf[i1]], fields[i1]
+                             , values[position++], reason);
+            }
+         }
+      }
+      else
+      {
+         if( device->atEnd() )
+         {
+            break;
+         }
+         QByteArray text=device->readLine().trimmed();
+         line++;
+         recordLine=line;
+         if( text.isEmpty() )
+         {
+            continue;
+         }
+         QJsonParseError error;
+         object=QJsonDocument::fromJson(text, &error).object();
+         if( error.error != QJsonParseError::NoError )
+         {
+            reject(recordLine, error.errorString());
+            continue;
+         }
+
+         // Columns missing in the record keep their default
+         QStringList unknown;
+         for(auto it=object.constBegin(); valid && ( it!=object.constEnd() ); ++it)
+         {
+            int index=info->indexOf(it.key());
+            if( index < 0 )
+            {
+               unknown << it.key();
+               ignore(it.key());
+               continue;
+            }
+            // Nested values are kept as JSON text
+            QVariant text;
+            if( it.value().isObject() )
+            {
+               text=QString::fromUtf8( QJsonDocument(it.value().toObject())
+                                       .toJson(QJsonDocument::Compact) );
+            }
+            else if( it.value().isArray() )
+            {
+               text=QString::fromUtf8( QJsonDocument(it.value().toArray())
+                                       .toJson(QJsonDocument::Compact) );
+            }
+            else
+            {
+               text=it.value().toVariant();
+            }
+            indexes << index;
+            values.append(QVariant());
+            valid=convert(info->columns[index], text, values.last(), reason);
+         }
+         if( !unknown.isEmpty() && ( report.unknown.size() < rejectLimit ) )
+         {
+            report.unknown.append( { recordLine, unknown.join(", ") } );
+         }
+         if( valid && indexes.isEmpty() )
+         {
+            reason="No key of the record is a column of table " + m_table;
+            valid=false;
+         }
+      }
+
+      if(!valid)
+      {
+         reject(recordLine, reason);
+         continue;
+      }
+
+      QSqlQuery *insert=statement(indexes, reason);
+      if(!insert)
+      {
+         reject(recordLine, reason);
+         continue;
+      }
+      for(int i1=0; i1<values.size(); i1++)
+      {
+         insert->bindValue(i1, values[i1]);
+      }
+      if( !insert->exec() )
+      {
+         // Only this statement failed, the transaction goes on
+         reject(recordLine, insert->lastError().text());
+         continue;
+      }
+      report.inserted++;
+
+      // Other connections wait for the lock; no longer than 'BatchMsecs'
+      if( ( ++batch >= BatchSize ) || ( batchTimer.elapsed() >= BatchMsecs ) )
+      {
+         if(!commit())
+         {
+            break;
+         }
+         connection.transaction();
+         batchTimer.start();
+      }
+   }
+
+   for(QSqlQuery &insert: statements)
+   {
+      insert.finish();
+   }
+   if( report.error.isEmpty() )
+   {
+      commit();
+   }
+
+   report.msecs=timer.elapsed();
+   emit progress(report.inserted, device->pos(), device->size());
+   qCDebug(lcTiming, "Imported %lld rows into '%s' in %lld ms, %lld rejected"
+           , report.inserted, qPrintable(m_table), report.msecs
+           , report.rejectedCount);
+
+   return(report);
+}
+
+
+int CImporter::importFiles(const QStringList &fileNames, const QString &table)
+{
+   int ret=0;
+
+   for(const QString &fileName: fileNames)
+   {
+      QString target=table.isEmpty() ? QFileInfo(fileName).completeBaseName() : table;
+      CImporter importer(target);
+      QObject::connect(&importer, &CImporter::progress, [](qint64 rows){
+         qWarning("%lld rows", rows);
+      });
+
+      CImportReport report=importer.run(fileName);
+      if( !report.error.isEmpty() )
+      {
+         qWarning("Could not import '%s': %s; %lld rows inserted before"
+                  , qPrintable(fileName), qPrintable(report.error), report.inserted);
+         return(1);
+      }
+
+      if( !report.ignored.isEmpty() )
+      {
+         qWarning("Ignored columns: %s", qPrintable(report.ignored.join(", ")));
+      }
+      for(const auto &unknown: report.unknown)
+      {
+         qWarning("%s:%lld: ignored %s", qPrintable(fileName), unknown.first
+                  , qPrintable(unknown.second));
+      }
+      for(const auto &rejected: report.rejected)
+      {
+         qWarning("%s:%lld: %s", qPrintable(fileName), rejected.first
+                  , qPrintable(rejected.second));
+      }
+      qWarning("%s: %lld rows inserted into '%s' (%lld rows/s), %lld rejected"
+               , qPrintable(fileName), report.inserted, qPrintable(target)
+               , report.inserted * 1000 / qMax<qint64>(report.msecs, 1)
+               , report.rejectedCount);
+      if(report.rejectedCount)
+      {
+         ret=2;
+      }
+   }
+
+   return(ret);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
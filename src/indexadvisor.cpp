@@ -0,0 +1,433 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       indexadvisor.cpp
+ * @brief      Propose or create indexes for the queries issued by the tabs
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <indexadvisor.hpp>
+#include <connection.hpp>
+#include <reconcile.hpp>
+#include <rowmodel.hpp>
+#include <searchindex.hpp>
+#include <dbprofile.hpp>
+#include <schema.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static QString milliseconds(qint64 nsecs)
+{
+   if(nsecs < 0)
+   {
+      return("failed");
+   }
+   return( QString::number(nsecs / 1000000.0, 'f', 3) + " ms" );
+}
+
+
+CIndexAdvisor::CIndexAdvisor()
+{
+}
+
+
+QVariant CIndexAdvisor::sample(const QString &table, const QString &column) const
+{
+   QSqlQuery query;
+
+   // Any existing value; the plan does not depend on it, the timing does
+   if( query.exec( QString("SELECT %1 FROM %2 WHERE %1 IS NOT NULL LIMIT 1")
+                   .arg(CConnection::escapeField(column), CConnection::escapeTable(table)) )
+       && query.next() )
+   {
+      return( query.value(0) );
+   }
+
+   return( QVariant(0) );
+}
+
+
+QVector<CIndexAdvisor::Probe> CIndexAdvisor::probes(const QString &table) const
+{
+   CTableInfoPtr info=CSchema::table(table);
+   QString escaped=CConnection::escapeTable(table);
+   CReconciler reconciler(table);
+   // Plans name tables of attached files without schema
+   QString alias=CSchema::baseName(table);
+   QVector<Probe> references;
+   QVector<Probe> probes;
+   Probe probe;
+
+   probe.table=table;
+
+   for(const CColumnInfo &column: info->columns)
+   {
+      if( !column.isForeignKey() )
+      {
+         continue;
+      }
+
+      const QString &fieldName=column.name;
+      const QString &foreignTable=column.foreignTable;
+
+      // Same joins as the list; they hit the id of the referenced table,
+      // which is the rowid, so they need no index
+      reconciler.addRelation(fieldName, foreignTable);
+
+      // Finding the rows referencing a record, e.g. before removing it
+      probe.title="rows referencing " + foreignTable;
+      probe.statement=QString("SELECT COUNT(*) FROM %1 WHERE %2 = ?")
+            .arg(escaped, CConnection::escapeField(fieldName));
+      probe.values={ sample(table, fieldName) };
+      probe.candidates={ { table, fieldName, alias } };
+      references.append(probe);
+   }
+
+   CRowQuery rowQuery=reconciler.rowQuery( CSearchClause() );
+
+   probe.title="list count";
+   probe.statement=rowQuery.countStatement();
+   probe.values=rowQuery.values;
+   probe.candidates.clear();
+   probes.append(probe);
+
+   probe.title="list first page";
+   probe.statement=rowQuery.pageStatement(false, CRowModel::PageSize);
+   probes.append(probe);
+
+   // Typing into the search box; 'LIKE %text%' can not use an index, the
+   // plan and time of the search are reported nevertheless
+   CSearchIndex searchIndex(table);
+   QString text=info->contains("Name") ? sample(table, "Name").toString().left(3) : QString();
+   CRowQuery searchQuery=reconciler.rowQuery( searchIndex.clause( text.isEmpty() ? "a" : text ) );
+
+   probe.title="search count";
+   probe.statement=searchQuery.countStatement();
+   probe.values=searchQuery.values;
+   probes.append(probe);
+
+   probe.title="search first page";
+   probe.statement=searchQuery.pageStatement(false, CRowModel::PageSize);
+   probes.append(probe);
+
+   probe.title="record by id";
+   probe.statement=QString("SELECT * FROM %1 WHERE %1.id = ?").arg(escaped);
+   probe.values={ sample(table, "id") };
+   probe.candidates={ { table, "id", alias } };
+   probes.append(probe);
+
+   if( info->contains("Name") )
+   {
+      // Relation combos and lists sorted by Name read id/Name in that order
+      Candidate candidate { table, "Name", alias };
+      candidate.order=true;
+      probe.title="Name order";
+      probe.statement=QString("SELECT id, Name FROM %1 ORDER BY Name LIMIT %2")
+            .arg(escaped).arg(CRowModel::PageSize);
+      probe.values.clear();
+      probe.candidates={ candidate };
+      probes.append(probe);
+   }
+
+   return( probes + references );
+}
+
+
+bool CIndexAdvisor::isIndexed(const QString &table, const QString &column) const
+{
+   QSqlQuery query;
+
+   // 'id INTEGER PRIMARY KEY' is the rowid itself
+   if( query.exec( CSchema::pragma("table_info", table) ) )
+   {
+      int keys=0;
+      bool rowid=false;
+      while(query.next())
+      {
+         if( query.value("pk").toInt() > 0 )
+         {
+            keys++;
+            rowid=( query.value("name").toString() == column )
+                  && ( query.value("type").toString().toUpper() == "INTEGER" );
+         }
+      }
+      if( rowid && ( keys == 1 ) )
+      {
+         return(true);
+      }
+   }
+
+   // Only an index starting with the column is of use for '= ?' and ORDER BY
+   QStringList indexes;
+   if( query.exec( CSchema::pragma("index_list", table) ) )
+   {
+      while(query.next())
+      {
+         indexes << query.value("name").toString();
+      }
+   }
+
+   // Indexes are in the file of their table
+   QString schema=CSchema::schemaOf(table);
+   for(const QString &index: indexes)
+   {
+      QString qualified=( schema == "main" ) ? index : schema + "." + index;
+      if( query.exec( CSchema::pragma("index_info", qualified) )
+          && query.next()
+          && ( query.value("name").toString() == column ) )
+      {
+         return(true);
+      }
+   }
+
+   return(false);
+}
+
+
+bool CIndexAdvisor::isWeak(const Probe &probe, const Candidate &candidate) const
+{
+   for(QString line: probe.plan)
+   {
+      // Older SQLite versions print 'SCAN TABLE x'
+      line.replace("SCAN TABLE ", "SCAN ");
+      line.replace("SEARCH TABLE ", "SEARCH ");
+      QStringList words=line.split(' ');
+
+      if( candidate.order && line.contains("TEMP B-TREE") )
+      {
+         return(true);
+      }
+
+      if( ( words.size() < 2 ) || ( words[1] != candidate.alias ) )
+      {
+         continue;
+      }
+
+      if( line.contains("AUTOMATIC")
+          || ( ( words[0] == "SCAN" ) && !line.contains("INDEX") ) )
+      {
+         return(true);
+      }
+   }
+
+   return(false);
+}
+
+
+QStringList CIndexAdvisor::plan(const Probe &probe) const
+{
+   QStringList plan;
+   QSqlQuery query;
+
+   query.prepare("EXPLAIN QUERY PLAN " + probe.statement);
+   for(const QVariant &value: probe.values)
+   {
+      query.addBindValue(value);
+   }
+
+   if( !query.exec() )
+   {
+      qWarning() << "Could not explain" << probe.statement << ":"
+                 << query.lastError().text();
+      return(plan);
+   }
+
+   while(query.next())
+   {
+      plan << query.value(3).toString();
+   }
+
+   return(plan);
+}
+
+
+qint64 CIndexAdvisor::measure(const Probe &probe) const
+{
+   QSqlQuery query;
+   QElapsedTimer timer;
+   qint64 best=-1;
+
+   if( !query.prepare(probe.statement) )
+   {
+      return(best);
+   }
+
+   // Best of three; the first run also warms the page cache
+   for(int i1=0; i1<3; i1++)
+   {
+      for(int i2=0; i2<probe.values.size(); i2++)
+      {
+         query.bindValue(i2, probe.values[i2]);
+      }
+      timer.start();
+      if( !query.exec() )
+      {
+         return(-1);
+      }
+      while(query.next())
+      {
+      }
+      qint64 nsecs=timer.nsecsElapsed();
+      if( ( best < 0 ) || ( nsecs < best ) )
+      {
+         best=nsecs;
+      }
+   }
+   query.finish();
+
+   return(best);
+}
+
+
+QString CIndexAdvisor::indexName(const Candidate &candidate)
+{
+   return( candidate.table + "__idx_" + candidate.column );
+}
+
+
+QString CIndexAdvisor::createStatement(const Candidate &candidate)
+{
+   // Every index contains the rowid, so '(Name)' also covers 'id, Name'.
+   // The schema goes to the index name; the table must not have one.
+   return( QString("CREATE INDEX IF NOT EXISTS %1 ON %2(%3)")
+         .arg(CConnection::escapeTable(indexName(candidate)), CConnection::escapeTable(CSchema::baseName(candidate.table))
+              , CConnection::escapeField(candidate.column)) );
+}
+
+
+bool CIndexAdvisor::run(bool create, QTextStream &out)
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QVector<Candidate> proposals;
+   QSet<QString> names;
+   bool success=true;
+
+   m_probes.clear();
+   CSchema::refresh();
+   for(const QString &table: CSchema::tables())
+   {
+      if( CSearchIndex::isIndexTable(table) || CDbProfile::isSettingsTable(table) )
+      {
+         continue;
+      }
+      m_probes += probes(table);
+   }
+
+   for(Probe &probe: m_probes)
+   {
+      probe.plan=plan(probe);
+      probe.nsecs=measure(probe);
+
+      for(const Candidate &candidate: probe.candidates)
+      {
+         if( names.contains( indexName(candidate) )
+             || !isWeak(probe, candidate)
+             || isIndexed(candidate.table, candidate.column) )
+         {
+            continue;
+         }
+         names.insert( indexName(candidate) );
+         proposals.append(candidate);
+      }
+   }
+
+   // DDL is transactional in SQLite; measure with the indexes, then decide
+   if( !proposals.isEmpty() )
+   {
+      db.transaction();
+      for(const Candidate &candidate: proposals)
+      {
+         QSqlQuery query;
+         if( !query.exec( createStatement(candidate) ) )
+         {
+            qWarning("Could not create index '%s': %s"
+                     , qPrintable(indexName(candidate))
+                     , qPrintable(query.lastError().text()));
+            success=false;
+            break;
+         }
+      }
+
+      if(success)
+      {
+         for(Probe &probe: m_probes)
+         {
+            probe.planAfter=plan(probe);
+            probe.nsecsAfter=measure(probe);
+         }
+      }
+
+      if( create && success )
+      {
+         success=db.commit();
+      }
+      else
+      {
+         db.rollback();
+      }
+   }
+
+   QString table;
+   for(const Probe &probe: m_probes)
+   {
+      if(probe.table != table)
+      {
+         table=probe.table;
+         out << CConnection::escapeTable(table) << "\n";
+      }
+      out << "   " << probe.title.leftJustified(32, ' ') << milliseconds(probe.nsecs);
+      if( probe.nsecsAfter >= 0 )
+      {
+         out << " -> " << milliseconds(probe.nsecsAfter);
+      }
+      out << "\n";
+      for(const QString &line: probe.plan)
+      {
+         out << "      " << line << "\n";
+      }
+      if( !probe.planAfter.isEmpty() && ( probe.planAfter != probe.plan ) )
+      {
+         for(const QString &line: probe.planAfter)
+         {
+            out << "    + " << line << "\n";
+         }
+      }
+   }
+
+   out << "\n";
+   if(proposals.isEmpty())
+   {
+      out << "No indexes missing\n";
+   }
+   else
+   {
+      out << ( ( create && success ) ? "Created indexes:\n" : "Proposed indexes:\n" );
+      for(const Candidate &candidate: proposals)
+      {
+         out << "   " << createStatement(candidate) << ";\n";
+      }
+   }
+   out.flush();
+
+   return(success);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
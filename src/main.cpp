@@ -16,6 +16,18 @@
 
 
 #include <warehouse.hpp>
+#include <searchindex.hpp>
+#include <searchscheduler.hpp>
+#include <workerpool.hpp>
+#include <queryprofiler.hpp>
+#include <editbuffer.hpp>
+#include <writequeue.hpp>
+#include <dbprofile.hpp>
+#include <indexadvisor.hpp>
+#include <exporter.hpp>
+#include <importer.hpp>
+#include <connection.hpp>
+#include <changefeed.hpp>
 #include <QtWidgets>
 
 
@@ -24,39 +36,211 @@
 
 int main(int argc, char * argv[])
 {
+   CWarehouse::startupTimer().start();
    Q_INIT_RESOURCE( warehouse );
-   QApplication app(argc, argv);
-
-   QCoreApplication::setApplicationName("warehouse");
-   QCoreApplication::setApplicationVersion("1.0");
-
    QCommandLineParser parser;
    parser.setApplicationDescription("Automatic form generator for SQLite databases");
    parser.addHelpOption();
    parser.addVersionOption();
    parser.addPositionalArgument("database", "SQLite database file");
+   parser.addPositionalArgument("attach", "Further database files of the workspace"
+                                , "[attach...]");
 
-   QCommandLineOption oDump("d", "Dump table", "table" );
+   QCommandLineOption oDump("d", "Dump table as Textile", "table" );
    parser.addOption( oDump );
 
-   parser.process(app);
+   QCommandLineOption oExport( QStringList() << "e" << "export"
+                                , "Export table without GUI; '*' for all tables"
+                                , "table" );
+   parser.addOption( oExport );
+
+   QCommandLineOption oFormat( "format"
+                                , "Format of --export: " + CExporter::formats().join(", ")
+                                , "format", "csv" );
+   parser.addOption( oFormat );
+
+   QCommandLineOption oImport( QStringList() << "i" << "import"
+                                , "Insert the rows of a CSV or JSON Lines file without GUI"
+                                , "file" );
+   parser.addOption( oImport );
+
+   QCommandLineOption oTable( QStringList() << "t" << "table"
+                                , "Table for --import; named like the file by default"
+                                , "table" );
+   parser.addOption( oTable );
+
+   QCommandLineOption oOutput( QStringList() << "o" << "output"
+                                , "File, or directory for several tables; stdout by default"
+                                , "path" );
+   parser.addOption( oOutput );
+
+   QCommandLineOption oFullText( QStringList() << "f" << "fulltext"
+                                , "Maintain a full text index (FTS5) per table for searching" );
+   parser.addOption( oFullText );
+
+   QCommandLineOption oDebounce( "debounce"
+                                , "Wait <msec> after typing before searching"
+                                , "msec", QString::number(CSearchScheduler::debounce()) );
+   parser.addOption( oDebounce );
+
+   QCommandLineOption oBatched( QStringList() << "b" << "batched"
+                                , "Collect edits and write them together" );
+   parser.addOption( oBatched );
+
+   QCommandLineOption oFlushInterval( "flush-interval"
+                                , "In batched mode, write edits <msec> after the first one; 0 on row change"
+                                , "msec", QString::number(CEditBuffer::flushInterval()) );
+   parser.addOption( oFlushInterval );
+
+   QCommandLineOption oWriteBehind( "write-behind"
+                                , "Write edits in a thread of its own, committed in groups" );
+   parser.addOption( oWriteBehind );
+
+   QCommandLineOption oProfile( "profile"
+                                , "Connection tuning: " + CDbProfile::profiles().join(", ")
+                                , "profile" );
+   parser.addOption( oProfile );
+
+   QCommandLineOption oPragma( "pragma"
+                                , "Override a setting of the profile, e.g. 'cache_size=-32768'"
+                                , "name=value" );
+   parser.addOption( oPragma );
+
+   QCommandLineOption oNoPrefetch( "no-prefetch"
+                                , "Do not load the next tabs in the background" );
+   parser.addOption( oNoPrefetch );
+
+   QCommandLineOption oThreads( "threads"
+                                , "Number of threads loading tabs; one per core by default"
+                                , "n", QString::number(CWorkerPool::threads()) );
+   parser.addOption( oThreads );
+
+   QCommandLineOption oSlowQuery( "slow-query"
+                                , "Log queries taking longer than <msec> with their plan; -1 for none"
+                                , "msec", QString::number(CQueryProfiler::threshold()) );
+   parser.addOption( oSlowQuery );
+
+   QCommandLineOption oPollInterval( "poll-interval"
+                                , "Check every <msec> for changes by other processes; 0 for never"
+                                , "msec", QString::number(CChangeFeed::pollInterval()) );
+   parser.addOption( oPollInterval );
+
+   QCommandLineOption oAdviseIndexes( "advise-indexes"
+                                , "Print query plans and propose missing indexes" );
+   parser.addOption( oAdviseIndexes );
+
+   QCommandLineOption oCreateIndexes( "create-indexes"
+                                , "Create the indexes proposed by --advise-indexes" );
+   parser.addOption( oCreateIndexes );
+
+   QCommandLineOption oReadOnly( "readonly"
+                                , "Open the files read only and without locking; nobody may write them meanwhile" );
+   parser.addOption( oReadOnly );
+
+   QCommandLineOption oInMemory( "in-memory"
+                                , "Copy the files into memory and show the copy; implies --readonly" );
+   parser.addOption( oInMemory );
+
+   // Has to be known before the application object exists; without widgets
+   // no display is needed. Errors are reported by 'process()' below.
+   QStringList arguments;
+   for(int i1=0; i1<argc; i1++)
+   {
+      arguments << QString::fromLocal8Bit(argv[i1]);
+   }
+   parser.parse(arguments);
+   bool headless=parser.isSet( oDump ) || parser.isSet( oExport ) || parser.isSet( oImport )
+         || parser.isSet( oAdviseIndexes ) || parser.isSet( oCreateIndexes );
+
+   QScopedPointer<QCoreApplication> app( headless
+                                         ? new QCoreApplication(argc, argv)
+                                         : new QApplication(argc, argv) );
+
+   QCoreApplication::setApplicationName("warehouse");
+   QCoreApplication::setApplicationVersion("1.0");
+
+   parser.process(*app);
 
    if(parser.positionalArguments().count() < 1)
    {
       qFatal("Database has to be given.");
    }
 
-   CWarehouse warehouse(parser.positionalArguments()[0]);
+   CSearchIndex::setEnabled( parser.isSet( oFullText ) );
+   CSearchScheduler::setDebounce( parser.value( oDebounce ).toInt() );
+   if( parser.isSet( oProfile ) && !CDbProfile::setProfile( parser.value( oProfile ) ) )
+   {
+      qFatal("Unknown profile '%s'", qPrintable( parser.value( oProfile ) ));
+   }
+   for(const QString &pragma: parser.values( oPragma ))
+   {
+      if( !CDbProfile::set( pragma ) )
+      {
+         qFatal("Invalid setting '%s'", qPrintable( pragma ));
+      }
+   }
+   CWorkerPool::setThreads( parser.value( oThreads ).toInt() );
+   CQueryProfiler::setThreshold( parser.value( oSlowQuery ).toInt() );
+   CChangeFeed::setPollInterval( parser.value( oPollInterval ).toInt() );
+   CEditBuffer::setEnabled( parser.isSet( oBatched ) );
+   CEditBuffer::setFlushInterval( parser.value( oFlushInterval ).toInt() );
+   CWriteQueue::setEnabled( parser.isSet( oWriteBehind ) );
+   if( parser.isSet( oWriteBehind ) && parser.isSet( oBatched ) )
+   {
+      qFatal("Either --batched or --write-behind can be used");
+   }
+   CConnection::setReadOnly( parser.isSet( oReadOnly ) );
+   CConnection::setInMemory( parser.isSet( oInMemory ) );
+   if( CConnection::isReadOnly()
+       && ( parser.isSet( oImport ) || parser.isSet( oCreateIndexes ) ) )
+   {
+      qFatal("Can not write a database opened read only");
+   }
 
-   if( parser.isSet( oDump ) )
+   if(headless)
    {
-      warehouse.dump( parser.value(oDump) );
-      return(0);
+      QStringList files=parser.positionalArguments();
+      QSqlError err=CConnection::openDefault( files.takeFirst() );
+      for(const QString &file: files)
+      {
+         if( err.type() == QSqlError::NoError )
+         {
+            err=CConnection::attach( file );
+         }
+      }
+      if( err.type() != QSqlError::NoError )
+      {
+         qFatal("Could not open database: %s", qPrintable( err.text() ));
+      }
+
+      if( parser.isSet( oAdviseIndexes ) || parser.isSet( oCreateIndexes ) )
+      {
+         QTextStream out(stdout);
+         CIndexAdvisor advisor;
+         return( advisor.run( parser.isSet( oCreateIndexes ), out ) ? 0 : 1 );
+      }
+
+      if( parser.isSet( oImport ) )
+      {
+         return( CImporter::importFiles( parser.values( oImport ), parser.value( oTable ) ) );
+      }
+
+      CExporter::Format format=CExporter::FormatTextile;
+      if( ( parser.isSet( oExport ) || parser.isSet( oFormat ) )
+          && !CExporter::parseFormat( parser.value( oFormat ), format ) )
+      {
+         qFatal("Unknown format '%s'", qPrintable( parser.value( oFormat ) ));
+      }
+      QStringList tables=parser.values( oExport ) + parser.values( oDump );
+      return( CExporter::run( tables, format, parser.value( oOutput ) ) );
    }
 
+   CWarehouse warehouse(parser.positionalArguments());
+
+   warehouse.setPrefetch( !parser.isSet( oNoPrefetch ) );
    warehouse.show();
 
-   return app.exec();
+   return app->exec();
 }
 
 
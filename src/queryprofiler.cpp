@@ -0,0 +1,347 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       queryprofiler.cpp
+ * @brief      Latency statistics and slow query log of all queries
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <queryprofiler.hpp>
+#include <connection.hpp>
+#include <changefeed.hpp>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QMutex>
+#include <QMap>
+#include <QHash>
+#include <QPair>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+Q_LOGGING_CATEGORY(lcTiming, "warehouse.timing", QtInfoMsg)
+
+
+enum
+{
+   /** @brief Slow queries kept for the diagnostics */
+   MaxSlowQueries=200,
+   /** @brief Statements whose plan is kept */
+   MaxPlans=1000,
+};
+
+
+static int s_threshold=100;
+static QMutex s_mutex;
+static QMap< QPair<QString, int>, CQueryStats > s_stats;
+static QVector<CSlowQuery> s_slow;
+static QHash<QString, QStringList> s_plans;
+
+
+void CQueryProfiler::setThreshold(int msec)
+{
+   s_threshold=msec;
+}
+
+
+int CQueryProfiler::threshold()
+{
+   return(s_threshold);
+}
+
+
+QString CQueryProfiler::kindName(int kind)
+{
+   static const char *names[Kinds]=
+   {
+      "select", "filter", "relation", "count", "insert", "update", "delete"
+   };
+
+   if( ( kind < 0 ) || ( kind >= Kinds ) )
+   {
+      return(QString());
+   }
+
+   return( names[kind] );
+}
+
+
+qint64 CQueryProfiler::bucketLimit(int bucket)
+{
+   // 0.25 ms, 0.5 ms, 1 ms ... 256 ms, more
+   if( bucket >= Buckets - 1 )
+   {
+      return(-1);
+   }
+
+   return( qint64(250) << bucket );
+}
+
+
+QStringList CQueryProfiler::explain(const QString &sql, const QVariantList &values
+                                    , const QSqlDatabase &db)
+{
+   QStringList plan;
+   QSqlQuery query(db);
+
+   query.setForwardOnly(true);
+   if( !query.prepare("EXPLAIN QUERY PLAN " + sql) )
+   {
+      // E.g. 'COMMIT'; nothing to explain
+      return(plan);
+   }
+   for(const QVariant &value: values)
+   {
+      query.addBindValue(value);
+   }
+
+   if( query.exec() )
+   {
+      while(query.next())
+      {
+         plan << query.value(3).toString();
+      }
+   }
+
+   return(plan);
+}
+
+
+void CQueryProfiler::record(const QString &table, Kind kind, const QString &sql
+                            , const QVariantList &values, const QSqlDatabase &db
+                            , qint64 nsecs, int rows)
+{
+   bool slow=( s_threshold >= 0 ) && ( nsecs >= qint64(s_threshold) * 1000000 );
+   bool slowest;
+   bool planned;
+   QStringList plan;
+   int bucket=0;
+
+   while( ( bucket < Buckets - 1 ) && ( nsecs >= bucketLimit(bucket) * 1000 ) )
+   {
+      bucket++;
+   }
+
+   {
+      QMutexLocker locker(&s_mutex);
+      CQueryStats &stats=s_stats[ qMakePair(table, int(kind)) ];
+
+      if(stats.buckets.isEmpty())
+      {
+         stats.table=table;
+         stats.kind=kind;
+         stats.buckets.fill(0, Buckets);
+      }
+      stats.count++;
+      stats.nsecs += nsecs;
+      stats.rows += rows;
+      stats.buckets[bucket]++;
+      slowest=( nsecs > stats.maxNsecs );
+      if(slowest)
+      {
+         stats.maxNsecs=nsecs;
+      }
+
+      if( !slow && !slowest )
+      {
+         return;
+      }
+
+      auto it=s_plans.constFind(sql);
+      planned=( it != s_plans.constEnd() );
+      if(planned)
+      {
+         plan=*it;
+      }
+   }
+
+   // Explained without the lock; the statement runs on this thread's connection
+   if(!planned)
+   {
+      plan=explain(sql, values, db);
+   }
+
+   QMutexLocker locker(&s_mutex);
+
+   if(!planned)
+   {
+      if( s_plans.size() >= MaxPlans )
+      {
+         s_plans.clear();
+      }
+      s_plans.insert(sql, plan);
+   }
+
+   CQueryStats &stats=s_stats[ qMakePair(table, int(kind)) ];
+   if( slowest && ( stats.maxNsecs == nsecs ) )
+   {
+      stats.slowest=sql;
+      stats.plan=plan;
+   }
+
+   if(slow)
+   {
+      qWarning("Slow %s in '%s': %lld ms, %d rows: %s [%s]"
+               , qPrintable(kindName(kind)), qPrintable(table), nsecs / 1000000
+               , rows, qPrintable(sql), qPrintable(plan.join("; ")));
+
+      if( s_slow.size() >= MaxSlowQueries )
+      {
+         s_slow.removeFirst();
+      }
+      s_slow.append( { QDateTime::currentDateTime(), table, kind, sql, nsecs
+                       , rows, plan } );
+   }
+}
+
+
+QVector<CQueryStats> CQueryProfiler::stats()
+{
+   QMutexLocker locker(&s_mutex);
+   QVector<CQueryStats> stats;
+
+   stats.reserve(s_stats.size());
+   for(const CQueryStats &entry: s_stats)
+   {
+      stats.append(entry);
+   }
+
+   return(stats);
+}
+
+
+QVector<CSlowQuery> CQueryProfiler::slowQueries()
+{
+   QMutexLocker locker(&s_mutex);
+
+   return(s_slow);
+}
+
+
+void CQueryProfiler::reset()
+{
+   QMutexLocker locker(&s_mutex);
+
+   s_stats.clear();
+   s_slow.clear();
+}
+
+
+CQueryTimer::CQueryTimer(const QString &table, CQueryProfiler::Kind kind
+                         , const QString &sql, const QVariantList &values
+                         , const QSqlDatabase &db)
+   :m_table(table)
+   ,m_kind(kind)
+   ,m_sql(sql)
+   ,m_values(values)
+   ,m_db(db)
+{
+   m_timer.start();
+}
+
+
+CQueryTimer::~CQueryTimer()
+{
+   finish(0);
+}
+
+
+void CQueryTimer::finish(int rows)
+{
+   if(m_finished)
+   {
+      return;
+   }
+   m_finished=true;
+
+   CQueryProfiler::record(m_table, m_kind, m_sql, m_values, m_db
+                          , m_timer.nsecsElapsed(), rows);
+}
+
+
+CProfiledTableModel::CProfiledTableModel(QObject *parent)
+   :QSqlTableModel(parent)
+{
+}
+
+
+bool CProfiledTableModel::select()
+{
+   CQueryTimer timer(tableName(), CQueryProfiler::Select, selectStatement()
+                     , QVariantList(), database());
+   bool ret=QSqlTableModel::select();
+
+   timer.finish(rowCount());
+
+   return(ret);
+}
+
+
+bool CProfiledTableModel::insertRowIntoTable(const QSqlRecord &values)
+{
+   QSqlDriver *driver=database().driver();
+
+   return( write(CQueryProfiler::Insert
+                 , driver->sqlStatement(QSqlDriver::InsertStatement
+                                        , tableName(), values, false)
+                 , [&](){ return( QSqlTableModel::insertRowIntoTable(values) ); } ) );
+}
+
+
+bool CProfiledTableModel::updateRowInTable(int row, const QSqlRecord &values)
+{
+   QSqlDriver *driver=database().driver();
+
+   return( write(CQueryProfiler::Update
+                 , driver->sqlStatement(QSqlDriver::UpdateStatement
+                                        , tableName(), values, false)
+                 + " " + driver->sqlStatement(QSqlDriver::WhereStatement
+                                        , tableName(), primaryValues(row), false)
+                 , [&](){ return( QSqlTableModel::updateRowInTable(row, values) ); } ) );
+}
+
+
+bool CProfiledTableModel::deleteRowFromTable(int row)
+{
+   QSqlDriver *driver=database().driver();
+
+   return( write(CQueryProfiler::Delete
+                 , driver->sqlStatement(QSqlDriver::DeleteStatement
+                                        , tableName(), QSqlRecord(), false)
+                 + " " + driver->sqlStatement(QSqlDriver::WhereStatement
+                                        , tableName(), primaryValues(row), false)
+                 , [&](){ return( QSqlTableModel::deleteRowFromTable(row) ); } ) );
+}
+
+
+bool CProfiledTableModel::write(CQueryProfiler::Kind kind, const QString &sql
+                                , const std::function<bool()> &statement)
+{
+   CQueryTimer timer(tableName(), kind, sql, QVariantList(), database());
+   // The tab showing this model knows the row already
+   CChangeOrigin origin(this);
+   bool ret=statement();
+
+   timer.finish(ret ? 1 : 0);
+   if(ret)
+   {
+      CChangeFeed::written( tableName(), this );
+   }
+
+   return(ret);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
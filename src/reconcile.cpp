@@ -0,0 +1,213 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       reconcile.cpp
+ * @brief      Count visible/total rows and find rows hidden by broken keys
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <reconcile.hpp>
+#include <connection.hpp>
+#include <statementcache.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CReconciler::CReconciler(const QString &table)
+   :m_table(table)
+{
+}
+
+
+void CReconciler::addRelation(const QString &column, const QString &foreignTable)
+{
+   m_relations.append( { column, foreignTable } );
+}
+
+
+void CReconciler::clearRelations()
+{
+   m_relations.clear();
+}
+
+
+QString CReconciler::joinClause() const
+{
+   QString join;
+   QString table=CConnection::escapeTable(m_table);
+
+   for(int i1=0; i1<m_relations.size(); i1++)
+   {
+      join += QString(" LEFT JOIN %1 r%2 ON r%2.id = %3.%4")
+            .arg(CConnection::escapeTable(m_relations[i1].foreignTable))
+            .arg(i1)
+            .arg(table, CConnection::escapeField(m_relations[i1].column));
+   }
+
+   return(join);
+}
+
+
+QString CReconciler::missingCondition() const
+{
+   QStringList missing;
+
+   for(int i1=0; i1<m_relations.size(); i1++)
+   {
+      missing << QString("r%1.id IS NULL").arg(i1);
+   }
+
+   if(missing.isEmpty())
+   {
+      return("0");
+   }
+
+   return( "(" + missing.join(" OR ") + ")" );
+}
+
+
+bool CReconciler::isMissing(qint64 id) const
+{
+   QString table=CConnection::escapeTable(m_table);
+   bool missing=false;
+
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(
+            QString("SELECT %1 FROM %2%3 WHERE %2.id = ?")
+            .arg(missingCondition(), table, joinClause()) );
+   query->addBindValue(id);
+   if( query->exec() && query->next() )
+   {
+      missing=query->value(0).toBool();
+   }
+   query->finish();
+
+   return(missing);
+}
+
+
+CRowQuery CReconciler::rowQuery(const CSearchClause &clause) const
+{
+   CRowQuery query;
+   QString table=CConnection::escapeTable(m_table);
+
+   query.from=table + clause.join;
+   for(int i1=0; i1<m_relations.size(); i1++)
+   {
+      query.from += QString(" JOIN %1 r%2 ON r%2.id = %3.%4")
+            .arg(CConnection::escapeTable(m_relations[i1].foreignTable))
+            .arg(i1)
+            .arg(table, CConnection::escapeField(m_relations[i1].column));
+   }
+
+   query.where=clause.where;
+   query.key=clause.order;
+   query.id=table + ".id";
+   query.name=table + ".Name";
+   query.values=clause.values;
+   query.table=m_table;
+
+   return(query);
+}
+
+
+QString CReconciler::countStatement(const QString &filter) const
+{
+   QString missing=missingCondition();
+   QString visible=QString("NOT %1").arg(missing);
+
+   if(!filter.isEmpty())
+   {
+      visible += " AND (" + filter + ")";
+   }
+
+   // One pass for all three counters
+   return( QString(
+         "SELECT COUNT(*)"
+         ", COALESCE(SUM(CASE WHEN %1 THEN 1 ELSE 0 END), 0)"
+         ", COALESCE(SUM(CASE WHEN %2 THEN 1 ELSE 0 END), 0)"
+         " FROM %3%4")
+         .arg(visible, missing, CConnection::escapeTable(m_table), joinClause()) );
+}
+
+
+QString CReconciler::missingStatement(int missingLimit) const
+{
+   if( m_relations.isEmpty() || ( missingLimit <= 0 ) )
+   {
+      return(QString());
+   }
+
+   // Anti-join for the report; only rows which are really hidden
+   return( QString(
+         "SELECT %1.id, %1.Name FROM %1%2 WHERE %3 ORDER BY %1.id LIMIT %4")
+         .arg(CConnection::escapeTable(m_table), joinClause(), missingCondition())
+         .arg(missingLimit) );
+}
+
+
+CReconcileReport CReconciler::run(const QString &filter, int missingLimit) const
+{
+   return( execute( countStatement(filter), missingStatement(missingLimit)
+                    , QSqlDatabase::database() ) );
+}
+
+
+CReconcileReport CReconciler::execute(const QString &countStatement
+                        , const QString &missingStatement, const QSqlDatabase &db)
+{
+   CReconcileReport report;
+
+   QSqlQuery query(db);
+   query.setForwardOnly(true);
+   if( !query.exec(countStatement) )
+   {
+      qWarning() << "Could not count:" << query.lastError().text();
+      return(report);
+   }
+
+   if(query.next())
+   {
+      report.total=query.value(0).toInt();
+      report.visible=query.value(1).toInt();
+      report.missingCount=query.value(2).toInt();
+   }
+   query.finish();
+
+   if( ( report.missingCount == 0 ) || missingStatement.isEmpty() )
+   {
+      return(report);
+   }
+
+   QSqlQuery missingQuery(db);
+   missingQuery.setForwardOnly(true);
+   if( !missingQuery.exec(missingStatement) )
+   {
+      qWarning() << "Could not reconcile:" << missingQuery.lastError().text();
+      return(report);
+   }
+
+   while(missingQuery.next())
+   {
+      report.missing.append( { missingQuery.value(0).toLongLong()
+                             , missingQuery.value(1).toString() } );
+   }
+
+   return(report);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,406 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       relationcache.cpp
+ * @brief      Shared id/Name models of the tables referenced by foreign keys
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <relationcache.hpp>
+#include <connection.hpp>
+#include <statementcache.hpp>
+#include <searchindex.hpp>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <queryprofiler.hpp>
+#include <QSqlError>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CLookupModel::CLookupModel(const QString &table, QObject *parent)
+   :QAbstractTableModel(parent)
+   ,m_table(table)
+{
+   connect(CChangeFeed::instance(), &CChangeFeed::changed, this, &CLookupModel::changed);
+}
+
+
+void CLookupModel::setPrefix(const QString &prefix)
+{
+   if( prefix == m_prefix )
+   {
+      return;
+   }
+   m_prefix=prefix;
+   reload();
+}
+
+
+void CLookupModel::reload()
+{
+   beginResetModel();
+   m_pending=false;
+   m_rows.clear();
+   m_index.clear();
+   m_atEnd=false;
+   append( readPage() );
+   endResetModel();
+}
+
+
+void CLookupModel::invalidate()
+{
+   if(m_pending)
+   {
+      return;
+   }
+   m_pending=true;
+   QTimer::singleShot(0, this, &CLookupModel::reload);
+}
+
+
+CLookupModel::Rows CLookupModel::readPage()
+{
+   QStringList conditions;
+   QVariantList values;
+   Rows rows;
+
+   if(m_prefix.isEmpty())
+   {
+      // NULL would stop the keyset; such rows have nothing to show anyway
+      conditions << "Name IS NOT NULL";
+   }
+   else
+   {
+      // Names starting with the prefix as a range of the index; unlike LIKE
+      // case sensitive, as 'patch()' checks them
+      QString end=CSearchIndex::prefixEnd(m_prefix);
+      conditions << "Name >= ?";
+      values << m_prefix;
+      if( !end.isEmpty() )
+      {
+         conditions << "Name < ?";
+         values << end;
+      }
+   }
+
+   if(!m_rows.isEmpty())
+   {
+      conditions << "(Name, id) > (?, ?)";
+      values << m_rows.last().second << m_rows.last().first;
+   }
+
+   QSqlDatabase db=QSqlDatabase::database();
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(
+            QString("SELECT id, Name FROM %1 WHERE %2 ORDER BY Name, id LIMIT %3")
+            .arg(CConnection::escapeTable(m_table), conditions.join(" AND ")).arg(PageSize), db );
+   for(const QVariant &value: values)
+   {
+      query->addBindValue(value);
+   }
+
+   CQueryTimer timer(m_table, CQueryProfiler::Relation, query->lastQuery(), values, db);
+   if( !query->exec() )
+   {
+      qWarning("Could not read '%s': %s", qPrintable(m_table)
+               , qPrintable(query->lastError().text()));
+      m_atEnd=true;
+      return(rows);
+   }
+
+   rows.reserve(PageSize);
+   while(query->next())
+   {
+      rows.append( { query->value(0).toLongLong(), query->value(1).toString() } );
+   }
+   query->finish();
+   timer.finish(rows.size());
+
+   m_atEnd=( rows.size() < PageSize );
+
+   return(rows);
+}
+
+
+void CLookupModel::append(const Rows &rows)
+{
+   for(const auto &row: rows)
+   {
+      m_index.insert( row.first, m_rows.size() );
+      m_rows.append(row);
+   }
+}
+
+
+bool CLookupModel::canFetchMore(const QModelIndex &parent) const
+{
+   return( !parent.isValid() && !m_atEnd );
+}
+
+
+void CLookupModel::fetchMore(const QModelIndex &parent)
+{
+   if( parent.isValid() || m_atEnd )
+   {
+      return;
+   }
+
+   Rows rows=readPage();
+   if(rows.isEmpty())
+   {
+      return;
+   }
+   beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + rows.size() - 1);
+   append(rows);
+   endInsertRows();
+}
+
+
+int CLookupModel::rowCount(const QModelIndex &parent) const
+{
+   return( parent.isValid() ? 0 : m_rows.size() );
+}
+
+
+int CLookupModel::columnCount(const QModelIndex &parent) const
+{
+   return( parent.isValid() ? 0 : ColumnCount );
+}
+
+
+QVariant CLookupModel::data(const QModelIndex &index, int role) const
+{
+   if( !index.isValid() || ( index.row() >= m_rows.size() )
+       || ( ( role != Qt::DisplayRole ) && ( role != Qt::EditRole ) ) )
+   {
+      return( QVariant() );
+   }
+
+   if( index.column() == ColumnId )
+   {
+      return( m_rows[index.row()].first );
+   }
+
+   return( m_rows[index.row()].second );
+}
+
+
+int CLookupModel::rowOf(qint64 id) const
+{
+   return( m_index.value(id, -1) );
+}
+
+
+qint64 CLookupModel::rowId(int row) const
+{
+   if( ( row < 0 ) || ( row >= m_rows.size() ) )
+   {
+      return(-1);
+   }
+
+   return( m_rows[row].first );
+}
+
+
+QString CLookupModel::name(qint64 id) const
+{
+   int row=rowOf(id);
+
+   if(row >= 0)
+   {
+      return( m_rows[row].second );
+   }
+
+   return( readName(id).toString() );
+}
+
+
+QVariant CLookupModel::readName(qint64 id) const
+{
+   QVariant name;
+
+   QSqlDatabase db=QSqlDatabase::database();
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(
+            QString("SELECT Name FROM %1 WHERE id = ?").arg(CConnection::escapeTable(m_table)), db );
+   query->addBindValue(id);
+   CQueryTimer timer(m_table, CQueryProfiler::Relation, query->lastQuery(), { id }, db);
+   if( query->exec() && query->next() )
+   {
+      name=query->value(0);
+   }
+   query->finish();
+   timer.finish(1);
+
+   return(name);
+}
+
+
+void CLookupModel::changed(const CChanges &changes)
+{
+   int count=0;
+
+   for(const CChange &change: changes)
+   {
+      if( change.table != m_table )
+      {
+         continue;
+      }
+      // Beyond a page reading the first page again is cheaper
+      if( ( change.op == CChange::Unknown ) || ( ++count > PageSize ) )
+      {
+         invalidate();
+         return;
+      }
+   }
+
+   // A pending reload reads them anyway
+   if( !count || m_pending )
+   {
+      return;
+   }
+   // Nothing read yet, or nothing to compare with; no lookup per row
+   if(m_rows.isEmpty())
+   {
+      if(m_atEnd)
+      {
+         invalidate();
+      }
+      return;
+   }
+
+   for(const CChange &change: changes)
+   {
+      if( change.table == m_table )
+      {
+         patch(change);
+      }
+   }
+}
+
+
+void CLookupModel::patch(const CChange &change)
+{
+   // Same order as 'ORDER BY Name, id'. SQLite compares the UTF-8 bytes,
+   // QString the UTF-16 units, which differs beyond U+FFFF.
+   auto less=[](const Rows::value_type &a, const Rows::value_type &b){
+      QByteArray nameA=a.second.toUtf8();
+      QByteArray nameB=b.second.toUtf8();
+      return( ( nameA < nameB ) || ( ( nameA == nameB ) && ( a.first < b.first ) ) );
+   };
+   int row=rowOf(change.rowid);
+   QVariant name;
+
+   if( change.op != CChange::Delete )
+   {
+      name=readName(change.rowid);
+   }
+
+   // E.g. another column was edited
+   if( ( row >= 0 ) && !name.isNull() && ( m_rows[row].second == name.toString() ) )
+   {
+      return;
+   }
+
+   if(row >= 0)
+   {
+      beginRemoveRows(QModelIndex(), row, row);
+      m_rows.remove(row);
+      reindex();
+      endRemoveRows();
+   }
+
+   // Rows behind the last one read come with the next page
+   Rows::value_type entry( change.rowid, name.toString() );
+   if( name.isNull() || !entry.second.startsWith(m_prefix)
+       || ( !m_atEnd && ( m_rows.isEmpty() || !less(entry, m_rows.last()) ) ) )
+   {
+      return;
+   }
+
+   row=std::lower_bound(m_rows.begin(), m_rows.end(), entry, less) - m_rows.begin();
+   beginInsertRows(QModelIndex(), row, row);
+   m_rows.insert(row, entry);
+   reindex();
+   endInsertRows();
+}
+
+
+void CLookupModel::reindex()
+{
+   m_index.clear();
+   for(int i1=0; i1<m_rows.size(); i1++)
+   {
+      m_index.insert( m_rows[i1].first, i1 );
+   }
+}
+
+
+QHash< QString, QWeakPointer<CLookupModel> > &CRelationCache::models()
+{
+   static QHash< QString, QWeakPointer<CLookupModel> > models;
+
+   return(models);
+}
+
+
+QSharedPointer<CLookupModel> CRelationCache::model(const QString &table)
+{
+   QSharedPointer<CLookupModel> model=models().value(table).toStrongRef();
+
+   if(model.isNull())
+   {
+      model=QSharedPointer<CLookupModel>( new CLookupModel(table)
+                                        , &QObject::deleteLater );
+      model->reload();
+      models().insert(table, model);
+   }
+
+   return(model);
+}
+
+
+void CRelationCache::invalidate(const QString &table)
+{
+   QSharedPointer<CLookupModel> model=models().value(table).toStrongRef();
+
+   if(model.isNull())
+   {
+      // Nobody shows it; the next user loads it anyway
+      models().remove(table);
+      return;
+   }
+   model->invalidate();
+}
+
+
+int CRelationCache::count()
+{
+   int count=0;
+
+   for(const QWeakPointer<CLookupModel> &model: models())
+   {
+      if(!model.isNull())
+      {
+         count++;
+      }
+   }
+
+   return(count);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
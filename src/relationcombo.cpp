@@ -0,0 +1,173 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       relationcombo.cpp
+ * @brief      Combo box editing a foreign key by the Name of the record
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <relationcombo.hpp>
+#include <QSignalBlocker>
+#include <QLineEdit>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+CRelationCombo::CRelationCombo(QWidget *parent)
+   :QComboBox(parent)
+{
+   setEditable(true);
+   setInsertPolicy(QComboBox::NoInsert);
+
+   // Only choices of the user change the id; not resetting the model
+   connect(this, QOverload<int>::of(&QComboBox::activated), this, [this](int row){
+      if( m_lookup && ( m_lookup->rowId(row) >= 0 ) )
+      {
+         choose( m_lookup->rowId(row) );
+      }
+   });
+   connect(lineEdit(), &QLineEdit::textEdited, this, [this](const QString &text){
+      if( !m_lookup || text.isEmpty() )
+      {
+         dropMatches();
+         return;
+      }
+      if(!m_matches)
+      {
+         createMatches();
+      }
+      m_matches->setPrefix(text);
+      m_completer->complete();
+   });
+}
+
+
+void CRelationCombo::setLookup(const QSharedPointer<CLookupModel> &lookup)
+{
+   if(m_lookup)
+   {
+      m_lookup->disconnect(this);
+   }
+   m_lookup=lookup;
+
+   setModel(m_lookup.data());
+   setModelColumn(CLookupModel::ColumnName);
+   connect(m_lookup.data(), &QAbstractItemModel::modelReset, this, &CRelationCombo::select);
+   // The current row may have been renamed or moved
+   connect(m_lookup.data(), &QAbstractItemModel::rowsInserted, this, &CRelationCombo::select);
+   connect(m_lookup.data(), &QAbstractItemModel::rowsRemoved, this, &CRelationCombo::select);
+
+   // Matches of another table are of no use
+   dropMatches();
+
+   select();
+}
+
+
+void CRelationCombo::createMatches()
+{
+   // Matches of the typed prefix; the completer must not filter them again
+   m_matches=new CLookupModel(m_lookup->table(), this);
+   m_completer=new QCompleter(m_matches, this);
+   m_completer->setCompletionColumn(CLookupModel::ColumnName);
+   m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+   setCompleter(m_completer);
+
+   connect(m_completer, QOverload<const QModelIndex &>::of(&QCompleter::activated)
+           , this, [this](const QModelIndex &index){
+      choose( index.sibling(index.row(), CLookupModel::ColumnId).data() );
+   });
+}
+
+
+void CRelationCombo::dropMatches()
+{
+   // Also the default completer, which would filter the pages read only
+   setCompleter(nullptr);
+   if(m_completer)
+   {
+      m_completer->deleteLater();
+      m_completer=nullptr;
+   }
+   if(m_matches)
+   {
+      m_matches->deleteLater();
+      m_matches=nullptr;
+   }
+}
+
+
+void CRelationCombo::reset()
+{
+   if(m_lookup)
+   {
+      m_lookup->disconnect(this);
+   }
+   m_lookup.reset();
+   m_currentId=QVariant();
+
+   dropMatches();
+
+   QSignalBlocker blocker(this);
+   setCurrentIndex(-1);
+   setEditText(QString());
+}
+
+
+void CRelationCombo::setCurrentId(const QVariant &id)
+{
+   m_currentId=id;
+   select();
+}
+
+
+void CRelationCombo::choose(const QVariant &id)
+{
+   if( id == m_currentId )
+   {
+      return;
+   }
+   m_currentId=id;
+   select();
+   emit currentIdEdited(m_currentId);
+}
+
+
+void CRelationCombo::focusOutEvent(QFocusEvent *event)
+{
+   QComboBox::focusOutEvent(event);
+
+   // Text not chosen from the list does not change the key
+   select();
+}
+
+
+void CRelationCombo::select()
+{
+   QSignalBlocker blocker(this);
+   int row=-1;
+   QString name;
+
+   if( m_lookup && !m_currentId.isNull() )
+   {
+      row=m_lookup->rowOf( m_currentId.toLongLong() );
+      name=m_lookup->name( m_currentId.toLongLong() );
+   }
+
+   // A dangling key shows nothing; the id is kept until the user chooses
+   setCurrentIndex(row);
+   setEditText(name);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
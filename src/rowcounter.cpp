@@ -0,0 +1,263 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       rowcounter.cpp
+ * @brief      Numbers of rows, counted once and kept up to date
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <rowcounter.hpp>
+#include <connection.hpp>
+#include <workerpool.hpp>
+#include <queryprofiler.hpp>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QCache>
+#include <QMutex>
+#include <QSet>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+/** @brief Guards the numbers of the searches; workers read them */
+static QMutex s_mutex;
+static QCache<QString, qint64> s_queries(CRowCounter::MaxQueries);
+/** @brief Increased on every change; numbers counted before are dropped */
+static int s_generation=0;
+
+
+/** @brief Statement and values identify a search
+ */
+static QString queryKey(const CRowQuery &query)
+{
+   QString key=query.countStatement();
+
+   for(const QVariant &value: query.values)
+   {
+      key += '\n' + value.toString();
+   }
+
+   return(key);
+}
+
+
+CRowCounter::CRowCounter(QObject *parent)
+   :QObject(parent)
+{
+   connect(CChangeFeed::instance(), &CChangeFeed::changed, this, &CRowCounter::changed);
+}
+
+
+CRowCounter *CRowCounter::instance()
+{
+   static CRowCounter *counter=new CRowCounter(qApp);
+
+   return(counter);
+}
+
+
+qint64 CRowCounter::count(const QString &table)
+{
+   return( instance()->m_tables.value(table).count );
+}
+
+
+void CRowCounter::request(const QString &table)
+{
+   CRowCounter *counter=instance();
+
+   if( counter->m_tables[table].count < 0 )
+   {
+      counter->start(table);
+   }
+}
+
+
+void CRowCounter::recount(const QString &table)
+{
+   CRowCounter *counter=instance();
+   Entry &entry=counter->m_tables[table];
+
+   // The running count may have missed rows; the last number is shown until
+   // the new one is there
+   if(entry.counting)
+   {
+      entry.again=true;
+      return;
+   }
+   counter->start(table);
+}
+
+
+bool CRowCounter::isCounting(const QString &table)
+{
+   return( instance()->m_tables.value(table).counting );
+}
+
+
+void CRowCounter::start(const QString &table)
+{
+   Entry &entry=m_tables[table];
+   QString statement=QString("SELECT COUNT(*) FROM %1").arg(CConnection::escapeTable(table));
+
+   if(entry.counting)
+   {
+      return;
+   }
+   entry.counting=true;
+   entry.stale=false;
+   entry.again=false;
+
+   CWorkerPool::start( [=](const QSqlDatabase &db){
+      CQueryTimer timer(table, CQueryProfiler::Count, statement, QVariantList(), db);
+      QSqlQuery query(db);
+      qint64 count=-1;
+
+      if( query.exec(statement) && query.next() )
+      {
+         count=query.value(0).toLongLong();
+      }
+      else
+      {
+         qWarning("Could not count '%s': %s", qPrintable(table)
+                  , qPrintable(query.lastError().text()));
+      }
+      query.finish();
+      timer.finish(1);
+
+      QMetaObject::invokeMethod(qApp, [=](){
+         instance()->finished(table, count);
+      }, Qt::QueuedConnection);
+   } );
+}
+
+
+void CRowCounter::finished(const QString &table, qint64 count)
+{
+   Entry &entry=m_tables[table];
+
+   entry.counting=false;
+   if(entry.again)
+   {
+      start(table);
+      return;
+   }
+   entry.count=count;
+
+   // Rows changed meanwhile; the number may or may not contain them. Counting
+   // at once would never end while rows are written.
+   if( entry.stale && !entry.waiting )
+   {
+      entry.waiting=true;
+      QTimer::singleShot(RecountMsecs, this, [this, table](){
+         Entry &later=m_tables[table];
+         later.waiting=false;
+         if(later.stale)
+         {
+            start(table);
+         }
+      });
+   }
+
+   emit counted(table, count);
+}
+
+
+void CRowCounter::changed(const CChanges &changes)
+{
+   QSet<QString> tables;
+
+   {
+      QMutexLocker locker(&s_mutex);
+      s_queries.clear();
+      s_generation++;
+   }
+
+   for(const CChange &change: changes)
+   {
+      auto it=m_tables.find(change.table);
+      if( it == m_tables.end() )
+      {
+         // Nobody asked yet
+         continue;
+      }
+      if( it->counting || it->waiting )
+      {
+         it->stale=true;
+         continue;
+      }
+      if( it->count < 0 )
+      {
+         continue;
+      }
+
+      switch(change.op)
+      {
+         case CChange::Insert:
+            it->count++;
+            break;
+         case CChange::Delete:
+            it->count--;
+            break;
+         case CChange::Update:
+            continue;
+         default:
+            start(change.table);
+            continue;
+      }
+      tables.insert(change.table);
+   }
+
+   for(const QString &table: tables)
+   {
+      // Counting again may have been started for the same table
+      if( !m_tables[table].counting )
+      {
+         emit counted(table, m_tables[table].count);
+      }
+   }
+}
+
+
+qint64 CRowCounter::cached(const CRowQuery &query, int *generation)
+{
+   QMutexLocker locker(&s_mutex);
+
+   *generation=s_generation;
+   // Writes of this process would not drop the numbers
+   if( !CChangeFeed::isInstalled() )
+   {
+      return(-1);
+   }
+
+   qint64 *count=s_queries.object( queryKey(query) );
+
+   return( count ? *count : -1 );
+}
+
+
+void CRowCounter::remember(const CRowQuery &query, qint64 count, int generation)
+{
+   QMutexLocker locker(&s_mutex);
+
+   if( generation == s_generation )
+   {
+      s_queries.insert( queryKey(query), new qint64(count) );
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
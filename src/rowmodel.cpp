@@ -0,0 +1,864 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       rowmodel.cpp
+ * @brief      Read only model of the rows listed at the left of a tab
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <rowmodel.hpp>
+#include <queryprofiler.hpp>
+#include <statementcache.hpp>
+#include <searchindex.hpp>
+#include <QStringList>
+#include <QPair>
+#include <QFont>
+#include <QSqlError>
+#include <QDebug>
+#include <algorithm>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+QString CRowQuery::countStatement() const
+{
+   QString statement="SELECT COUNT(*) FROM " + from;
+
+   if(!where.isEmpty())
+   {
+      statement += " WHERE " + where;
+   }
+
+   return(statement);
+}
+
+
+/** @brief Order of the list; backwards with 'reverse'
+ */
+static QString orderClause(const CRowQuery &query, bool reverse)
+{
+   QString direction=( query.descending != reverse ) ? " DESC" : "";
+
+   if(query.key.isEmpty())
+   {
+      return( " ORDER BY " + query.id + direction );
+   }
+   return( " ORDER BY " + query.key + direction + ", " + query.id + direction );
+}
+
+
+static QString rangeCondition(const CRowQuery &query, CRowQuery::Range range
+                              , bool reverse)
+{
+   // Comparing in the direction of walking
+   QString after=( query.descending != reverse ) ? " < " : " > ";
+
+   switch(range)
+   {
+      case CRowQuery::After:
+         if(query.key.isEmpty())
+         {
+            return( query.id + after + "?" );
+         }
+         return( "(" + query.key + ", " + query.id + ")" + after + "(?, ?)" );
+      case CRowQuery::AfterNull:
+         return( query.key + " IS NULL AND " + query.id + after + "?" );
+      case CRowQuery::Null:
+         return( query.key + " IS NULL" );
+      case CRowQuery::NotNull:
+         return( query.key + " IS NOT NULL" );
+      case CRowQuery::Less:
+         return( query.key + " < ?" );
+      case CRowQuery::NotLess:
+         return( query.key + " >= ?" );
+      default:
+         return( QString() );
+   }
+}
+
+
+static QString whereClause(const CRowQuery &query, CRowQuery::Range range, bool reverse)
+{
+   QStringList conditions;
+   QString condition=rangeCondition(query, range, reverse);
+
+   if(!query.where.isEmpty())
+   {
+      conditions << "(" + query.where + ")";
+   }
+   if(!condition.isEmpty())
+   {
+      conditions << condition;
+   }
+
+   if(conditions.isEmpty())
+   {
+      return( QString() );
+   }
+
+   return( " WHERE " + conditions.join(" AND ") );
+}
+
+
+static QString columns(const CRowQuery &query)
+{
+   QString columns=query.id + ", " + query.name;
+
+   if(!query.key.isEmpty())
+   {
+      columns += ", " + query.key;
+   }
+
+   return(columns);
+}
+
+
+QString CRowQuery::pageStatement(bool after, int limit) const
+{
+   return( QString("SELECT %1 FROM %2%3%4 LIMIT %5")
+         .arg(columns(*this), from, whereClause(*this, after ? After : All, false)
+              , orderClause(*this, false))
+         .arg(limit) );
+}
+
+
+QString CRowQuery::rangeStatement(Range range, bool reverse) const
+{
+   return( QString("SELECT %1 FROM %2%3%4 LIMIT ? OFFSET ?")
+         .arg(columns(*this), from, whereClause(*this, range, reverse)
+              , orderClause(*this, reverse)) );
+}
+
+
+QString CRowQuery::rangeCountStatement(Range range, bool reverse) const
+{
+   return( "SELECT COUNT(*) FROM " + from + whereClause(*this, range, reverse) );
+}
+
+
+QString CRowQuery::rowStatement() const
+{
+   QString statement=QString("SELECT %1 FROM %2 WHERE ").arg(columns(*this), from);
+
+   if(!where.isEmpty())
+   {
+      statement += "(" + where + ") AND ";
+   }
+
+   return( statement + id + " = ?" );
+}
+
+
+CRowModel::CRowModel(QObject *parent)
+   :QAbstractTableModel(parent)
+   ,m_pages(64)
+{
+}
+
+
+void CRowModel::setMaxPages(int pages)
+{
+   m_pages.setMaxCost(pages);
+}
+
+
+int CRowModel::rowCount(const QModelIndex &parent) const
+{
+   if(parent.isValid())
+   {
+      return(0);
+   }
+   return( m_count );
+}
+
+
+int CRowModel::columnCount(const QModelIndex &parent) const
+{
+   if(parent.isValid())
+   {
+      return(0);
+   }
+   return( ColumnCount );
+}
+
+
+QVariant CRowModel::data(const QModelIndex &index, int role) const
+{
+   if( !index.isValid() || ( index.row() >= m_count ) )
+   {
+      return( QVariant() );
+   }
+
+   if( ( role != Qt::DisplayRole ) && ( role != Qt::EditRole )
+       && ( role != Qt::FontRole ) )
+   {
+      return( QVariant() );
+   }
+
+   const CRow *current=row(index.row());
+   if(!current)
+   {
+      return( QVariant() );
+   }
+
+   if(role == Qt::FontRole)
+   {
+      if(!m_marked.contains(current->id))
+      {
+         return( QVariant() );
+      }
+      QFont font;
+      font.setBold(true);
+      return( font );
+   }
+
+   if(index.column() == ColumnId)
+   {
+      return( current->id );
+   }
+
+   return( current->name );
+}
+
+
+QVariant CRowModel::headerData(int section, Qt::Orientation orientation
+                               , int role) const
+{
+   // First click on a header sorts from A
+   if( ( orientation == Qt::Horizontal ) && ( role == Qt::InitialSortOrderRole ) )
+   {
+      return( int(Qt::AscendingOrder) );
+   }
+
+   if( ( orientation != Qt::Horizontal ) || ( role != Qt::DisplayRole ) )
+   {
+      return( QAbstractTableModel::headerData(section, orientation, role) );
+   }
+
+   return( section == ColumnId ? QString("id") : QString("Name") );
+}
+
+
+void CRowModel::setQuery(const CRowQuery &query, int count, const CRows &firstPage)
+{
+   beginResetModel();
+
+   m_query=query;
+   m_count=count;
+   m_pages.clear();
+   m_bounds.clear();
+   m_bounds.resize( ( count + PageSize - 1 ) / PageSize + 1 );
+   m_bounds[0].valid=true;
+
+   remember(0, firstPage);
+
+   endResetModel();
+}
+
+
+void CRowModel::remember(int page, const CRows &rows) const
+{
+   if( rows.size() == PageSize )
+   {
+      // Where the next page starts
+      if( page + 1 < m_bounds.size() )
+      {
+         m_bounds[page + 1]={ true, rows.last().key, rows.last().id };
+      }
+   }
+
+   m_pages.insert(page, new CRows(rows));
+}
+
+
+bool CRowModel::read(CRowQuery::Range range, const QVariantList &bound, bool reverse
+                     , int offset, int limit, CRows *rows) const
+{
+   QString statement=m_query.rangeStatement(range, reverse);
+   QSqlDatabase db=QSqlDatabase::database();
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(statement, db);
+   QVariantList values=m_query.values + bound;
+
+   values << limit << offset;
+   for(const QVariant &value: values)
+   {
+      query->addBindValue(value);
+   }
+
+   CQueryTimer timer(m_query.table, kind(), statement, values, db);
+   if(!query->exec())
+   {
+      qWarning("Could not read rows of '%s': %s", qPrintable(m_query.table)
+               , qPrintable(query->lastError().text()));
+      return(false);
+   }
+
+   int first=rows->size();
+   while(query->next())
+   {
+      rows->append( { query->value(0).toLongLong(), query->value(1).toString()
+                    , m_query.key.isEmpty() ? QVariant() : query->value(2) } );
+   }
+   query->finish();
+   timer.finish(rows->size() - first);
+
+   return(true);
+}
+
+
+qint64 CRowModel::countRange(CRowQuery::Range range, const QVariantList &bound
+                             , bool reverse) const
+{
+   QString statement=m_query.rangeCountStatement(range, reverse);
+   QSqlDatabase db=QSqlDatabase::database();
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(statement, db);
+   QVariantList values=m_query.values + bound;
+   qint64 count=-1;
+
+   for(const QVariant &value: values)
+   {
+      query->addBindValue(value);
+   }
+
+   CQueryTimer timer(m_query.table, CQueryProfiler::Count, statement, values, db);
+   if( query->exec() && query->next() )
+   {
+      count=query->value(0).toLongLong();
+   }
+   else
+   {
+      qWarning("Could not count rows of '%s': %s", qPrintable(m_query.table)
+               , qPrintable(query->lastError().text()));
+   }
+   query->finish();
+   timer.finish(1);
+
+   return(count);
+}
+
+
+QVector<QPair<CRowQuery::Range, QVariantList>> CRowModel::ranges(const Bound &from
+                                                                , bool reverse) const
+{
+   QVector<QPair<CRowQuery::Range, QVariantList>> ranges;
+   // NULL keys come first in ascending order
+   bool ascending=( m_query.descending == reverse );
+
+   if(!from.valid)
+   {
+      ranges.append( { CRowQuery::All, {} } );
+   }
+   else if(m_query.key.isEmpty())
+   {
+      ranges.append( { CRowQuery::After, { from.id } } );
+   }
+   else if(from.key.isNull())
+   {
+      ranges.append( { CRowQuery::AfterNull, { from.id } } );
+      if(ascending)
+      {
+         ranges.append( { CRowQuery::NotNull, {} } );
+      }
+   }
+   else
+   {
+      ranges.append( { CRowQuery::After, { from.key, from.id } } );
+      if(!ascending)
+      {
+         ranges.append( { CRowQuery::Null, {} } );
+      }
+   }
+
+   return(ranges);
+}
+
+
+bool CRowModel::walk(const Bound &from, bool reverse, int offset, int limit
+                     , CRows *rows) const
+{
+   QVector<QPair<CRowQuery::Range, QVariantList>> ranges=this->ranges(from, reverse);
+
+   for(int i1=0; ( i1<ranges.size() ) && ( limit > 0 ); i1++)
+   {
+      int first=rows->size();
+
+      if( !read(ranges[i1].first, ranges[i1].second, reverse, offset, limit, rows) )
+      {
+         return(false);
+      }
+      limit-=rows->size() - first;
+
+      if( rows->size() > first )
+      {
+         offset=0;
+      }
+      else if( ( offset > 0 ) && ( i1 + 1 < ranges.size() ) )
+      {
+         // The offset reaches beyond this range; skip the rows it has
+         qint64 count=countRange(ranges[i1].first, ranges[i1].second, reverse);
+         if( count < 0 )
+         {
+            return(false);
+         }
+         offset=int( qMax<qint64>(0, offset - count) );
+      }
+   }
+
+   return(true);
+}
+
+
+bool CRowModel::bound(int page) const
+{
+   int before=page;
+   int after=page;
+   int target=page * PageSize - 1;
+
+   if(m_bounds[page].valid)
+   {
+      return(true);
+   }
+
+   while(!m_bounds[before].valid)
+   {
+      before--;
+   }
+   while( ( after < m_bounds.size() ) && !m_bounds[after].valid )
+   {
+      after++;
+   }
+
+   // Skipping rows walks the index; from the nearest known row, which may
+   // also be the end of the list or a page further down
+   Bound from=( before > 0 ) ? m_bounds[before] : Bound();
+   int offset=target - before * PageSize;
+   bool reverse=false;
+
+   if( m_count - 1 - target < offset )
+   {
+      from=Bound();
+      offset=m_count - 1 - target;
+      reverse=true;
+   }
+   if( ( after < m_bounds.size() ) && ( after * PageSize - 2 - target < offset ) )
+   {
+      from=m_bounds[after];
+      offset=after * PageSize - 2 - target;
+      reverse=true;
+   }
+
+   CRows rows;
+   if( !walk(from, reverse, offset, 1, &rows) || rows.isEmpty() )
+   {
+      qWarning("Could not seek to page %d", page);
+      return(false);
+   }
+
+   m_bounds[page]={ true, rows.first().key, rows.first().id };
+
+   return(true);
+}
+
+
+CRows *CRowModel::page(int page) const
+{
+   CRows *rows=m_pages.object(page);
+   CRows fetched;
+
+   if(rows)
+   {
+      return(rows);
+   }
+
+   if(!bound(page))
+   {
+      return(nullptr);
+   }
+
+   fetched.reserve(PageSize);
+   if( !walk( ( page > 0 ) ? m_bounds[page] : Bound(), false, 0, PageSize, &fetched ) )
+   {
+      return(nullptr);
+   }
+
+   remember(page, fetched);
+
+   return( m_pages.object(page) );
+}
+
+
+int CRowModel::seek(const QString &prefix) const
+{
+   qint64 row;
+   CRows rows;
+   CRows landed;
+
+   // Positions are known only in the order of the Names
+   if( prefix.isEmpty() || ( m_query.key != m_query.name ) || !m_count )
+   {
+      return(-1);
+   }
+
+   // Names starting with 'prefix', case sensitive unlike LIKE, as a range of
+   // the index; empty if no Name sorts after the ones starting with 'prefix'
+   QString next=CSearchIndex::prefixEnd(prefix);
+
+   // Rows before the first Name starting with 'prefix' and the last of them
+   if(!m_query.descending)
+   {
+      qint64 nulls=countRange(CRowQuery::Null, {}, false);
+      qint64 less=countRange(CRowQuery::Less, { prefix }, false);
+      if( ( nulls < 0 ) || ( less < 0 ) )
+      {
+         return(-1);
+      }
+      row=nulls + less;
+      if( less > 0 )
+      {
+         read(CRowQuery::Less, { prefix }, true, 0, 1, &rows);
+      }
+      else if( nulls > 0 )
+      {
+         read(CRowQuery::Null, {}, true, 0, 1, &rows);
+      }
+      read(CRowQuery::NotLess, { prefix }, false, 0, 1, &landed);
+   }
+   else if( next.isEmpty() )
+   {
+      row=0;
+      read(CRowQuery::NotNull, {}, false, 0, 1, &landed);
+   }
+   else
+   {
+      row=countRange(CRowQuery::NotLess, { next }, false);
+      if( row < 0 )
+      {
+         return(-1);
+      }
+      if( row > 0 )
+      {
+         read(CRowQuery::NotLess, { next }, true, 0, 1, &rows);
+      }
+      read(CRowQuery::Less, { next }, false, 0, 1, &landed);
+   }
+
+   // The row found is the first not before 'prefix'; it may not start with it
+   if( ( row >= m_count ) || landed.isEmpty() || !landed.first().name.startsWith(prefix) )
+   {
+      return(-1);
+   }
+
+   // The page of the row starts a few rows before the one found
+   int page=row / PageSize;
+   if( !rows.isEmpty() && !m_bounds[page].valid )
+   {
+      Bound found{ true, rows.first().key, rows.first().id };
+      CRows start;
+      if( row == page * PageSize )
+      {
+         m_bounds[page]=found;
+      }
+      else if( walk(found, true, int( row - 1 - page * PageSize ), 1, &start)
+               && !start.isEmpty() )
+      {
+         m_bounds[page]={ true, start.first().key, start.first().id };
+      }
+   }
+
+   return( int(row) );
+}
+
+
+QModelIndexList CRowModel::match(const QModelIndex &start, int role, const QVariant &value
+                                 , int hits, Qt::MatchFlags flags) const
+{
+   QModelIndexList matches;
+   QString prefix=value.toString();
+   int first=qMax(start.row(), 0);
+
+   if( ( role != Qt::DisplayRole ) || !( flags & Qt::MatchStartsWith ) || prefix.isEmpty() )
+   {
+      return(matches);
+   }
+
+   // Typing into the list; sorted by Name it is a seek in the index, and the
+   // rows starting with 'prefix' follow the one found
+   if( m_query.key == m_query.name )
+   {
+      int found=seek(prefix);
+      if( ( found >= 0 ) && ( first > found ) )
+      {
+         const CRow *current=row(first);
+         if( current && current->name.startsWith(prefix) )
+         {
+            found=first;
+         }
+         else if( !( flags & Qt::MatchWrap ) )
+         {
+            found=-1;
+         }
+      }
+      if( found >= 0 )
+      {
+         matches << index(found, ColumnName);
+      }
+      return(matches);
+   }
+
+   // Otherwise only the rows read are searched, not all pages of the table;
+   // binary like the index, in the order of the rows
+   QList<int> pages=m_pages.keys();
+   std::sort(pages.begin(), pages.end());
+   auto search=[&](int from, int to){
+      for(int key: pages)
+      {
+         const CRows *rows=m_pages.object(key);
+         for(int i1=0; i1<rows->size(); i1++)
+         {
+            int current=key * PageSize + i1;
+            if( ( hits >= 0 ) && ( matches.size() >= hits ) )
+            {
+               return;
+            }
+            if( ( current >= from ) && ( current < to )
+                && rows->at(i1).name.startsWith(prefix) )
+            {
+               matches << index(current, ColumnName);
+            }
+         }
+      }
+   };
+   search(first, m_count);
+   if( flags & Qt::MatchWrap )
+   {
+      search(0, first);
+   }
+
+   return(matches);
+}
+
+
+CQueryProfiler::Kind CRowModel::kind() const
+{
+   return( m_query.where.isEmpty() ? CQueryProfiler::Select : CQueryProfiler::Filter );
+}
+
+
+const CRow *CRowModel::row(int row) const
+{
+   CRows *rows=page(row / PageSize);
+
+   if( !rows || ( row % PageSize >= rows->size() ) )
+   {
+      return(nullptr);
+   }
+
+   return( &rows->at(row % PageSize) );
+}
+
+
+qint64 CRowModel::rowId(int row) const
+{
+   if( ( row < 0 ) || ( row >= m_count ) )
+   {
+      return(-1);
+   }
+
+   const CRow *current=this->row(row);
+
+   return( current ? current->id : -1 );
+}
+
+
+int CRowModel::rowOf(qint64 id) const
+{
+   for(int key: m_pages.keys())
+   {
+      const CRows *rows=m_pages.object(key);
+      for(int i1=0; i1<rows->size(); i1++)
+      {
+         if( rows->at(i1).id == id )
+         {
+            return( key * PageSize + i1 );
+         }
+      }
+   }
+   return(-1);
+}
+
+
+void CRowModel::setName(qint64 id, const QString &name)
+{
+   int row=rowOf(id);
+
+   // Pages not kept are read with the current Name anyway
+   if(row < 0)
+   {
+      return;
+   }
+
+   CRow &data=(*m_pages.object(row / PageSize))[row % PageSize];
+   if( data.name == name )
+   {
+      return;
+   }
+
+   // The keys of the pages and bounds kept are not valid anymore
+   if( !m_query.key.isEmpty() && ( m_query.key == m_query.name ) )
+   {
+      invalidate();
+      return;
+   }
+
+   data.name=name;
+   emit dataChanged( index(row, ColumnName), index(row, ColumnName) );
+}
+
+
+bool CRowModel::fetch(qint64 id, CRow *data) const
+{
+   QString statement=m_query.rowStatement();
+   QSqlDatabase db=QSqlDatabase::database();
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare(statement, db);
+   QVariantList values=m_query.values;
+   bool found;
+
+   values << id;
+   for(const QVariant &value: values)
+   {
+      query->addBindValue(value);
+   }
+
+   CQueryTimer timer(m_query.table, CQueryProfiler::Select, statement, values, db);
+   found=query->exec() && query->next();
+   if(found)
+   {
+      *data={ query->value(0).toLongLong(), query->value(1).toString()
+              , m_query.key.isEmpty() ? QVariant() : query->value(2) };
+   }
+   query->finish();
+   timer.finish(found ? 1 : 0);
+
+   return(found);
+}
+
+
+int CRowModel::position(const CRow &data) const
+{
+   qint64 before=0;
+
+   // The rows before are the ones walking backwards from 'data' reaches
+   for(const auto &range: ranges( { true, data.key, data.id }, true ))
+   {
+      qint64 count=countRange(range.first, range.second, true);
+      if( count < 0 )
+      {
+         return(-1);
+      }
+      before+=count;
+   }
+
+   return( int( qMin<qint64>(before, m_count) ) );
+}
+
+
+void CRowModel::invalidate()
+{
+   emit layoutAboutToBeChanged();
+
+   m_pages.clear();
+   for(int i1=1; i1<m_bounds.size(); i1++)
+   {
+      m_bounds[i1].valid=false;
+   }
+
+   emit layoutChanged();
+}
+
+
+void CRowModel::setMarked(const QSet<qint64> &ids)
+{
+   if(ids == m_marked)
+   {
+      return;
+   }
+   m_marked=ids;
+   if(m_count)
+   {
+      emit dataChanged( index(0, ColumnName), index(m_count - 1, ColumnName)
+                        , { Qt::FontRole } );
+   }
+}
+
+
+void CRowModel::forget(int page)
+{
+   for(int key: m_pages.keys())
+   {
+      if(key >= page)
+      {
+         m_pages.remove(key);
+      }
+   }
+
+   // The start of 'page' itself did not move
+   for(int i1=page + 1; i1<m_bounds.size(); i1++)
+   {
+      m_bounds[i1].valid=false;
+   }
+}
+
+
+void CRowModel::insertRowAt(int row, const CRow &data)
+{
+   int page=row / PageSize;
+
+   beginInsertRows(QModelIndex(), row, row);
+
+   // Rows behind shift by one, so their pages are not valid anymore
+   CRows *rows=m_pages.object(page);
+   CRows patched;
+   if( rows && ( rows->size() < PageSize ) )
+   {
+      patched=*rows;
+      patched.insert(row % PageSize, data);
+   }
+   forget(page);
+   m_count++;
+   m_bounds.resize( ( m_count + PageSize - 1 ) / PageSize + 1 );
+   if(!patched.isEmpty())
+   {
+      m_pages.insert(page, new CRows(patched));
+   }
+
+   endInsertRows();
+}
+
+
+void CRowModel::removeRowAt(int row)
+{
+   if( ( row < 0 ) || ( row >= m_count ) )
+   {
+      return;
+   }
+
+   beginRemoveRows(QModelIndex(), row, row);
+
+   forget(row / PageSize);
+   m_count--;
+
+   endRemoveRows();
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
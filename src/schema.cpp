@@ -0,0 +1,333 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       schema.cpp
+ * @brief      Catalog of tables and columns, read once per schema version
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <schema.hpp>
+#include <connection.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static QString s_connection=QLatin1String(QSqlDatabase::defaultConnection);
+static QString s_version;
+static QStringList s_schemas( { "main" } );
+static QStringList s_tables;
+static QHash<QString, CTableInfoPtr> s_infos;
+
+
+bool CSchema::isForeignKey(const QString &name)
+{
+   return( !foreignKeyTable(name).isEmpty() );
+}
+
+
+QString CSchema::foreignKeyTable(const QString &name)
+{
+   QString foreignTable;
+   QStringList list=name.split("_");
+
+   if( ( list.size() >= 3 ) && ( list[1].toLower() == "id" ) )
+   {
+      foreignTable=list[0];
+   }
+
+   return(foreignTable);
+}
+
+
+bool CSchema::isMultiLine(const QString &name)
+{
+   bool multiLine=false;
+
+   if( (name=="Description")  )
+   {
+      multiLine=true;
+   }
+
+   return(multiLine);
+}
+
+
+static QString escapeName(const QString &name)
+{
+   // Field names are not split at '.'
+   return( CConnection::escapeField( name, QSqlDatabase::database(s_connection) ) );
+}
+
+
+/** @brief 'main' and the attached databases in the order of attaching
+ */
+static QStringList readSchemas(const QSqlDatabase &db)
+{
+   QStringList schemas;
+   QSqlQuery query(db);
+
+   if( query.exec("PRAGMA database_list") )
+   {
+      while(query.next())
+      {
+         QString schema=query.value(1).toString();
+         if( schema != "temp" )
+         {
+            schemas << schema;
+         }
+      }
+   }
+
+   if(schemas.isEmpty())
+   {
+      schemas << "main";
+   }
+
+   return(schemas);
+}
+
+
+QString CSchema::schemaVersion(const QSqlDatabase &db)
+{
+   QStringList versions;
+   QSqlQuery query(db);
+
+   // Attaching or detaching changes the list too
+   for(const QString &schema: readSchemas(db))
+   {
+      if( query.exec( QString("PRAGMA %1.schema_version").arg(escapeName(schema)) )
+          && query.next() )
+      {
+         versions << schema + ":" + query.value(0).toString();
+      }
+   }
+
+   return( versions.join(",") );
+}
+
+
+QString CSchema::resolve(const QString &foreignTable, const QString &schema
+                         , const QSet<QString> &tables)
+{
+   if(foreignTable.isEmpty())
+   {
+      return(foreignTable);
+   }
+
+   // Same file first, then the main file, then the attached ones
+   if( ( schema != "main" ) && tables.contains( schema + "." + foreignTable ) )
+   {
+      return( schema + "." + foreignTable );
+   }
+   if( tables.contains(foreignTable) )
+   {
+      return(foreignTable);
+   }
+   for(const QString &other: s_schemas)
+   {
+      if( tables.contains( other + "." + foreignTable ) )
+      {
+         return( other + "." + foreignTable );
+      }
+   }
+
+   // Dangling; points into the same file like without workspace
+   return( ( schema == "main" ) ? foreignTable : schema + "." + foreignTable );
+}
+
+
+bool CSchema::isResolved(const CTableInfoPtr &info, const QSet<QString> &tables)
+{
+   QString schema=schemaOf(info->name);
+
+   for(const CColumnInfo &column: info->columns)
+   {
+      if( ( column.name != "id" )
+          && ( column.foreignTable != resolve(foreignKeyTable(column.name), schema, tables) ) )
+      {
+         return(false);
+      }
+   }
+
+   return(true);
+}
+
+
+CTableInfoPtr CSchema::readTable(const QSqlDatabase &db, const QString &table
+                                 , const QString &sql, const QSet<QString> &tables)
+{
+   QSharedPointer<CTableInfo> info(new CTableInfo);
+
+   info->name=table;
+   info->sql=sql;
+   info->record=db.record(table);
+   info->columns.reserve(info->record.count());
+
+   for(int i1=0; i1<info->record.count(); i1++)
+   {
+      QSqlField field=info->record.field(i1);
+      CColumnInfo column;
+
+      column.name=field.name();
+      column.label=column.name.split("_")[0];
+      column.type=field.type();
+      if( column.name != "id" )
+      {
+         column.foreignTable=resolve(foreignKeyTable(column.name), schemaOf(table)
+                                     , tables);
+      }
+      column.multiLine=isMultiLine(column.name);
+
+      info->indexes.insert(column.name, info->columns.size());
+      info->columns.append(column);
+   }
+
+   return(info);
+}
+
+
+bool CSchema::load(const QSqlDatabase &db)
+{
+   QElapsedTimer timer;
+   QSqlQuery query(db);
+   QStringList tables;
+   QStringList sqls;
+   QSet<QString> names;
+   QHash<QString, CTableInfoPtr> infos;
+   int reused=0;
+
+   timer.start();
+   s_connection=db.connectionName();
+   s_version=schemaVersion(db);
+   s_schemas=readSchemas(db);
+
+   // All names first; foreign keys may point into another file
+   for(const QString &schema: s_schemas)
+   {
+      if( !query.exec( QString("SELECT name, sql FROM %1.sqlite_master WHERE type='table'"
+                               " AND name NOT LIKE 'sqlite\\_%' ESCAPE '\\'")
+                       .arg(escapeName(schema)) ) )
+      {
+         qWarning("Could not read schema '%s': %s", qPrintable(schema)
+                  , qPrintable(query.lastError().text()));
+         return(false);
+      }
+
+      while(query.next())
+      {
+         QString table=query.value(0).toString();
+         if( schema != "main" )
+         {
+            table=schema + "." + table;
+         }
+         tables << table;
+         sqls << query.value(1).toString();
+         names.insert(table);
+      }
+   }
+
+   for(int i1=0; i1<tables.size(); i1++)
+   {
+      CTableInfoPtr info=s_infos.value(tables[i1]);
+
+      // Unchanged tables keep their descriptor
+      if( info.isNull() || ( info->sql != sqls[i1] ) || !isResolved(info, names) )
+      {
+         info=readTable(db, tables[i1], sqls[i1], names);
+      }
+      else
+      {
+         reused++;
+      }
+      infos.insert(tables[i1], info);
+   }
+
+   s_tables=tables;
+   s_infos=infos;
+
+   qCDebug(lcTiming, "Read schema version %s with %d tables (%d unchanged) in %lld ms"
+           , qPrintable(s_version), s_tables.size(), reused, timer.elapsed());
+
+   return(true);
+}
+
+
+bool CSchema::refresh()
+{
+   QSqlDatabase db=QSqlDatabase::database(s_connection);
+
+   if( schemaVersion(db) == s_version )
+   {
+      return(false);
+   }
+
+   return( load(db) );
+}
+
+
+QStringList CSchema::tables()
+{
+   return(s_tables);
+}
+
+
+CTableInfoPtr CSchema::table(const QString &table)
+{
+   return( s_infos.value(table) );
+}
+
+
+QStringList CSchema::schemas()
+{
+   return(s_schemas);
+}
+
+
+QString CSchema::schemaOf(const QString &table)
+{
+   int dot=table.indexOf('.');
+
+   if( ( dot > 0 ) && s_schemas.contains( table.left(dot) ) )
+   {
+      return( table.left(dot) );
+   }
+
+   return("main");
+}
+
+
+QString CSchema::baseName(const QString &table)
+{
+   if( schemaOf(table) == "main" )
+   {
+      return(table);
+   }
+
+   return( table.mid( table.indexOf('.') + 1 ) );
+}
+
+
+QString CSchema::pragma(const QString &pragma, const QString &table)
+{
+   return( QString("PRAGMA %1.%2(%3)")
+           .arg(escapeName(schemaOf(table)), pragma, escapeName(baseName(table))) );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
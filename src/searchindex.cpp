@@ -0,0 +1,442 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       searchindex.cpp
+ * @brief      Optional FTS5 full text index behind the search box of a tab
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <searchindex.hpp>
+#include <schema.hpp>
+#include <connection.hpp>
+#include <queryprofiler.hpp>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <QMutex>
+#include <QSet>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static bool s_enabled=false;
+/** @brief Guards the names of the indexes; the update hook reads them */
+static QMutex s_mutex;
+/** @brief FTS5 tables of all files, without schema */
+static QSet<QString> s_indexes;
+
+
+CSearchIndex::CSearchIndex(const QString &table)
+   :m_table(table)
+   ,m_index(table + "__fts")
+{
+}
+
+
+void CSearchIndex::readColumns()
+{
+   CTableInfoPtr info=CSchema::table(m_table);
+
+   m_columns.clear();
+   if(info.isNull())
+   {
+      return;
+   }
+   for(const CColumnInfo &column: info->columns)
+   {
+      // Neither the id nor foreign keys are worth a full text search
+      if( ( column.name == "id" ) || column.isForeignKey() )
+      {
+         continue;
+      }
+      m_columns << column.name;
+   }
+}
+
+
+void CSearchIndex::setEnabled(bool enabled)
+{
+   s_enabled=enabled;
+}
+
+
+bool CSearchIndex::isEnabled()
+{
+   return(s_enabled);
+}
+
+
+bool CSearchIndex::isAvailable()
+{
+   static int available=-1;
+
+   if(available < 0)
+   {
+      QSqlQuery query;
+      available=0;
+      if( query.exec("SELECT sqlite_compileoption_used('ENABLE_FTS5')")
+          && query.next() )
+      {
+         available=query.value(0).toInt();
+      }
+      if(!available)
+      {
+         qWarning("SQLite has no FTS5 support; using LIKE for searching");
+      }
+   }
+
+   return(available);
+}
+
+
+bool CSearchIndex::isIndexTable(const QString &table)
+{
+   // The shadow tables FTS5 creates for an index
+   static const char *suffixes[]={ "_data", "_idx", "_content", "_docsize", "_config" };
+   QMutexLocker locker(&s_mutex);
+
+   if( s_indexes.contains(table) )
+   {
+      return(true);
+   }
+   for(const char *suffix: suffixes)
+   {
+      if( table.endsWith( QLatin1String(suffix) )
+          && s_indexes.contains( table.left( table.size() - int(qstrlen(suffix)) ) ) )
+      {
+         return(true);
+      }
+   }
+
+   return(false);
+}
+
+
+void CSearchIndex::readIndexes(const QSqlDatabase &db)
+{
+   QSqlQuery query(db);
+   QSet<QString> indexes;
+
+   // Also the ones of other programs; their shadow tables are no user tables
+   for(const QString &schema: CSchema::schemas())
+   {
+      if( !query.exec( QString("SELECT name FROM %1.sqlite_master WHERE type='table'"
+                               " AND sql LIKE 'CREATE VIRTUAL TABLE % USING fts5%'")
+                       .arg( CConnection::escapeField(schema, db) ) ) )
+      {
+         qWarning("Could not read the search indexes of '%s': %s", qPrintable(schema)
+                  , qPrintable(query.lastError().text()));
+         continue;
+      }
+      while(query.next())
+      {
+         indexes.insert( query.value(0).toString() );
+      }
+   }
+
+   QMutexLocker locker(&s_mutex);
+   s_indexes=indexes;
+}
+
+
+QString CSearchIndex::createStatement() const
+{
+   QStringList columns;
+
+   for(const QString &column: m_columns)
+   {
+      columns << CConnection::escapeField(column);
+   }
+
+   // Without 'IF NOT EXISTS'; it has to match the text in 'sqlite_master'
+   return( QString("CREATE VIRTUAL TABLE %1 USING fts5(%2, content=%3, content_rowid='id')")
+         .arg(CConnection::escapeTable(m_index), columns.join(", "), literal(m_table)) );
+}
+
+
+bool CSearchIndex::open()
+{
+   m_active=false;
+
+   if( !isEnabled() || !isAvailable() )
+   {
+      return(m_active);
+   }
+
+   // Triggers can not use the '<schema>.<table>' names of attached files
+   if( CSchema::schemaOf(m_table) != "main" )
+   {
+      return(m_active);
+   }
+
+   readColumns();
+   if( m_columns.isEmpty() )
+   {
+      return(m_active);
+   }
+
+   QSqlQuery query;
+   query.prepare("SELECT sql FROM sqlite_master WHERE type='table' AND name=?");
+   query.addBindValue(m_index);
+   if( query.exec() && query.next() )
+   {
+      if( query.value(0).toString() == createStatement() )
+      {
+         // Triggers keep the index up to date
+         QMutexLocker locker(&s_mutex);
+         s_indexes.insert(m_index);
+         m_active=true;
+         return(m_active);
+      }
+      if( CConnection::isReadOnly() )
+      {
+         return(m_active);
+      }
+      qWarning("Columns of '%s' changed; recreating search index"
+               , qPrintable(m_table));
+      query.finish();
+      drop();
+   }
+   else if( CConnection::isReadOnly() )
+   {
+      // Files can not be changed; searched by LIKE
+      return(m_active);
+   }
+
+   m_active=create();
+
+   return(m_active);
+}
+
+
+bool CSearchIndex::create()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QString table=CConnection::escapeTable(m_table);
+   QString index=CConnection::escapeTable(m_index);
+   QStringList columns;
+   QStringList newValues;
+   QStringList oldValues;
+
+   for(const QString &column: m_columns)
+   {
+      columns << CConnection::escapeField(column);
+      newValues << "new." + CConnection::escapeField(column);
+      oldValues << "old." + CConnection::escapeField(column);
+   }
+
+   QString insertNew=QString("INSERT INTO %1(rowid, %2) VALUES (new.id, %3);")
+         .arg(index, columns.join(", "), newValues.join(", "));
+   QString deleteOld=QString("INSERT INTO %1(%1, rowid, %2) VALUES ('delete', old.id, %3);")
+         .arg(index, columns.join(", "), oldValues.join(", "));
+
+   QStringList statements;
+   statements << createStatement()
+              << QString("CREATE TRIGGER %1 AFTER INSERT ON %2 BEGIN %3 END")
+                   .arg(CConnection::escapeTable(m_index + "_ai"), table, insertNew)
+              << QString("CREATE TRIGGER %1 AFTER DELETE ON %2 BEGIN %3 END")
+                   .arg(CConnection::escapeTable(m_index + "_ad"), table, deleteOld)
+              << QString("CREATE TRIGGER %1 AFTER UPDATE ON %2 BEGIN %3 %4 END")
+                   .arg(CConnection::escapeTable(m_index + "_au"), table, deleteOld, insertNew)
+              << QString("INSERT INTO %1(%1) VALUES ('rebuild')").arg(index);
+
+   {
+      // Before the rows of the rebuild reach the update hook
+      QMutexLocker locker(&s_mutex);
+      s_indexes.insert(m_index);
+   }
+
+   db.transaction();
+   for(const QString &statement: statements)
+   {
+      QSqlQuery query;
+      if( !query.exec(statement) )
+      {
+         qWarning("Could not create search index for '%s': %s"
+                  , qPrintable(m_table), qPrintable(query.lastError().text()));
+         db.rollback();
+         QMutexLocker locker(&s_mutex);
+         s_indexes.remove(m_index);
+         return(false);
+      }
+   }
+   db.commit();
+
+   qCDebug(lcTiming, "Created search index for '%s'", qPrintable(m_table));
+
+   return(true);
+}
+
+
+void CSearchIndex::drop()
+{
+   QSqlQuery query;
+
+   for(const QString &trigger: { "_ai", "_ad", "_au" })
+   {
+      query.exec( "DROP TRIGGER IF EXISTS " + CConnection::escapeTable(m_index + trigger) );
+   }
+   query.exec( "DROP TABLE IF EXISTS " + CConnection::escapeTable(m_index) );
+
+   QMutexLocker locker(&s_mutex);
+   s_indexes.remove(m_index);
+}
+
+
+QString CSearchIndex::literal(const QString &value)
+{
+   QSqlField field( QString(), QVariant::String );
+   field.setValue( value );
+
+   return( QSqlDatabase::database().driver()->formatValue(field) );
+}
+
+
+QString CSearchIndex::prefixEnd(const QString &prefix)
+{
+   QString end=prefix;
+
+   // The last code point is increased; UTF-8 sorts like the code points
+   while( !end.isEmpty() )
+   {
+      int size=( ( end.size() > 1 ) && end.at(end.size() - 1).isLowSurrogate()
+                 && end.at(end.size() - 2).isHighSurrogate() ) ? 2 : 1;
+      uint point=( size == 2 ) ? QChar::surrogateToUcs4( end.at(end.size() - 2)
+                                                       , end.at(end.size() - 1) )
+                               : end.at(end.size() - 1).unicode();
+      end.chop(size);
+
+      // The largest code point has no successor; the one before is increased
+      if( point >= 0x10FFFF )
+      {
+         continue;
+      }
+      point++;
+      if( ( point >= 0xD800 ) && ( point <= 0xDFFF ) )
+      {
+         // Surrogates are no code points
+         point=0xE000;
+      }
+      if( QChar::requiresSurrogates(point) )
+      {
+         end += QChar( QChar::highSurrogate(point) );
+         end += QChar( QChar::lowSurrogate(point) );
+      }
+      else
+      {
+         end += QChar( ushort(point) );
+      }
+      return(end);
+   }
+
+   return( QString() );
+}
+
+
+QString CSearchIndex::matchExpression(const QString &line) const
+{
+   QStringList terms;
+
+   // Every word is a quoted prefix query; quoting avoids FTS5 syntax errors
+   // for user input like '-' or 'AND'.
+   for(QString word: line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts))
+   {
+      word.replace("\"", "\"\"");
+      terms << "\"" + word + "\"*";
+   }
+
+   return( terms.join(" ") );
+}
+
+
+CSearchClause CSearchIndex::likeClause(const QString &line) const
+{
+   CSearchClause clause;
+   QString pattern=line;
+   CTableInfoPtr info=CSchema::table(m_table);
+
+   pattern.replace("\\", "\\\\");
+   pattern.replace("%", "\\%");
+   pattern.replace("_", "\\_");
+   pattern="%" + pattern + "%";
+
+   for(int i1=0; info && ( i1<info->columns.size() ); i1++)
+   {
+      if(i1)
+      {
+         clause.where += " OR ";
+      }
+      clause.where += CConnection::escapeTable(m_table) + "." + CConnection::escapeField(info->columns[i1].name)
+            + " LIKE ? ESCAPE '\\'";
+      clause.values << pattern;
+   }
+
+   return(clause);
+}
+
+
+CSearchClause CSearchIndex::clause(const QString &line) const
+{
+   CSearchClause clause;
+
+   if( line.trimmed().isEmpty() )
+   {
+      return(clause);
+   }
+
+   if( !m_active )
+   {
+      return( likeClause(line) );
+   }
+
+   // Best matches first
+   clause.join=QString(" JOIN (SELECT rowid AS id, rank FROM %1 WHERE %1 MATCH ?) AS fts"
+                       " ON fts.id = %2.id")
+         .arg(CConnection::escapeTable(m_index), CConnection::escapeTable(m_table));
+   clause.order="fts.rank";
+   clause.values << matchExpression(line);
+
+   return(clause);
+}
+
+
+CSearchClause CSearchIndex::idClause(const QString &line) const
+{
+   CSearchClause clause;
+   bool ok=false;
+   qint64 id=line.trimmed().toLongLong(&ok);
+
+   if( line.trimmed().isEmpty() )
+   {
+      return(clause);
+   }
+
+   if(!ok)
+   {
+      // Not a number, nothing can match
+      clause.where="0";
+      return(clause);
+   }
+
+   clause.where=CConnection::escapeTable(m_table) + ".id = ?";
+   clause.values << id;
+
+   return(clause);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
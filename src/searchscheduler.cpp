@@ -0,0 +1,223 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       searchscheduler.cpp
+ * @brief      Debounced searching on a worker thread
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <searchscheduler.hpp>
+#include <workerpool.hpp>
+#include <queryprofiler.hpp>
+#include <rowcounter.hpp>
+#include <connection.hpp>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <sqlite3.h>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static int s_debounce=200;
+
+
+/** @brief Generation of a running request, compared with the newest one
+ */
+struct COutdated
+{
+   const QAtomicInt *current;
+   int generation;
+
+   bool check() const { return( current->loadAcquire() != generation ); }
+
+   /** @brief Progress handler of SQLite; non-zero interrupts the statement
+    */
+   static int interrupt(void *data)
+   {
+      return( static_cast<const COutdated *>(data)->check() ? 1 : 0 );
+   }
+};
+
+
+CSearchScheduler::CSearchScheduler(QObject *parent)
+   :QObject(parent)
+   ,m_generation(new QAtomicInt(0))
+{
+   m_timer.setSingleShot(true);
+   connect(&m_timer, &QTimer::timeout, this, &CSearchScheduler::start);
+}
+
+
+CSearchScheduler::~CSearchScheduler()
+{
+   cancel();
+}
+
+
+void CSearchScheduler::setDebounce(int msec)
+{
+   s_debounce=msec;
+}
+
+
+int CSearchScheduler::debounce()
+{
+   return(s_debounce);
+}
+
+
+void CSearchScheduler::schedule(const CRowQuery &query)
+{
+   m_query=query;
+   m_timer.start(s_debounce);
+}
+
+
+void CSearchScheduler::flush()
+{
+   if(m_timer.isActive())
+   {
+      start();
+   }
+}
+
+
+void CSearchScheduler::cancel()
+{
+   m_timer.stop();
+   m_generation->fetchAndAddOrdered(1);
+}
+
+
+void CSearchScheduler::start()
+{
+   m_timer.stop();
+
+   int generation=m_generation->fetchAndAddOrdered(1) + 1;
+   QSharedPointer<QAtomicInt> current=m_generation;
+   QPointer<CSearchScheduler> self(this);
+   CRowQuery rowQuery=m_query;
+
+   CWorkerPool::start( [=](const QSqlDatabase &db)
+   {
+      CRows rows;
+      QString error;
+      int count=0;
+      COutdated outdated{ current.data(), generation };
+
+      // Another request may have been made while this one was queued
+      if( outdated.check() )
+      {
+         return;
+      }
+
+      // Long statements, e.g. counting a large table, are interrupted
+      sqlite3 *handle=CConnection::handle(db);
+      if(handle)
+      {
+         sqlite3_progress_handler(handle, ProgressSteps, &COutdated::interrupt, &outdated);
+      }
+
+      // The number of rows is counted once for the query, the view reads
+      // further pages on demand. Known numbers are not counted.
+      int countGeneration=0;
+      qint64 known=( rowQuery.count >= 0 ) ? rowQuery.count
+                                            : CRowCounter::cached(rowQuery, &countGeneration);
+      if( known >= 0 )
+      {
+         count=int(known);
+      }
+      else
+      {
+         CQueryTimer countTimer(rowQuery.table, CQueryProfiler::Count
+                                , rowQuery.countStatement(), rowQuery.values, db);
+         QSqlQuery query(db);
+         query.setForwardOnly(true);
+         query.prepare( rowQuery.countStatement() );
+         for(const QVariant &value: rowQuery.values)
+         {
+            query.addBindValue(value);
+         }
+         if( !query.exec() || !query.next() )
+         {
+            error=query.lastError().text();
+         }
+         else
+         {
+            count=query.value(0).toInt();
+            CRowCounter::remember(rowQuery, count, countGeneration);
+         }
+         query.finish();
+         countTimer.finish(1);
+      }
+
+      if( !outdated.check() )
+      {
+         CQueryTimer pageTimer(rowQuery.table
+                               , rowQuery.where.isEmpty() ? CQueryProfiler::Select
+                                                          : CQueryProfiler::Filter
+                               , rowQuery.pageStatement(false, CRowModel::PageSize)
+                               , rowQuery.values, db);
+         QSqlQuery pageQuery(db);
+         pageQuery.setForwardOnly(true);
+         pageQuery.prepare( rowQuery.pageStatement(false, CRowModel::PageSize) );
+         for(const QVariant &value: rowQuery.values)
+         {
+            pageQuery.addBindValue(value);
+         }
+         if( error.isEmpty() && !pageQuery.exec() )
+         {
+            error=pageQuery.lastError().text();
+         }
+
+         while( error.isEmpty() && !outdated.check() && pageQuery.next() )
+         {
+            rows.append( { pageQuery.value(0).toLongLong(), pageQuery.value(1).toString()
+                         , rowQuery.key.isEmpty() ? QVariant() : pageQuery.value(2) } );
+         }
+         pageQuery.finish();
+         pageTimer.finish(rows.size());
+      }
+
+      if(handle)
+      {
+         sqlite3_progress_handler(handle, 0, nullptr, nullptr);
+      }
+      if( outdated.check() )
+      {
+         return;
+      }
+
+      // Hand over to the GUI thread; only the newest result is shown
+      QMetaObject::invokeMethod(qApp, [=]()
+      {
+         if( !self || ( current->loadAcquire() != generation ) )
+         {
+            return;
+         }
+         if( error.isEmpty() )
+         {
+            emit self->resultReady(rowQuery, count, rows);
+         }
+         else
+         {
+            emit self->searchFailed(error);
+         }
+      }, Qt::QueuedConnection);
+   } );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,117 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       statementcache.cpp
+ * @brief      Cache of prepared statements per connection
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <statementcache.hpp>
+#include <QCache>
+#include <QHash>
+#include <QThreadStorage>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+typedef QCache< QString, QSharedPointer<QSqlQuery> > CStatements;
+
+
+/** @brief Least recently used statements of the connections of one thread
+ *
+ * Deleted by the thread when it ends, so are the queries.
+ */
+class CThreadStatements
+{
+public:
+   ~CThreadStatements()
+   {
+      qDeleteAll(m_connections);
+   }
+
+   CStatements *statements(const QString &connectionName)
+   {
+      CStatements *&statements=m_connections[connectionName];
+
+      if(!statements)
+      {
+         statements=new CStatements(CStatementCache::MaxStatements);
+      }
+
+      return(statements);
+   }
+
+   void remove(const QString &connectionName)
+   {
+      delete m_connections.take(connectionName);
+   }
+
+private:
+   QHash<QString, CStatements *> m_connections;
+};
+
+
+static QThreadStorage<CThreadStatements *> s_statements;
+
+
+static CThreadStatements *threadStatements()
+{
+   if( !s_statements.hasLocalData() )
+   {
+      s_statements.setLocalData( new CThreadStatements() );
+   }
+
+   return( s_statements.localData() );
+}
+
+
+QSharedPointer<QSqlQuery> CStatementCache::prepare(const QString &sql
+                                                   , const QSqlDatabase &db)
+{
+   CStatements *statements=threadStatements()->statements( db.connectionName() );
+   QSharedPointer<QSqlQuery> *cached=statements->object(sql);
+
+   // An active one is still iterated by somebody; resetting it would end that
+   if( cached && !(*cached)->isActive() )
+   {
+      return(*cached);
+   }
+
+   QSharedPointer<QSqlQuery> query(new QSqlQuery(db));
+   query->setForwardOnly(true);
+   if(!query->prepare(sql))
+   {
+      qWarning("Could not prepare '%s': %s", qPrintable(sql)
+               , qPrintable(query->lastError().text()));
+      return(query);
+   }
+   // Replaces an active one; its user keeps it until done
+   statements->insert(sql, new QSharedPointer<QSqlQuery>(query));
+
+   return(query);
+}
+
+
+void CStatementCache::clear(const QString &connectionName)
+{
+   if( s_statements.hasLocalData() )
+   {
+      s_statements.localData()->remove(connectionName);
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -27,28 +27,164 @@
 #include <QSqlQuery>
 #include <QMessageBox>
 #include <QSpinBox>
-#include <QSqlRelationalDelegate>
+#include <QListWidget>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QCoreApplication>
+#include <statementcache.hpp>
+#include <workerpool.hpp>
+#include <queryprofiler.hpp>
+#include <relationcache.hpp>
+#include <changefeed.hpp>
+#include <rowcounter.hpp>
+#include <relationcombo.hpp>
+#include <schema.hpp>
+#include <connection.hpp>
+#include <widgetpool.hpp>
+#include <writequeue.hpp>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QVBoxLayout>
 
 
 /*--- Implementation -------------------------------------------------------*/
 
 
+/** @brief Errors of the writer not shown yet */
+static QStringList s_writeErrors;
+
+
+/** @brief Show 'error' of CWriteQueue; once for all writes of a failed group
+ *
+ * The callbacks of a group are queued together, so the message is shown
+ * after the last of them.
+ */
+static void writeFailed(QWidget *parent, const QString &error)
+{
+   if( s_writeErrors.isEmpty() )
+   {
+      QPointer<QWidget> window( parent->window() );
+      QMetaObject::invokeMethod(qApp, [window](){
+         QStringList errors=s_writeErrors;
+         s_writeErrors.clear();
+         QMessageBox::warning(window, "Unable to save"
+                              , "Error writing changes: " + errors.join("\n"));
+      }, Qt::QueuedConnection);
+   }
+   if( !s_writeErrors.contains(error) )
+   {
+      s_writeErrors << error;
+   }
+}
+
+
+/** @brief The form has a widget for 'column'; all but BLOBs, see
+ *         'createFormularWidget()'
+ */
+static bool hasEditor(const CColumnInfo &column)
+{
+   return( column.isForeignKey() || column.multiLine
+           || ( column.type != QVariant::Type::ByteArray ) );
+}
+
+
 CWarehouseTab::CWarehouseTab(const QString &table, QWidget *parent)
    :QWidget(parent)
    ,ui(new Ui::Tab)
    ,m_table(table)
+   ,m_reconciler(table)
+   ,m_searchIndex(table)
 {
    ui->setupUi(this);
+}
+
+
+void CWarehouseTab::build()
+{
+   QElapsedTimer timer;
+
+   if(m_built)
+   {
+      return;
+   }
+   m_built=true;
+   timer.start();
+
+   // Columns are read once per schema version and shared by all tabs
+   CSchema::refresh();
+   m_schema=CSchema::table(m_table);
+   if(m_schema.isNull())
+   {
+      qWarning("No table '%s'", qPrintable(m_table));
+      return;
+   }
 
-   // Create the data model:
-   model = new QSqlRelationalTableModel(ui->tableRows);
+   m_searchIndex.open();
+
+   // Create the data model; it holds the record shown in the form only.
+   // Foreign keys are plain ids, the combo boxes share the lookup models:
+   model = new CFormModel(ui->tableRows);
    // Vs.: QSqlCWarehouseTableModel::OnManualSubmit);
    model->setEditStrategy( QSqlTableModel::OnFieldChange );
 
    model->setTable(m_table);
 
-   // Set the model, hide ID column:
-   ui->tableRows->setModel(model);
+   // Columns without editor, e.g. BLOBs, are not read for the form
+   QStringList shown;
+   for(const CColumnInfo &column: m_schema->columns)
+   {
+      if( hasEditor(column) )
+      {
+         shown << column.name;
+      }
+   }
+   model->setProjection(shown);
+
+   // Read only: edits stay in the model and are never submitted
+   if( CConnection::isReadOnly() )
+   {
+      model->setEditStrategy( QSqlTableModel::OnManualSubmit );
+   }
+   // Batched mode keeps the edits and writes them together
+   else if(CEditBuffer::isEnabled())
+   {
+      model->setEditStrategy( QSqlTableModel::OnManualSubmit );
+      m_edits=new CEditBuffer(m_table, this);
+      connect(m_edits, &CEditBuffer::dirtyChanged, this, &CWarehouseTab::dirtyChanged);
+      // The form keeps its values, they are written now
+      connect(m_edits, &CEditBuffer::flushed, this, &CWarehouseTab::markDirty);
+      connect(m_edits, &CEditBuffer::flushFailed, this, [this](const QString &error){
+         QMessageBox::warning(this, "Unable to save", "Error saving changes: " + error);
+      });
+      connect(ui->pushSave, &QPushButton::pressed, m_edits, &CEditBuffer::flush);
+      connect(ui->pushRevert, &QPushButton::pressed, this, &CWarehouseTab::revertPressed);
+   }
+   // The writer thread writes the edits; the form does not wait for it
+   else if(CWriteQueue::isRunning())
+   {
+      model->setEditStrategy( QSqlTableModel::OnManualSubmit );
+      m_writeBehind=true;
+   }
+   ui->pushSave->setVisible( m_edits != nullptr );
+   ui->pushRevert->setVisible( m_edits != nullptr );
+   ui->pushAdd->setVisible( !CConnection::isReadOnly() );
+   ui->pushRemove->setVisible( !CConnection::isReadOnly() );
+   dirtyChanged(false);
+
+   // The list shows the result of the latest search
+   m_rows = new CRowModel(ui->tableRows);
+   ui->tableRows->setModel(m_rows);
+   connect(m_rows, &QAbstractItemModel::layoutChanged, this, &CWarehouseTab::keepCurrentRow);
+   if(m_edits)
+   {
+      // Sorted by Name, the written Names move their rows
+      connect(m_edits, &CEditBuffer::flushed, m_rows, [this](){
+         if( m_rows->query().key == m_rows->query().name )
+         {
+            m_rows->invalidate();
+         }
+      });
+   }
 
    // Vs.: QAbstractItemView::SingleSelection
    ui->tableRows->setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -58,159 +194,272 @@ CWarehouseTab::CWarehouseTab(const QString &table, QWidget *parent)
                0, QHeaderView::ResizeToContents);
 
    buildFormular(ui->groupBox, model, ui->tableRows);
-   if (!model->select()) {
+   if (!showRecord(-1)) {
        showError(model->lastError());
        return;
    }
-   updateCount();
-
-   ui->tableRows->setCurrentIndex(model->index(0, 0));
+   reconcile();
 
    adjustCWarehouseTable();
 
+   connect(&m_search, &CSearchScheduler::resultReady, this, &CWarehouseTab::resultReady);
+   connect(&m_search, &CSearchScheduler::searchFailed, this, [this](const QString &error){
+      qWarning("Search in '%s' failed: %s", qPrintable(m_table), qPrintable(error));
+   });
+   connect(model, &QAbstractItemModel::dataChanged, this, &CWarehouseTab::recordChanged);
+   connect(CChangeFeed::instance(), &CChangeFeed::changed, this, &CWarehouseTab::changed);
+   connect(CRowCounter::instance(), &CRowCounter::counted, this, &CWarehouseTab::totalCounted);
+
+   // Text may have been set by the workspace search before
+   if( !ui->lineSearch->text().isEmpty() )
+   {
+      m_clause=m_searchIndex.clause(ui->lineSearch->text());
+   }
+   refresh(true);
+
    connect(ui->lineSearch, SIGNAL( textChanged( const QString & ) ), this, SLOT(searchChanged( const QString & )));
    connect(ui->lineSearchId, SIGNAL( textChanged( const QString & ) ), this, SLOT(searchChangedId( const QString & )));
    connect(ui->pushAdd, SIGNAL(pressed()), this, SLOT(addPressed()));
    connect(ui->pushRemove, SIGNAL(pressed()), this, SLOT(removePressed()));
 
+   qCDebug(lcTiming, "Built tab '%s' in %lld ms", qPrintable(m_table), timer.elapsed());
 }
 
 
-CWarehouseTab::~CWarehouseTab()
+void CWarehouseTab::reload()
 {
-   delete ui;
+   if(!m_built)
+   {
+      // Reads everything when shown anyway
+      return;
+   }
+   // Without the update hook rows written meanwhile may not be counted yet
+   if( !CChangeFeed::isInstalled() )
+   {
+      CRowCounter::recount(m_table);
+   }
+   reconcile();
+   refresh(true);
 }
 
 
-int CWarehouseTab::adjustCWarehouseTable()
+void CWarehouseTab::showEvent(QShowEvent *event)
+{
+   // Nothing is loaded until the tab is shown the first time
+   build();
+   m_releaseTimer.stop();
+   growFormular();
+   QWidget::showEvent(event);
+}
+
+
+void CWarehouseTab::hideEvent(QHideEvent *event)
 {
-   int nameIndex=0;
+   if(m_built)
+   {
+      m_releaseTimer.start(ReleaseDelay);
+   }
+   QWidget::hideEvent(event);
+}
+
 
-   //qWarning() << "Adjusting " << model->columnCount() << " fields";
-   for(int i1=0; i1<model->columnCount(); i1++)
+CWarehouseTab::~CWarehouseTab()
+{
+   // A search still running on a worker is not delivered anymore
+   m_search.cancel();
+   if(m_edits)
    {
-      QString fieldName=model->record().field(i1).name();
-      if( fieldName != "Name" )
-      {
-         // qWarning() << "Hide " << model->fieldIndex( fieldName );
-         ui->tableRows->setColumnHidden(model->fieldIndex( fieldName ), true );
-      }
-      else
-      {
-         nameIndex=i1;
-      }
+      // Do not lose edits when closing
+      m_edits->disconnect(this);
+      m_edits->flush();
+   }
+   if(m_scrollArea)
+   {
+      releaseFormular();
    }
+   delete ui;
+}
 
-   ui->tableRows->setColumnWidth(nameIndex, 512*10 );
 
-   return(nameIndex);
+int CWarehouseTab::adjustCWarehouseTable()
+{
+   // Only the name is shown, the id is needed to load the record
+   ui->tableRows->setColumnHidden(CRowModel::ColumnId, true );
+   ui->tableRows->setColumnWidth(CRowModel::ColumnName, 512*10 );
+
+   // Clicking the header sorts by SQL, not the rows read; no sorting first
+   QHeaderView *header=ui->tableRows->horizontalHeader();
+   header->setSectionsClickable(true);
+   header->setSortIndicatorShown(true);
+   header->setSortIndicator(-1, Qt::AscendingOrder);
+   connect(header, &QHeaderView::sortIndicatorChanged, this, &CWarehouseTab::sortChanged);
+
+   return(CRowModel::ColumnName);
 }
 
 
 void CWarehouseTab::buildFormular(QGroupBox *groupBox
-         , QSqlRelationalTableModel *model, QTableView *CWarehouseTable)
+         , QSqlTableModel *model, QTableView *CWarehouseTable)
 {
-   m_gridLayout=new QGridLayout(groupBox);
+   // Wide tables scroll; rows are built when they come into view
+   QVBoxLayout *groupLayout=new QVBoxLayout(groupBox);
+   m_scrollArea=new QScrollArea(groupBox);
+   m_scrollArea->setWidgetResizable(true);
+   m_scrollArea->setFrameShape(QFrame::NoFrame);
+   groupLayout->addWidget(m_scrollArea);
+
+   QWidget *formular=new QWidget(m_scrollArea);
+   QVBoxLayout *formularLayout=new QVBoxLayout(formular);
+   m_gridLayout=new QGridLayout();
    m_gridLayout->setObjectName(QString::fromUtf8("gridLayout"));
+   formularLayout->addLayout(m_gridLayout);
+   formularLayout->addStretch();
+   m_scrollArea->setWidget(formular);
 
    m_mapper = new QDataWidgetMapper(this);
    m_mapper->setModel(model);
-   m_mapper->setItemDelegate( new QSqlRelationalDelegate(this) );
-   int yPos=0;
-
-   for(int i1=0; i1<model->columnCount(); i1++)
+   // Editors are mapped by their user property, e.g. 'currentId'
+   m_mapper->setItemDelegate( new QItemDelegate(this) );
+   if( CConnection::isReadOnly() )
    {
-      QSqlRecord record = model->database().record(model->tableName());
-      QSqlField field = record.field(i1);
+      m_mapper->setSubmitPolicy( QDataWidgetMapper::ManualSubmit );
+   }
 
-      if(field.name() == "id")
-      {
-         // We may continue if we dont want to see the id
-         //continue;
-      }
-      QLabel *label=new QLabel(groupBox);
-      label->setObjectName(QString::fromUtf8("label"));
-      m_gridLayout->addWidget(label, yPos, 0, 1, 1);
+   connect(CWarehouseTable->selectionModel(), &QItemSelectionModel::currentRowChanged,
+           this, &CWarehouseTab::currentRowChanged );
 
-      QWidget *editElement=nullptr;
-      QString fieldName=field.name();
+   updateRelation();
 
-      QModelIndex modelIndex = model->index(0, yPos);
+   connect(m_scrollArea->verticalScrollBar(), &QScrollBar::valueChanged
+           , this, &CWarehouseTab::growFormular);
+   m_scrollArea->viewport()->installEventFilter(this);
 
-      int fieldIndex=model->fieldIndex( fieldName );
+   m_releaseTimer.setSingleShot(true);
+   connect(&m_releaseTimer, &QTimer::timeout, this, &CWarehouseTab::releaseFormular);
 
-      if(fieldIndex<0)
-      {
-         qWarning("Could not find field index for '%s'", qPrintable( fieldName ));
-         continue;
-      }
+   growFormular();
+}
 
-      label->setText( fieldName.split("_")[0] );
-      editElement=createFormularWidget(groupBox, field, modelIndex );
 
-      if(editElement)
-      {
-         m_gridLayout->addWidget(editElement, yPos, 1, 1, 1);
-      }
+void CWarehouseTab::growFormular()
+{
+   if( !m_built || !m_scrollArea )
+   {
+      return;
+   }
+
+   // One screen ahead of the visible rows
+   QScrollBar *bar=m_scrollArea->verticalScrollBar();
+   int wanted=bar->value() + 2 * m_scrollArea->viewport()->height();
+   int rows=m_formularRows;
 
-      if(!editElement)
+   while( ( m_formularRows < m_schema->columns.size() )
+          && ( m_gridLayout->sizeHint().height() < wanted ) )
+   {
+      for(int i1=0; ( i1<FormularChunk ) && ( m_formularRows<m_schema->columns.size() ); i1++)
       {
-         qFatal("no element");
+         buildRow(m_formularRows);
+         m_formularRows++;
       }
-      yPos++;
    }
 
-   connect(CWarehouseTable->selectionModel(), &QItemSelectionModel::currentRowChanged,
-           m_mapper, &QDataWidgetMapper::setCurrentModelIndex );
-
-   QSpacerItem *verticalSpacer = new QSpacerItem(358, 182, QSizePolicy::Minimum, QSizePolicy::Expanding);
-   m_gridLayout->addItem(verticalSpacer, 10, 0, 1, 2);
-
-   updateRelation();
+   if( m_formularRows != rows )
+   {
+      markDirty();
+   }
 }
 
 
-void CWarehouseTab::updateRelation()
+void CWarehouseTab::buildRow(int row)
 {
-   QSqlRelationalTableModel *model=
-         dynamic_cast<QSqlRelationalTableModel *> ( m_mapper->model() );
-   int yPos=0;
+   const CColumnInfo &column=m_schema->columns[row];
+   QWidget *formular=m_scrollArea->widget();
 
-   for(int i1=0; i1<model->columnCount(); i1++)
+   // Not read, see 'setProjection()'
+   if( !hasEditor(column) )
    {
-      QSqlRecord record = model->database().record(model->tableName());
-      QSqlField field = record.field(i1);
-      QWidget *editElement=nullptr;
+      return;
+   }
 
-      if(field.name() == "id")
-      {
-         // We may continue if we dont want to see the id
-         //continue;
-      }
-      QString fieldName=field.name();
-      QModelIndex modelIndex = model->index(0, yPos);
-      int fieldIndex=model->fieldIndex( fieldName );
+   QLabel *label=static_cast<QLabel *>( CWidgetPool::take(CWidgetPool::Label, formular) );
+   label->setObjectName(QString::fromUtf8("label"));
+   label->setText( column.label );
+   m_gridLayout->addWidget(label, row, 0, 1, 1);
+
+   int fieldIndex=model->fieldIndex( column.name );
+   if(fieldIndex<0)
+   {
+      qWarning("Could not find field index for '%s'", qPrintable( column.name ));
+      return;
+   }
+
+   QWidget *editElement=createFormularWidget(formular, column);
+   if(!editElement)
+   {
+      qFatal("no element");
+   }
+   m_gridLayout->addWidget(editElement, row, 1, 1, 1);
+
+   if( column.isForeignKey() )
+   {
+      CRelationCombo *comboBox=static_cast<CRelationCombo *>(editElement);
+      // One model per referenced table, shared by all tabs
+      comboBox->setLookup( CRelationCache::model( column.foreignTable ) );
+      connect(comboBox, &CRelationCombo::currentIdEdited, m_mapper, &QDataWidgetMapper::submit);
+   }
+
+   // Filled with the current record by the mapper
+   m_mapper->addMapping(editElement, fieldIndex);
+}
 
-      editElement=m_gridLayout->itemAtPosition(yPos, 1)->widget();
 
-      if( (field.name() != "id") && isForeignKey( field.name() ))
+void CWarehouseTab::releaseFormular()
+{
+   // Hidden for a while; other forms may use the widgets meanwhile
+   for(int i1=0; i1<m_formularRows; i1++)
+   {
+      for(int i2=0; i2<2; i2++)
       {
-         model->setRelation(fieldIndex, QSqlRelation( foreignKeyTable(fieldName), "id", "Name"));
-         QComboBox *comboBox=dynamic_cast<QComboBox *>(editElement);
-         if(comboBox == nullptr)
+         QLayoutItem *item=m_gridLayout->itemAtPosition(i1, i2);
+         QWidget *widget=item ? item->widget() : nullptr;
+         if(!widget)
          {
-            qFatal("Could not get Widget");
+            continue;
          }
-         comboBox->setModel(model->relationModel(fieldIndex));
-         qWarning("Model! %s - %d", qPrintable(foreignKeyTable(fieldName))
-                  , fieldIndex);
-         comboBox->setModelColumn(
-                     model->relationModel(fieldIndex)->fieldIndex("Name"));
+         m_mapper->removeMapping(widget);
+         widget->disconnect(m_mapper);
+         m_gridLayout->removeWidget(widget);
+         CWidgetPool::release(widget);
       }
+   }
+   m_formularRows=0;
+}
+
+
+bool CWarehouseTab::eventFilter(QObject *watched, QEvent *event)
+{
+   // More rows fit into a larger form
+   if( m_scrollArea && ( watched == m_scrollArea->viewport() )
+       && ( event->type() == QEvent::Resize ) )
+   {
+      growFormular();
+   }
+
+   return( QWidget::eventFilter(watched, event) );
+}
+
 
-      m_mapper->addMapping(editElement, model->fieldIndex( field.name() ));
+void CWarehouseTab::updateRelation()
+{
+   m_reconciler.clearRelations();
 
-      yPos++;
+   // All relations count, also of rows of the form not built yet
+   for(const CColumnInfo &column: m_schema->columns)
+   {
+      if( column.isForeignKey() )
+      {
+         m_reconciler.addRelation(column.name, column.foreignTable);
+      }
    }
 }
 
@@ -224,131 +473,690 @@ void CWarehouseTab::showError(const QSqlError &err)
 
 void CWarehouseTab::addPressed()
 {
-   QSqlRecord record = model->database().record(model->tableName());
+   QSqlRecord record = m_schema->record;
 
-   for(int i1=0; i1<record.count(); i1++)
+   if( CConnection::isReadOnly() )
    {
-      QSqlField field = record.field(i1);
-      QString fieldName=field.name();
+      return;
+   }
 
+   if(m_writeBehind)
+   {
+      QHash<QString, QVariant> values;
+      for(const CColumnInfo &column: m_schema->columns)
+      {
+         if(column.isForeignKey())
+         {
+            values.insert(column.name, 1);
+         }
+      }
+      // Removing would hit the record shown, not the new one
+      m_pendingInserts++;
+      ui->pushRemove->setEnabled(false);
+      CWriteQueue::insert(m_table, values, model, this, [this](qint64 id, const QString &error){
+         m_pendingInserts--;
+         ui->pushRemove->setEnabled( m_pendingInserts == 0 );
+         if(!error.isEmpty())
+         {
+            writeFailed(this, error);
+            return;
+         }
+         rowInserted(id, true);
+      });
+      return;
+   }
+
+   for(int i1=0; i1<m_schema->columns.size(); i1++)
+   {
       // Need to be done or record is invalid
-      if(isForeignKey(fieldName))
+      if(m_schema->columns[i1].isForeignKey())
       {
          record.setValue(i1, 1);
       }
    }
+   // Edits of the shown record are the buffer's to write; submitting them
+   // with the new row would write them twice
+   if(m_edits)
+   {
+      model->revertAll();
+   }
    bool sta=model->insertRecord(-1, record);
 
-   model->submitAll();
-   // model->database().commit();
-   model->select();
-   updateCount();
+   // Only the new row is pending in batched mode
+   if( model->editStrategy() == QSqlTableModel::OnManualSubmit )
+   {
+      sta=sta && model->submitAll();
+   }
+
+   QSharedPointer<QSqlQuery> query=CStatementCache::prepare("SELECT last_insert_rowid()");
+   if( sta && query->exec() && query->next() )
+   {
+      qint64 id=query->value(0).toLongLong();
+      query->finish();
+      rowInserted(id, true);
+   }
 }
 
 
 void CWarehouseTab::removePressed()
 {
-   model->removeRow( ui->tableRows->currentIndex().row() );
-   model->select();
+   qint64 id=m_currentId;
+
+   if( CConnection::isReadOnly() )
+   {
+      return;
+   }
+
+   if(m_edits)
+   {
+      m_edits->discard(m_currentId);
+      model->revertAll();
+   }
+
+   if(m_writeBehind)
+   {
+      if(m_pendingInserts)
+      {
+         return;
+      }
+      // Shown until the row is gone from the file
+      CWriteQueue::remove(m_table, id, model, this, [this](qint64 id, const QString &error){
+         if(!error.isEmpty())
+         {
+            writeFailed(this, error);
+            return;
+         }
+         m_pending.remove(id);
+         rowRemoved(id);
+      });
+      return;
+   }
+
+   if( !model->rowCount() || !model->removeRow( 0 ) )
+   {
+      return;
+   }
+
+   if( ( model->editStrategy() == QSqlTableModel::OnManualSubmit )
+       && !model->submitAll() )
+   {
+      showError(model->lastError());
+      return;
+   }
+
+   rowRemoved(id);
+}
+
+
+void CWarehouseTab::rowRemoved(qint64 id)
+{
+   int row=m_rows->rowOf(id);
+   int missing=-1;
+
+   for(int i1=0; i1<m_report.missing.size(); i1++)
+   {
+      if( m_report.missing[i1].first == id )
+      {
+         missing=i1;
+      }
+   }
+
+   if(m_reconciling)
+   {
+      // The pending pass may not see the removal; count again
+      reconcile();
+   }
+   else if( missing >= 0 )
+   {
+      m_report.total--;
+      m_report.missingCount--;
+      m_report.missing.remove(missing);
+      showReport();
+   }
+   else if( row >= 0 )
+   {
+      // A listed row was not one of the missing ones
+      m_report.total--;
+      m_report.visible--;
+   }
+   else
+   {
+      // Not in the pages read; may be listed further down or missing
+      reconcile();
+   }
+
+   if(row >= 0)
+   {
+      m_rows->removeRowAt(row);
+   }
+   else if( missing < 0 )
+   {
+      refresh(false);
+   }
+
+   if( id == m_currentId )
+   {
+      m_currentId=-1;
+
+      // The row behind moves up into the place of the removed one
+      row=qMin(m_currentRow, m_rows->rowCount()-1);
+      if(row >= 0)
+      {
+         ui->tableRows->setCurrentIndex( m_rows->index(row, CRowModel::ColumnName) );
+      }
+      if( m_currentId != m_rows->rowId(row) )
+      {
+         showRecord( m_rows->rowId(row) );
+      }
+   }
    updateCount();
+}
+
+
+void CWarehouseTab::rowUpdated(qint64 id)
+{
+   int row=m_rows->rowOf(id);
 
-   qWarning("Removing");
+   if( row >= 0 )
+   {
+      QSqlDatabase db=QSqlDatabase::database();
+      QSharedPointer<QSqlQuery> query=CStatementCache::prepare(
+               QString("SELECT Name FROM %1 WHERE id = ?").arg(CConnection::escapeTable(m_table)), db );
+      query->addBindValue(id);
+      CQueryTimer timer(m_table, CQueryProfiler::Select, query->lastQuery(), { id }, db);
+      if( query->exec() && query->next() )
+      {
+         m_rows->setName( id, query->value(0).toString() );
+      }
+      query->finish();
+      timer.finish(1);
+   }
+
+   // Values written by somebody else; unsaved edits are kept on top
+   if( id == m_currentId )
+   {
+      showRecord(id);
+   }
 }
 
 
-void CWarehouseTab::searchChanged(const QString &line)
+void CWarehouseTab::changed(const CChanges &changes)
 {
-   if ( line.size() || false )
+   CChanges rows;
+   bool unknown=false;
+   bool related=false;
+
+   for(const CChange &change: changes)
    {
-      QString search;
-      QSqlRecord record = model->database().record(model->tableName());
-      
-      for(int i1=0; i1<model->columnCount(); i1++)
+      if( change.table == m_table )
       {
-         QSqlField field = record.field(i1);
-         if(i1)
+         // Rows written by this tab are shown already
+         if( change.origin
+             && ( ( change.origin == model ) || ( change.origin == m_edits ) ) )
          {
-            search+= " OR ";
+            continue;
          }
-         search += model->tableName() + ".'" + field.name() + "' LIKE '%%" + line + "%%'";
+         unknown=unknown || ( change.op == CChange::Unknown );
+         rows.append(change);
+         continue;
+      }
+
+      // New or removed keys may hide or show rows
+      for(const CColumnInfo &column: m_schema->columns)
+      {
+         if( ( column.foreignTable == change.table ) && ( change.op != CChange::Update ) )
+         {
+            related=true;
+         }
+      }
+   }
+
+   if( unknown || related || ( rows.size() > MaxPatches ) )
+   {
+      // Cheaper to count and search again than to patch row by row
+      reconcile();
+      refresh(false);
+      if( m_currentId >= 0 )
+      {
+         showRecord(m_currentId);
+      }
+      return;
+   }
+
+   // Searching or with references, updates may change what is listed
+   bool relations=!m_reconciler.missingStatement().isEmpty();
+   bool filtered=!m_clause.where.isEmpty() || !m_clause.join.isEmpty();
+   bool search=false;
+
+   for(const CChange &change: rows)
+   {
+      switch(change.op)
+      {
+         case CChange::Insert:
+            rowInserted(change.rowid, false);
+            break;
+         case CChange::Delete:
+            rowRemoved(change.rowid);
+            break;
+         default:
+            rowUpdated(change.rowid);
+            search=search || filtered || relations;
+            break;
+      }
+   }
+
+   if(search)
+   {
+      if(relations)
+      {
+         reconcile();
       }
-      
-      model->setFilter( search );
-      bool ret=false;
-      ret=model->select();
+      refresh(false);
+   }
+}
+
+
+void CWarehouseTab::rowInserted(qint64 id, bool select)
+{
+   const CRowQuery &query=m_rows->query();
+
+   if(m_reconciling)
+   {
+      // The pending pass may not see the new row; count again
+      reconcile();
+   }
+   else if( m_reconciler.isMissing(id) )
+   {
+      // Not listed; only the report changes
+      m_report.total++;
+      m_report.missingCount++;
+      m_report.missing.append( { id, QString() } );
+      showReport();
+      updateCount();
+      return;
    }
    else
    {
-      model->setFilter( QString() );
-      model->select();
+      m_report.total++;
+      m_report.visible++;
    }
+
+   CRow data;
+   if( m_rows->fetch(id, &data) )
+   {
+      // Where the ORDER BY puts it, e.g. an empty Name first
+      int row=m_rows->position(data);
+      if(row < 0)
+      {
+         refresh(select);
+         return;
+      }
+      m_rows->insertRowAt(row, data);
+      if(select)
+      {
+         QModelIndex index=m_rows->index(row, CRowModel::ColumnName);
+         ui->tableRows->setCurrentIndex(index);
+         ui->tableRows->scrollTo(index);
+      }
+   }
+   else if(select)
+   {
+      showRecord(id);
+   }
+
    updateCount();
 }
 
 
+void CWarehouseTab::searchChanged(const QString &line)
+{
+   // Uses the full text index if available, LIKE over all columns otherwise
+   m_clause=m_searchIndex.clause(line);
+   refresh(false);
+}
+
+
+void CWarehouseTab::setSearchText(const QString &text)
+{
+   // Searches by the signal once built
+   ui->lineSearch->setText(text);
+}
+
+
 void CWarehouseTab::searchChangedId(const QString &line)
 {
-   if ( line.size() || false )
+   m_clause=m_searchIndex.idClause(line);
+   refresh(false);
+}
+
+
+void CWarehouseTab::sortChanged(int section, Qt::SortOrder order)
+{
+   m_sortColumn=section;
+   m_sortOrder=order;
+   refresh(true);
+}
+
+
+void CWarehouseTab::refresh(bool immediate)
+{
+   CRowQuery query=m_reconciler.rowQuery(m_clause);
+
+   // A sorted header replaces the rank of the full text search
+   if( m_sortColumn == CRowModel::ColumnName )
+   {
+      query.key=query.name;
+   }
+   else if( m_sortColumn == CRowModel::ColumnId )
+   {
+      query.key.clear();
+   }
+   query.descending=( m_sortColumn >= 0 ) && ( m_sortOrder == Qt::DescendingOrder );
+
+   // All rows of a table without relations are listed; no need to count
+   if( m_clause.where.isEmpty() && m_clause.join.isEmpty()
+       && m_reconciler.missingStatement().isEmpty() )
+   {
+      query.count=CRowCounter::count(m_table);
+   }
+   m_search.schedule(query);
+   if(immediate)
+   {
+      m_search.flush();
+   }
+}
+
+
+void CWarehouseTab::resultReady(const CRowQuery &query, int count
+                                , const CRows &firstPage)
+{
+   int row;
+
+   m_rows->setQuery(query, count, firstPage);
+
+   // Keep the record selected if it is still listed
+   row=m_rows->rowOf(m_currentId);
+   if(row < 0)
+   {
+      row=qMin(m_currentRow, m_rows->rowCount()-1);
+   }
+   if(row >= 0)
    {
-      /* Take care that the CWarehouseTable name is given on views with CWarehouseTable relations */
-      QString search=QString(
-                           model->tableName() + ".id=" + line
-                           );
-      model->setFilter( search );
-      bool ret=false;
-      ret=model->select();
+      ui->tableRows->setCurrentIndex( m_rows->index(row, CRowModel::ColumnName) );
    }
    else
    {
-      model->setFilter( QString() );
-      model->select();
+      showRecord(-1);
+   }
+
+   updateCount();
+   emit listed();
+}
+
+
+void CWarehouseTab::keepCurrentRow()
+{
+   CRow data;
+   int row;
+
+   if( ( m_currentId < 0 ) || !m_rows->fetch(m_currentId, &data) )
+   {
+      return;
+   }
+   row=m_rows->position(data);
+   if( row < 0 )
+   {
+      return;
+   }
+
+   // Same record, so it is not read again
+   QSignalBlocker blocker( ui->tableRows->selectionModel() );
+   m_currentRow=row;
+   ui->tableRows->setCurrentIndex( m_rows->index(row, CRowModel::ColumnName) );
+   ui->tableRows->viewport()->update();
+}
+
+
+void CWarehouseTab::currentRowChanged(const QModelIndex &current)
+{
+   if(!current.isValid())
+   {
+      return;
+   }
+   m_currentRow=current.row();
+   showRecord( m_rows->rowId(current.row()) );
+}
+
+
+bool CWarehouseTab::showRecord(qint64 id)
+{
+   bool ret=true;
+
+   m_loading=true;
+
+   // With a flush interval of 0 the edits are written on row change
+   if( m_edits && ( CEditBuffer::flushInterval() == 0 ) && ( id != m_currentId ) )
+   {
+      m_edits->flush();
+   }
+
+   // Point lookup by primary key
+   m_currentId=id;
+   model->setFilter( QString("%1.id = %2").arg(CConnection::escapeTable(m_table)).arg(id) );
+   if( !model->select() )
+   {
+      qWarning("Could not load record %lld: %s", id
+               , qPrintable(model->lastError().text()));
+      ret=false;
+   }
+   else if( ( m_edits || m_writeBehind ) && model->rowCount() )
+   {
+      // Show the edits which are not written yet
+      QHash<QString, QVariant> values=m_edits ? m_edits->values(id) : m_pending.value(id);
+      for(auto it=values.constBegin(); it!=values.constEnd(); ++it)
+      {
+         model->setData( model->index(0, m_schema->indexOf(it.key())), it.value() );
+      }
+   }
+   m_mapper->toFirst();
+   markDirty();
+
+   m_loading=false;
+
+   return(ret);
+}
+
+
+void CWarehouseTab::recordChanged(const QModelIndex &topLeft
+                                  , const QModelIndex &bottomRight)
+{
+   if( !model->rowCount() )
+   {
+      return;
+   }
+
+   m_rows->setName( m_currentId, model->record(0).value("Name").toString() );
+
+   if(m_loading)
+   {
+      return;
+   }
+
+   if(m_writeBehind)
+   {
+      writeBehind(topLeft.column(), bottomRight.column());
+      return;
+   }
+
+   if(!m_edits)
+   {
+      // Written already; the change feed updates the combo boxes
+      return;
+   }
+
+   for(int i1=topLeft.column(); i1<=bottomRight.column(); i1++)
+   {
+      QModelIndex index=model->index(0, i1);
+      if(model->isDirty(index))
+      {
+         m_edits->set( m_currentId, m_schema->columns[i1].name, model->data(index, Qt::EditRole) );
+      }
+   }
+   markDirty();
+}
+
+
+void CWarehouseTab::writeBehind(int first, int last)
+{
+   qint64 id=m_currentId;
+   QHash<QString, QVariant> values;
+
+   for(int i1=first; i1<=last; i1++)
+   {
+      QModelIndex index=model->index(0, i1);
+      if(model->isDirty(index))
+      {
+         values.insert( m_schema->columns[i1].name, model->data(index, Qt::EditRole) );
+      }
+   }
+   if(values.isEmpty())
+   {
+      return;
+   }
+
+   // Kept until written, so selecting the row again shows them
+   for(auto it=values.constBegin(); it!=values.constEnd(); ++it)
+   {
+      m_pending[id].insert(it.key(), it.value());
+   }
+
+   CWriteQueue::update(m_table, id, values, model, this
+                       , [this, values](qint64 id, const QString &error){
+      QHash<QString, QVariant> &pending=m_pending[id];
+
+      // Edited again meanwhile; that value is still on its way
+      for(auto it=values.constBegin(); it!=values.constEnd(); ++it)
+      {
+         if( pending.value(it.key()) == it.value() )
+         {
+            pending.remove(it.key());
+         }
+      }
+      if(pending.isEmpty())
+      {
+         m_pending.remove(id);
+      }
+
+      if(!error.isEmpty())
+      {
+         writeFailed(this, error);
+         m_pending.remove(id);
+         if( id == m_currentId )
+         {
+            showRecord(id);
+         }
+      }
+   });
+}
+
+
+void CWarehouseTab::markDirty()
+{
+   if(!m_edits)
+   {
+      return;
+   }
+
+   QHash<QString, QVariant> values=m_edits->values(m_currentId);
+
+   // Labels of fields with edits which are not written yet are bold
+   for(int i1=0; i1<m_gridLayout->rowCount(); i1++)
+   {
+      QLayoutItem *labelItem=m_gridLayout->itemAtPosition(i1, 0);
+      QLayoutItem *editItem=m_gridLayout->itemAtPosition(i1, 1);
+      if( !labelItem || !editItem || !labelItem->widget() || !editItem->widget() )
+      {
+         continue;
+      }
+      int section=m_mapper->mappedSection(editItem->widget());
+      bool dirty=( section >= 0 ) && values.contains(m_schema->columns[section].name);
+      QFont font=labelItem->widget()->font();
+      font.setBold(dirty);
+      labelItem->widget()->setFont(font);
    }
+
+   m_rows->setMarked( m_edits->dirtyIds() );
+}
+
+
+void CWarehouseTab::dirtyChanged(bool dirty)
+{
+   ui->pushSave->setEnabled(dirty);
+   ui->pushRevert->setEnabled(dirty);
 }
 
 
-QWidget *CWarehouseTab::createFormularWidget(QGroupBox *groupBox
-                           , QSqlField &field, QModelIndex &index ) const
+void CWarehouseTab::revertPressed()
+{
+   m_edits->revert();
+   model->revertAll();
+   showRecord(m_currentId);
+}
+
+
+QWidget *CWarehouseTab::createFormularWidget(QWidget *parent
+                           , const CColumnInfo &column) const
 {
    QWidget *widget=nullptr;
-   QVariant::Type type=field.type();
+   QVariant::Type type=column.type;
+   bool readOnly=CConnection::isReadOnly();
 
-   if( isForeignKey(field.name()))
+   if( column.isForeignKey() )
    {
       type=QVariant::Type::Map;
    }
 
-   if( isMultiLine(field.name()))
+   if( column.multiLine )
    {
       type=QVariant::Type::StringList;
    }
 
    switch ( type )
    {
+      // Any other type, e.g. REAL, large integers or dates, is edited as text
       case QVariant::Type::String:
+      default:
       {
+         bool number=( type == QVariant::Type::Double ) || ( type == QVariant::Type::LongLong )
+               || ( type == QVariant::Type::UInt ) || ( type == QVariant::Type::ULongLong );
+         // Widgets may come from another form; all properties are set
          QLineEdit *lineEdit;
-         lineEdit = new QLineEdit(groupBox);
+         lineEdit = static_cast<QLineEdit *>( CWidgetPool::take(CWidgetPool::LineEdit, parent) );
          lineEdit->setObjectName(QString::fromUtf8("lineEdit"));
          lineEdit->setEnabled(true);
-         lineEdit->setText( index.data().toString() );
+         lineEdit->setReadOnly(readOnly);
+         lineEdit->setAlignment( number ? ( Qt::AlignRight | Qt::AlignVCenter )
+                                        : ( Qt::AlignLeft | Qt::AlignVCenter ) );
          widget=lineEdit;
          break;
       }
       case QVariant::Type::Int:
       {
-         if(field.name()=="id")
+         if(column.name=="id")
          {
-            QLineEdit *line = new QLineEdit(groupBox);
+            QLineEdit *line = static_cast<QLineEdit *>( CWidgetPool::take(CWidgetPool::LineEdit, parent) );
             line->setObjectName(QString::fromUtf8("label"));
             line->setEnabled(false);
+            line->setReadOnly(false);
             line->setAlignment(Qt::AlignRight);
             widget=line;
          }
          else
          {
-            QSpinBox *spinBox = new QSpinBox(groupBox);
+            QSpinBox *spinBox = static_cast<QSpinBox *>( CWidgetPool::take(CWidgetPool::SpinBox, parent) );
             spinBox->setObjectName(QString::fromUtf8("spinBox"));
             spinBox->setEnabled(true);
+            spinBox->setReadOnly(readOnly);
             spinBox->setMaximum( 1<<30 );
             widget=spinBox;
          }
@@ -356,10 +1164,10 @@ QWidget *CWarehouseTab::createFormularWidget(QGroupBox *groupBox
       }
       case QVariant::Type::Map:
       {
-         QComboBox *comboBox;
-         comboBox = new QComboBox(groupBox);
+         CRelationCombo *comboBox;
+         comboBox = static_cast<CRelationCombo *>( CWidgetPool::take(CWidgetPool::RelationCombo, parent) );
          comboBox->setObjectName(QString::fromUtf8("comboBox"));
-         comboBox->setEnabled(true);
+         comboBox->setEnabled(!readOnly);
          widget=comboBox;
          break;
       }
@@ -370,9 +1178,10 @@ QWidget *CWarehouseTab::createFormularWidget(QGroupBox *groupBox
          textEdit = new QTextBrowser(groupBox);
          */
          QTextEdit *textEdit;
-         textEdit = new QTextEdit(groupBox);
+         textEdit = static_cast<QTextEdit *>( CWidgetPool::take(CWidgetPool::TextEdit, parent) );
          textEdit->setObjectName(QString::fromUtf8("lineEdit"));
          textEdit->setEnabled(true);
+         textEdit->setReadOnly(readOnly);
          textEdit->setAcceptRichText(true);
          //QTextDocument
          //textEdit->setDocument()
@@ -382,97 +1191,123 @@ QWidget *CWarehouseTab::createFormularWidget(QGroupBox *groupBox
          widget=textEdit;
          break;
       }
-      default:
-      {
-         qWarning("unknonw data type: %d", (int)field.type() );
-         break;
-      }
    }
 
    return(widget);
 }
 
 
-bool CWarehouseTab::isForeignKey(const QString &name) const
+void CWarehouseTab::reconcile()
 {
-   bool foreign=false;
-   QStringList list=name.split("_");
+   CRowCounter::request(m_table);
 
-   if( ( list.size() >= 3 ) && ( list[1].toLower() == "id" ) )
+   // Without relations no row is hidden and the total is kept by
+   // CRowCounter, so nothing has to be counted here
+   if( m_reconciler.missingStatement().isEmpty() )
    {
-      foreign=true;
+      m_reconcileGeneration++;
+      m_report=CReconcileReport();
+      showReport();
+      m_reconciling=CRowCounter::isCounting(m_table);
+      updateCount();
+      if(!m_reconciling)
+      {
+         // Asynchronous like a count, so callers may connect afterwards
+         QMetaObject::invokeMethod(this, [this](){ emit counted(); }, Qt::QueuedConnection);
+      }
+      return;
    }
 
-   return(foreign);
+   // Counting is done by SQLite in one pass; iterating the model is
+   // quadratic and 'model->rowCount()' only knows the rows fetched so far.
+   // The pass runs on a worker, so the tabs of a large database count at
+   // the same time and the GUI does not wait for it.
+   QString countStatement=m_reconciler.countStatement();
+   QString missingStatement=m_reconciler.missingStatement();
+   QPointer<CWarehouseTab> self(this);
+   QString table=m_table;
+   int generation=++m_reconcileGeneration;
+
+   m_reconciling=true;
+
+   CWorkerPool::start( [=](const QSqlDatabase &db){
+      CQueryTimer timer(table, CQueryProfiler::Count, countStatement
+                        , QVariantList(), db);
+      CReconcileReport report=CReconciler::execute(countStatement
+                                                   , missingStatement, db);
+      timer.finish(report.missing.size() + 1);
+
+      QMetaObject::invokeMethod(qApp, [=](){
+         // Only the latest pass counts, rows may have changed meanwhile
+         if( !self || ( self->m_reconcileGeneration != generation ) )
+         {
+            return;
+         }
+         self->m_reconciling=false;
+         self->m_report=report;
+         self->showReport();
+         self->updateCount();
+         emit self->counted();
+      }, Qt::QueuedConnection);
+   } );
 }
 
 
-QString CWarehouseTab::foreignKeyTable(const QString &name) const
+void CWarehouseTab::totalCounted(const QString &table)
 {
-   QString foreignCWarehouseTable;
-   QStringList list=name.split("_");
-
-   if( ( list.size() >= 3 ) && ( list[1].toLower() == "id" ) )
+   if( table != m_table )
    {
-      foreignCWarehouseTable=list[0];
+      return;
    }
 
-   return(foreignCWarehouseTable);
+   // Tables without relations only wait for the total
+   if( m_reconciling && m_reconciler.missingStatement().isEmpty() )
+   {
+      m_reconciling=false;
+      updateCount();
+      emit counted();
+      return;
+   }
+   updateCount();
 }
 
-void CWarehouseTab::updateCount() const
-{
-   int modelCount;
-   QSqlQuery query( QString("SELECT id, Name FROM %1").arg(m_table) );
-   int databaseCount = query.size();
-   databaseCount=0;
-
-   qWarning() << "Checking CWarehouseTable '" << m_table << "'";
 
-   // model->rowCount() is limitted to 256 for some reason. Nevertheless all
-   // items are shown in the GUI. We have to iterate manually over the records.
-   modelCount=0;
-   QSqlQuery modelQuery(model->query());
-   if(modelQuery.first())
+void CWarehouseTab::showReport()
+{
+   // Report rows that are hidden due to missing keys
+   ui->listMissing->clear();
+   for(const auto &row: m_report.missing)
    {
-      modelCount++;
-      while (modelQuery.next()) {
-         modelCount++;
-      }
+      ui->listMissing->addItem( QString("%1: %2").arg(row.first).arg(row.second) );
    }
+   if( m_report.missingCount > m_report.missing.size() )
+   {
+      ui->listMissing->addItem( QString("... %1 more")
+                     .arg(m_report.missingCount - m_report.missing.size()) );
+   }
+   ui->listMissing->setToolTip( QString("%1 record(s) not available due to missing keys")
+                     .arg(m_report.missingCount) );
+   ui->listMissing->setVisible( m_report.missingCount > 0 );
+}
 
-   while (query.next()) {
-       int id = query.value(0).toInt();
-       bool found=false;
-       databaseCount++;
-
-       for(int i1=0; i1<modelCount; i1++)
-       {
-         if( model->record(i1).value(0).toInt() == id)
-         {
-            found=true;
-            break;
-         }
-       }
 
-       if(!found)
-       {
-          qWarning() << "   Record not available due to missing keys: "
-                     << id << ": "
-                     << query.value(1).toString();
-       }
-   }
+void CWarehouseTab::updateCount() const
+{
+   bool filtered=!m_clause.where.isEmpty() || !m_clause.join.isEmpty();
+   int visible=m_rows->rowCount();
+   qint64 total=CRowCounter::count(m_table);
 
-   QString line=QString("%1/%2").arg(modelCount).arg(databaseCount);
+   // The total is not known before the first count
+   QString line=QString("%1/%2").arg(visible)
+         .arg( ( total < 0 ) ? QString("...") : QString::number(total) );
    ui->labelCount->setText(line);
-   qWarning() << "Updating " << m_table << ": " << line;
-
 
    QPalette palette = ui->labelCount->palette();
    palette.setColor(QPalette::WindowText, Qt::black);
-   if(model->filter().isNull())
+   if( !filtered && !m_reconciling )
    {
-      if( modelCount != databaseCount)
+      // Rows are hidden; the total may be updated a bit later than the list
+      if( m_report.missingCount > 0 )
       {
          palette.setColor(QPalette::WindowText, Qt::red);
       }
@@ -482,30 +1317,4 @@ void CWarehouseTab::updateCount() const
 }
 
 
-bool CWarehouseTab::isMultiLine(const QString &name) const
-{
-   bool multiLine=false;
-
-   if( (name=="Description")  )
-   {
-      multiLine=true;
-   }
-
-   return(multiLine);
-}
-
-
-void CWarehouseTab::dump()
-{
-   QSqlQuery query( QString("SELECT id, Name FROM %1").arg(m_table) );
-   int databaseCount = query.size();
-
-   printf( "|_. Id |_. Name |\n" );
-   while (query.next()) {
-       int id = query.value(0).toInt();
-       printf("| %d | %s |\n", id, qPrintable( query.value(1).toString() ) );
-   }
-}
-
-
 /*--- Fin ------------------------------------------------------------------*/
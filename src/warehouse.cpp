@@ -18,17 +18,29 @@
 #include <warehouse.hpp>
 //#include <warehousedelegate.hpp>
 #include <tab.hpp>
+#include <dbprofile.hpp>
+#include <schema.hpp>
+#include <connection.hpp>
+#include <importer.hpp>
+#include <changefeed.hpp>
+#include <rowcounter.hpp>
+#include <workerpool.hpp>
+#include <writequeue.hpp>
+#include <diagnosticsdock.hpp>
+#include <workspacesearch.hpp>
+#include <queryprofiler.hpp>
 #include <QtSql>
 
 
 /*--- Implementation -------------------------------------------------------*/
 
 
-CWarehouse::CWarehouse(const QString &databaseFile)
+CWarehouse::CWarehouse(const QStringList &databaseFiles)
 {
     ui.setupUi(this);
 
-    setWindowTitle( "Warehouse " + databaseFile );
+    setWindowTitle( "Warehouse " + databaseFiles.join(", ")
+                    + ( CConnection::isReadOnly() ? tr(" (read only)") : QString() ) );
 
     if (!QSqlDatabase::drivers().contains("QSQLITE"))
         QMessageBox::critical(
@@ -38,7 +50,7 @@ CWarehouse::CWarehouse(const QString &databaseFile)
                     );
 
     // Initialize the database:
-    QSqlError err = initDb(databaseFile);
+    QSqlError err = initDb(databaseFiles);
     if (err.type() != QSqlError::NoError) {
         showError(err);
         return;
@@ -46,41 +58,254 @@ CWarehouse::CWarehouse(const QString &databaseFile)
 
     createMenuBar();
 
-    QStringList tables=QSqlDatabase::database().tables();
+    // Before watching, the writer connection is the one polled then
+    if( CWriteQueue::isEnabled() && !CConnection::isReadOnly() )
+    {
+       CWriteQueue::start();
+    }
+
+    // Other processes writing the files
+    CChangeFeed::instance()->watch();
+    connect(CRowCounter::instance(), &CRowCounter::counted, this, &CWarehouse::totalCounted);
 
+    QStringList tables=CSchema::tables();
+    QStringList schemas=CSchema::schemas();
+    QHash<QString, QTabWidget *> groups;
+
+    // A workspace gets one group of tabs per file, in the order given
+    for(int i1=0; ( schemas.size() > 1 ) && ( i1<schemas.size() ); i1++)
+    {
+       QTabWidget *group=new QTabWidget(ui.tabWidget);
+       QString title=( schemas[i1] == "main" )
+             ? QFileInfo(databaseFiles.value(0)).completeBaseName() : schemas[i1];
+       group->setObjectName(schemas[i1]);
+       ui.tabWidget->addTab(group, title);
+       groups.insert(schemas[i1], group);
+    }
+
+    // Tabs are placeholders until shown, so this does not depend on the
+    // size of the tables.
     for(QString table :tables)
     {
-      addTab(table);
+      QString base=CSchema::baseName(table);
+      if( CSearchIndex::isIndexTable(base) || CDbProfile::isSettingsTable(base) )
+      {
+         continue;
+      }
+      addTab( groups.value(CSchema::schemaOf(table), ui.tabWidget), table );
     }
 
+    m_prefetchTimer.setSingleShot(true);
+    connect(&m_prefetchTimer, &QTimer::timeout, this, &CWarehouse::prefetch);
+    auto prefetchLater=[this](){
+       if(m_prefetch)
+       {
+          m_prefetchTimer.start(PrefetchQuiet);
+       }
+    };
+    connect(ui.tabWidget, &QTabWidget::currentChanged, this, prefetchLater);
+    for(QTabWidget *group: groups)
+    {
+       connect(group, &QTabWidget::currentChanged, this, prefetchLater);
+    }
+
+    qCDebug(lcTiming, "Created %d tabs in %d files after %lld ms", m_tabs.size()
+            , schemas.size(), startupTimer().elapsed());
 }
 
 
-QSqlError CWarehouse::initDb(const QString &databaseFile) const
+QElapsedTimer &CWarehouse::startupTimer()
 {
-   QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-   db.setDatabaseName(databaseFile);
-   
-   if (!db.open())
-      return db.lastError();
+   static QElapsedTimer timer;
 
-   QStringList tables = db.tables();
-   
-   return QSqlError();
+   return(timer);
+}
+
+
+void CWarehouse::setPrefetch(bool prefetch)
+{
+   m_prefetch=prefetch;
+}
+
+
+void CWarehouse::showEvent(QShowEvent *event)
+{
+   QMainWindow::showEvent(event);
+
+   if(!m_painted)
+   {
+      m_painted=true;
+      // Runs after the pending paint events of the first show
+      QTimer::singleShot(0, this, [this](){
+         qCDebug(lcTiming, "First paint after %lld ms", startupTimer().elapsed());
+         if(m_prefetch)
+         {
+            qApp->installEventFilter(this);
+            m_prefetchTimer.start(PrefetchQuiet);
+         }
+      });
+   }
+}
+
+
+bool CWarehouse::eventFilter(QObject *watched, QEvent *event)
+{
+   bool input=false;
+
+   switch( event->type() )
+   {
+      case QEvent::KeyPress:
+      case QEvent::MouseButtonPress:
+      case QEvent::Wheel:
+         input=true;
+         break;
+      case QEvent::MouseMove:
+         // E.g. dragging the scroll bar of the list
+         input=( static_cast<QMouseEvent *>(event)->buttons() != Qt::NoButton );
+         break;
+      default:
+         break;
+   }
+
+   // Scrolling reads pages on the pool; prefetching would compete with it
+   if( input && m_prefetchTimer.isActive() )
+   {
+      m_prefetchTimer.start(PrefetchQuiet);
+   }
+
+   return( QMainWindow::eventFilter(watched, event) );
+}
+
+
+void CWarehouse::prefetch()
+{
+   // Pages, counts and searches of the shown tabs first
+   if( !CWorkerPool::isIdle() )
+   {
+      m_prefetchTimer.start(PrefetchQuiet);
+      return;
+   }
+
+   // Building a tab sets up its widgets; the queries run on the worker pool.
+   // So one tab per worker is built ahead, each when the application is idle
+   // again.
+   QTabWidget *group=currentGroup();
+   int current=group->currentIndex();
+   int last=qMin( current + CWorkerPool::threads(), group->count() - 1 );
+
+   for(int i1=current + 1; i1<=last; i1++)
+   {
+      CWarehouseTab *tab=dynamic_cast<CWarehouseTab *>( group->widget(i1) );
+      if( tab && !tab->isBuilt() )
+      {
+         tab->build();
+         m_prefetchTimer.start(0);
+         return;
+      }
+   }
 }
 
 
-void CWarehouse::addTab(const QString &table)
+QTabWidget *CWarehouse::currentGroup() const
+{
+   QTabWidget *group=qobject_cast<QTabWidget *>( ui.tabWidget->currentWidget() );
+
+   return( group ? group : ui.tabWidget );
+}
+
+
+QSqlError CWarehouse::initDb(const QStringList &databaseFiles) const
+{
+   QSqlError err=CConnection::openDefault(databaseFiles.value(0));
+
+   // One connection and page cache for all files
+   for(int i1=1; ( err.type() == QSqlError::NoError ) && ( i1<databaseFiles.size() ); i1++)
+   {
+      err=CConnection::attach(databaseFiles[i1]);
+   }
+
+   return(err);
+}
+
+
+void CWarehouse::addTab(QTabWidget *group, const QString &table)
 {
    CWarehouseTab *tab=new CWarehouseTab(table);
-   ui.tabWidget->addTab(tab, QString());
+   group->addTab(tab, QString());
    tab->setObjectName(QString::fromUtf8("tab"));
-   ui.tabWidget->setTabText(ui.tabWidget->indexOf(tab), table);
+   group->setTabText(group->indexOf(tab), CSchema::baseName(table));
+   m_tabs.append(tab);
+   m_groups.insert(tab, group);
    
    return;
 }
 
 
+void CWarehouse::totalCounted(const QString &table, qint64 count)
+{
+   // Tables are counted when their tab is built; the others have no number
+   for(CWarehouseTab *tab: m_tabs)
+   {
+      if( tab->table() == table )
+      {
+         QTabWidget *group=m_groups.value(tab);
+         group->setTabText( group->indexOf(tab), QString("%1 (%2)")
+                            .arg(CSchema::baseName(table), QLocale().toString(count)) );
+      }
+   }
+}
+
+
+void CWarehouse::searchWorkspace(const QString &text)
+{
+   CWarehouseTab *current=dynamic_cast<CWarehouseTab *>( currentGroup()->currentWidget() );
+   if(!current)
+   {
+      return;
+   }
+
+   // The tables of the same name in every file, listed in one dock; the
+   // tabs are not built for it
+   QString base=CSchema::baseName(current->table());
+   QStringList tables;
+   for(CWarehouseTab *tab: m_tabs)
+   {
+      if( CSchema::baseName(tab->table()) == base )
+      {
+         tables << tab->table();
+      }
+   }
+   m_workspaceSearch->search(tables, text);
+   if(!text.isEmpty())
+   {
+      m_workspaceSearch->show();
+   }
+}
+
+
+void CWarehouse::showFound(const QString &table, qint64 id)
+{
+   for(CWarehouseTab *tab: m_tabs)
+   {
+      if( tab->table() != table )
+      {
+         continue;
+      }
+      QTabWidget *group=m_groups.value(tab, ui.tabWidget);
+      if( group != ui.tabWidget )
+      {
+         ui.tabWidget->setCurrentWidget(group);
+      }
+      group->setCurrentWidget(tab);
+      // The list shows the matches of the file, the form the chosen one
+      tab->setSearchText( m_workspaceSearch->text() );
+      tab->build();
+      tab->showRecord(id);
+      return;
+   }
+}
+
+
 void CWarehouse::showError(const QSqlError &err)
 {
     QMessageBox::critical(this, "Unable to initialize Database",
@@ -90,50 +315,154 @@ void CWarehouse::showError(const QSqlError &err)
 
 void CWarehouse::createMenuBar()
 {
+    CDiagnosticsDock *diagnostics = new CDiagnosticsDock(this);
+    addDockWidget(Qt::BottomDockWidgetArea, diagnostics);
+    diagnostics->hide();
+
+    QAction *importAction = new QAction(tr("&Import..."), this);
+    importAction->setEnabled( !CConnection::isReadOnly() );
     QAction *quitAction = new QAction(tr("&Quit"), this);
     QAction *aboutAction = new QAction(tr("&About"), this);
     QAction *aboutQtAction = new QAction(tr("&About Qt"), this);
 
     QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
+    fileMenu->addAction(importAction);
+    fileMenu->addSeparator();
     fileMenu->addAction(quitAction);
 
+    QMenu *viewMenu = menuBar()->addMenu(tr("&View"));
+    viewMenu->addAction(diagnostics->toggleViewAction());
+
     QMenu *helpMenu = menuBar()->addMenu(tr("&Help"));
     helpMenu->addAction(aboutAction);
     helpMenu->addAction(aboutQtAction);
 
+    // Searching all files only makes sense with several
+    if( CSchema::schemas().size() > 1 )
+    {
+       QLineEdit *search = new QLineEdit(this);
+       search->setObjectName("lineWorkspaceSearch");
+       search->setPlaceholderText(tr("Search all files"));
+       search->setClearButtonEnabled(true);
+       menuBar()->setCornerWidget(search);
+       connect(search, &QLineEdit::textChanged, this, &CWarehouse::searchWorkspace);
+
+       m_workspaceSearch = new CWorkspaceSearch(this);
+       addDockWidget(Qt::RightDockWidgetArea, m_workspaceSearch);
+       m_workspaceSearch->hide();
+       viewMenu->addAction(m_workspaceSearch->toggleViewAction());
+       connect(m_workspaceSearch, &CWorkspaceSearch::activated, this, &CWarehouse::showFound);
+    }
+
+    connect(importAction, &QAction::triggered, this, &CWarehouse::importFile);
     connect(quitAction, &QAction::triggered, this, &CWarehouse::close);
     connect(aboutAction, &QAction::triggered, this, &CWarehouse::about);
     connect(aboutQtAction, &QAction::triggered, qApp, &QApplication::aboutQt);
 }
 
 
-void CWarehouse::about()
+void CWarehouse::importFile()
 {
-    QMessageBox::about(this, tr("About 'Warehouse'"),
-            tr("<p>Dynamic form creation from SQLdatabases.</p>"));
-}
-
+   QString fileName=QFileDialog::getOpenFileName(this, tr("Import"), QString()
+            , tr("CSV (*.csv);;JSON Lines (*.jsonl *.json);;All files (*)"));
+   if(fileName.isEmpty())
+   {
+      return;
+   }
 
-void CWarehouse::dump(const QString name)
-{
-   qWarning("Dumping %s", qPrintable(name) );
-   for(int i1=0; i1< ui.tabWidget->count(); i1++)
+   // Table named like the file, the current one otherwise
+   QStringList tables;
+   for(CWarehouseTab *tab: m_tabs)
    {
-      if( ui.tabWidget->tabText(i1) == name )
-      {
-         CWarehouseTab *tab=dynamic_cast<CWarehouseTab *>( ui.tabWidget->widget(i1) );
-         if( !tab )
+      tables << tab->table();
+   }
+   int current=tables.indexOf( QFileInfo(fileName).completeBaseName() );
+   if(current < 0)
+   {
+      current=m_tabs.indexOf( dynamic_cast<CWarehouseTab *>( currentGroup()->currentWidget() ) );
+   }
+   bool ok=false;
+   QString table=QInputDialog::getItem(this, tr("Import"), tr("Table:"), tables
+                                       , qMax(current, 0), false, &ok);
+   if( !ok || table.isEmpty() )
+   {
+      return;
+   }
+
+   // The import runs on a worker, so the window stays responsive
+   QProgressDialog *progress=new QProgressDialog(
+            tr("Importing %1...").arg(QFileInfo(fileName).fileName())
+            , tr("Cancel"), 0, 1000, this);
+   progress->setMinimumDuration(500);
+   progress->setAutoReset(false);
+   progress->setAutoClose(false);
+
+   CImporter *importer=new CImporter(table);
+   connect(importer, &CImporter::progress, progress, [progress](qint64
+            , qint64 bytesRead, qint64 bytesTotal){
+      progress->setValue( bytesTotal ? int(bytesRead * 1000 / bytesTotal) : 0 );
+   });
+   connect(progress, &QProgressDialog::canceled, importer, &CImporter::cancel);
+
+   QPointer<CWarehouse> self(this);
+   CWorkerPool::start( [=](const QSqlDatabase &db){
+      CImportReport report=importer->run(fileName, 1000, db);
+      QMetaObject::invokeMethod(qApp, [=](){
+         delete importer;
+         // The worker connection has no hooks and polling may be off
+         if( report.inserted > 0 )
          {
-            qWarning("Could not cast widget to CTab");
+            CChangeFeed::reportTable(table, nullptr);
          }
-         else
+         if(self)
          {
-            tab->dump();
+            delete progress;
+            self->showImportReport(table, report);
          }
-         return;
+      }, Qt::QueuedConnection);
+   } );
+}
+
+
+void CWarehouse::showImportReport(const QString &table, const CImportReport &report)
+{
+   if( !report.error.isEmpty() )
+   {
+      QMessageBox::warning(this, tr("Unable to import")
+                           , tr("%1\n%2 rows were inserted into '%3' before.")
+                           .arg(report.error).arg(report.inserted).arg(table));
+      return;
+   }
+
+   // The change feed updates the tab and the combo boxes
+   QString text=tr("%1 rows inserted into '%2' in %3 ms.")
+         .arg(report.inserted).arg(table).arg(report.msecs);
+   if( !report.ignored.isEmpty() )
+   {
+      text += "\n" + tr("Ignored columns: %1").arg(report.ignored.join(", "));
+   }
+   for(int i1=0; i1<qMin(report.unknown.size(), 20); i1++)
+   {
+      text += "\n" + tr("%1: ignored %2").arg(report.unknown[i1].first)
+                                         .arg(report.unknown[i1].second);
+   }
+   if(report.rejectedCount)
+   {
+      text += "\n" + tr("%1 rows rejected:").arg(report.rejectedCount);
+      for(int i1=0; i1<qMin(report.rejected.size(), 20); i1++)
+      {
+         text += QString("\n%1: %2").arg(report.rejected[i1].first)
+                                     .arg(report.rejected[i1].second);
       }
    }
-   qWarning("Could not find table '%s'.", qPrintable(name));
+   QMessageBox::information(this, tr("Import"), text);
+}
+
+
+void CWarehouse::about()
+{
+    QMessageBox::about(this, tr("About 'Warehouse'"),
+            tr("<p>Dynamic form creation from SQLdatabases.</p>"));
 }
 
 
@@ -0,0 +1,134 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       widgetpool.cpp
+ * @brief      Form widgets kept for reuse by other tabs
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <widgetpool.hpp>
+#include <relationcombo.hpp>
+#include <QApplication>
+#include <QLabel>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QTextEdit>
+#include <QVector>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static const char *s_kindProperty="warehousePoolKind";
+static QVector<QWidget *> s_widgets[CWidgetPool::Kinds];
+static bool s_cleanup=false;
+
+
+static QWidget *create(CWidgetPool::Kind kind, QWidget *parent)
+{
+   switch(kind)
+   {
+      case CWidgetPool::Label:
+         return( new QLabel(parent) );
+      case CWidgetPool::LineEdit:
+         return( new QLineEdit(parent) );
+      case CWidgetPool::SpinBox:
+         return( new QSpinBox(parent) );
+      case CWidgetPool::TextEdit:
+         return( new QTextEdit(parent) );
+      case CWidgetPool::RelationCombo:
+         return( new CRelationCombo(parent) );
+      default:
+         return(nullptr);
+   }
+}
+
+
+QWidget *CWidgetPool::take(Kind kind, QWidget *parent)
+{
+   QWidget *widget;
+
+   if( s_widgets[kind].isEmpty() )
+   {
+      widget=create(kind, parent);
+      widget->setProperty(s_kindProperty, int(kind));
+      return(widget);
+   }
+
+   widget=s_widgets[kind].takeLast();
+   widget->setParent(parent);
+   // Hidden explicitly when given back
+   widget->show();
+
+   return(widget);
+}
+
+
+void CWidgetPool::release(QWidget *widget)
+{
+   bool ok;
+   int kind=widget->property(s_kindProperty).toInt(&ok);
+
+   if( !ok || ( kind < 0 ) || ( kind >= Kinds ) || ( s_widgets[kind].size() >= MaxWidgets ) )
+   {
+      delete widget;
+      return;
+   }
+
+   // Kept widgets have no parent; they are deleted before the application
+   if(!s_cleanup)
+   {
+      s_cleanup=true;
+      QObject::connect(qApp, &QCoreApplication::aboutToQuit, [](){
+         for(QVector<QWidget *> &widgets: s_widgets)
+         {
+            qDeleteAll(widgets);
+            widgets.clear();
+         }
+      });
+   }
+
+   widget->hide();
+   widget->setParent(nullptr);
+
+   switch(kind)
+   {
+      case Label:
+      {
+         QLabel *label=static_cast<QLabel *>(widget);
+         QFont font=label->font();
+         font.setBold(false);
+         label->setFont(font);
+         label->clear();
+         break;
+      }
+      case LineEdit:
+         static_cast<QLineEdit *>(widget)->clear();
+         break;
+      case SpinBox:
+         static_cast<QSpinBox *>(widget)->setValue(0);
+         break;
+      case TextEdit:
+         static_cast<QTextEdit *>(widget)->clear();
+         break;
+      case RelationCombo:
+         static_cast<CRelationCombo *>(widget)->reset();
+         break;
+      default:
+         break;
+   }
+
+   s_widgets[kind].append(widget);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
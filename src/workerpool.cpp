@@ -0,0 +1,123 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       workerpool.cpp
+ * @brief      Threads reading the database, each with its own connection
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <workerpool.hpp>
+#include <connection.hpp>
+#include <QCoreApplication>
+#include <QThreadStorage>
+#include <QAtomicInt>
+#include <QThread>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+static int s_threads=0;
+static QThreadPool *s_pool=nullptr;
+
+
+/** @brief Connection of one worker thread; closed when the thread ends
+ */
+class CThreadConnection
+{
+public:
+   CThreadConnection()
+   {
+      static QAtomicInt counter;
+      m_name=QString("worker-%1").arg(counter.fetchAndAddOrdered(1));
+   }
+
+   ~CThreadConnection()
+   {
+      CConnection::close(m_name);
+   }
+
+   QSqlDatabase database() const
+   {
+      return( CConnection::open(m_name) );
+   }
+
+private:
+   QString m_name;
+};
+
+
+static QThreadStorage<CThreadConnection *> s_connection;
+
+
+void CWorkerPool::setThreads(int threads)
+{
+   s_threads=threads;
+}
+
+
+int CWorkerPool::threads()
+{
+   return( ( s_threads > 0 ) ? s_threads : QThread::idealThreadCount() );
+}
+
+
+QThreadPool *CWorkerPool::pool()
+{
+   if(!s_pool)
+   {
+      s_pool=new QThreadPool();
+      s_pool->setMaxThreadCount( threads() );
+      // Threads are kept, so are their connections
+      s_pool->setExpiryTimeout(-1);
+
+      QObject::connect(qApp, &QCoreApplication::aboutToQuit, &CWorkerPool::shutdown);
+   }
+
+   return(s_pool);
+}
+
+
+void CWorkerPool::start(const std::function<void(const QSqlDatabase &db)> &job)
+{
+   pool()->start( [job](){
+      if( !s_connection.hasLocalData() )
+      {
+         s_connection.setLocalData( new CThreadConnection() );
+      }
+      job( s_connection.localData()->database() );
+   } );
+}
+
+
+void CWorkerPool::shutdown()
+{
+   if(!s_pool)
+   {
+      return;
+   }
+
+   // No job uses a connection anymore when it is closed; ending the threads
+   // closes the connections in their threads
+   s_pool->waitForDone();
+   delete s_pool;
+   s_pool=nullptr;
+}
+
+
+bool CWorkerPool::isIdle()
+{
+   return( !s_pool || ( s_pool->activeThreadCount() == 0 ) );
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
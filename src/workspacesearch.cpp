@@ -0,0 +1,146 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       workspacesearch.cpp
+ * @brief      Dock showing the search results of all files of a workspace
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <workspacesearch.hpp>
+#include <reconcile.hpp>
+#include <searchindex.hpp>
+#include <schema.hpp>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+enum
+{
+   ColumnName,
+   ColumnId,
+};
+
+
+enum
+{
+   RoleTable=Qt::UserRole,
+   RoleId,
+};
+
+
+CWorkspaceSearch::CWorkspaceSearch(QWidget *parent)
+   :QDockWidget(tr("Search results"), parent)
+{
+   setObjectName("workspaceSearch");
+
+   m_results=new QTreeWidget(this);
+   m_results->setHeaderLabels( { tr("Name"), tr("id") } );
+   setWidget(m_results);
+
+   connect(m_results, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item){
+      if( item->data(ColumnName, RoleId).isValid() )
+      {
+         emit activated( item->data(ColumnName, RoleTable).toString()
+                         , item->data(ColumnName, RoleId).toLongLong() );
+      }
+   });
+}
+
+
+void CWorkspaceSearch::search(const QStringList &tables, const QString &text)
+{
+   m_text=text;
+
+   // Tables no longer searched drop their running queries
+   for(auto it=m_schedulers.begin(); it!=m_schedulers.end(); ++it)
+   {
+      if( text.isEmpty() || !tables.contains(it.key()) )
+      {
+         it.value()->cancel();
+      }
+   }
+   if( m_tables != tables )
+   {
+      m_results->clear();
+      m_tables=tables;
+   }
+   if(text.isEmpty())
+   {
+      m_results->clear();
+      return;
+   }
+
+   for(const QString &table: tables)
+   {
+      CSearchScheduler *&scheduler=m_schedulers[table];
+      if(!scheduler)
+      {
+         scheduler=new CSearchScheduler(this);
+         connect(scheduler, &CSearchScheduler::resultReady
+                 , this, &CWorkspaceSearch::resultReady);
+      }
+      scheduler->schedule( CReconciler(table).rowQuery( CSearchIndex(table).clause(text) ) );
+   }
+}
+
+
+QTreeWidgetItem *CWorkspaceSearch::item(const QString &table)
+{
+   for(int i1=0; i1<m_results->topLevelItemCount(); i1++)
+   {
+      if( m_results->topLevelItem(i1)->data(ColumnName, RoleTable).toString() == table )
+      {
+         return( m_results->topLevelItem(i1) );
+      }
+   }
+
+   // Files in the order of the workspace, whichever answers first
+   int position=0;
+   int index=m_tables.indexOf(table);
+   while( ( position < m_results->topLevelItemCount() )
+          && ( m_tables.indexOf( m_results->topLevelItem(position)
+                                 ->data(ColumnName, RoleTable).toString() ) < index ) )
+   {
+      position++;
+   }
+   QTreeWidgetItem *item=new QTreeWidgetItem();
+   item->setData(ColumnName, RoleTable, table);
+   m_results->insertTopLevelItem(position, item);
+   item->setExpanded(true);
+
+   return(item);
+}
+
+
+void CWorkspaceSearch::resultReady(const CRowQuery &query, int count, const CRows &firstPage)
+{
+   if( !m_tables.contains(query.table) )
+   {
+      return;
+   }
+
+   QTreeWidgetItem *file=item(query.table);
+   file->setText( ColumnName, tr("%1 (%2)").arg(CSchema::schemaOf(query.table)).arg(count) );
+   qDeleteAll( file->takeChildren() );
+   for(const CRow &row: firstPage)
+   {
+      QTreeWidgetItem *child=new QTreeWidgetItem(file);
+      child->setText( ColumnName, row.name );
+      child->setText( ColumnId, QString::number(row.id) );
+      child->setData( ColumnName, RoleTable, query.table );
+      child->setData( ColumnName, RoleId, row.id );
+   }
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
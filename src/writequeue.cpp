@@ -0,0 +1,394 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       writequeue.cpp
+ * @brief      Writes of the tabs, committed in groups by a thread of its own
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <writequeue.hpp>
+#include <connection.hpp>
+#include <changefeed.hpp>
+#include <queryprofiler.hpp>
+#include <QCoreApplication>
+#include <QThread>
+#include <QPointer>
+#include <QAtomicPointer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QCache>
+#include <QStringList>
+#include <QVector>
+#include <QDebug>
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+/** @brief One write; SQL is built by the GUI thread
+ */
+struct CWrite
+{
+   CQueryProfiler::Kind kind=CQueryProfiler::Update;
+   QString table;
+   QString statement;
+   QVariantList values;
+   qint64 id=-1;
+   const void *origin=nullptr;
+   QPointer<QObject> receiver;
+   CWriteQueue::Callback done;
+   /** @brief Set instead of a statement for 'run()' */
+   std::function<void(const QSqlDatabase &db)> job;
+   QString error;
+   /** @brief Written before; the stack holds the latest first */
+   CWrite *next=nullptr;
+};
+
+
+static const char *s_connection="writer";
+static bool s_enabled=false;
+static QThread *s_thread=nullptr;
+/** @brief Lives in the writer thread; queued calls to it run there */
+static QObject *s_context=nullptr;
+static QAtomicPointer<CWrite> s_head;
+/** @brief Statements of the writer connection; used by the writer thread only */
+static QCache<QString, QSqlQuery> s_statements(CWriteQueue::MaxStatements);
+
+
+/** @brief Statement 'sql' prepared for the writer connection 'db'
+ */
+static QSqlQuery *statement(const QString &sql, const QSqlDatabase &db)
+{
+   QSqlQuery *query=s_statements.object(sql);
+
+   if(!query)
+   {
+      query=new QSqlQuery(db);
+      query->prepare(sql);
+      s_statements.insert(sql, query);
+   }
+
+   return(query);
+}
+
+
+/** @brief Execute 'write' within a savepoint of the open transaction
+ */
+static void execute(QSqlDatabase db, CWrite *write)
+{
+   QSqlQuery savepoint(db);
+   bool ok=savepoint.exec("SAVEPOINT write");
+
+   if(ok)
+   {
+      QSqlQuery *query=statement(write->statement, db);
+      for(const QVariant &value: write->values)
+      {
+         query->addBindValue(value);
+      }
+
+      // The tab writing shows the row already
+      CChangeOrigin origin(write->origin);
+      CQueryTimer timer(write->table, write->kind, write->statement, write->values, db);
+      ok=query->exec();
+      if(!ok)
+      {
+         write->error=query->lastError().text();
+      }
+      else if( write->kind == CQueryProfiler::Insert )
+      {
+         write->id=query->lastInsertId().toLongLong();
+      }
+      query->finish();
+      timer.finish(ok ? 1 : 0);
+      if(!ok)
+      {
+         // Prepared again next time, e.g. after the schema changed
+         s_statements.remove(write->statement);
+      }
+   }
+   else
+   {
+      write->error=savepoint.lastError().text();
+   }
+
+   if(!ok)
+   {
+      savepoint.exec("ROLLBACK TO write");
+   }
+   savepoint.exec("RELEASE write");
+}
+
+
+/** @brief Write all queued writes in one transaction; runs in the writer
+ */
+static void drain()
+{
+   QSqlDatabase db=QSqlDatabase::database(s_connection);
+   QVector<CWrite *> writes;
+   QVector<CWrite *> jobs;
+   int written=0;
+
+   // Taking the whole stack; it holds the latest write first
+   for(CWrite *write=s_head.fetchAndStoreAcquire(nullptr); write; write=write->next)
+   {
+      if(write->job)
+      {
+         jobs.prepend(write);
+      }
+      else
+      {
+         writes.prepend(write);
+      }
+   }
+
+   if(!writes.isEmpty())
+   {
+      QString error;
+
+      if( !db.transaction() )
+      {
+         error=db.lastError().text();
+      }
+      for(CWrite *write: writes)
+      {
+         if(error.isEmpty())
+         {
+            execute(db, write);
+            written+=write->error.isEmpty() ? 1 : 0;
+         }
+      }
+
+      // Most of the time is spent syncing to disk, once for all
+      if(error.isEmpty())
+      {
+         CQueryTimer commitTimer(writes.first()->table, CQueryProfiler::Update
+                                 , "COMMIT", QVariantList(), db);
+         if(!db.commit())
+         {
+            error=db.lastError().text();
+            db.rollback();
+         }
+         commitTimer.finish(written);
+      }
+      for(CWrite *write: writes)
+      {
+         if( error.isEmpty() && write->error.isEmpty() )
+         {
+            CChangeFeed::written(write->table, write->origin);
+         }
+      }
+      if(!error.isEmpty())
+      {
+         qWarning("Could not write %d row(s): %s", writes.size(), qPrintable(error));
+      }
+
+      for(CWrite *write: writes)
+      {
+         if( !error.isEmpty() && write->error.isEmpty() )
+         {
+            write->error=error;
+         }
+         if(write->done)
+         {
+            QPointer<QObject> receiver=write->receiver;
+            CWriteQueue::Callback done=write->done;
+            qint64 id=write->id;
+            QString failed=write->error;
+            QMetaObject::invokeMethod(qApp, [=](){
+               if(receiver)
+               {
+                  done(id, failed);
+               }
+            }, Qt::QueuedConnection);
+         }
+      }
+   }
+
+   for(CWrite *write: jobs)
+   {
+      write->job(db);
+   }
+
+   qDeleteAll(writes);
+   qDeleteAll(jobs);
+}
+
+
+/** @brief Push 'write' and wake the writer if the stack was empty
+ */
+static void push(CWrite *write)
+{
+   CWrite *head;
+
+   do
+   {
+      head=s_head.loadAcquire();
+      write->next=head;
+   }
+   while( !s_head.testAndSetRelease(head, write) );
+
+   // Otherwise the writer was woken already and has not taken the stack yet
+   if(!head)
+   {
+      QMetaObject::invokeMethod(s_context, &drain, Qt::QueuedConnection);
+   }
+}
+
+
+void CWriteQueue::setEnabled(bool enabled)
+{
+   s_enabled=enabled;
+}
+
+
+bool CWriteQueue::isEnabled()
+{
+   return(s_enabled);
+}
+
+
+bool CWriteQueue::isRunning()
+{
+   return( s_thread != nullptr );
+}
+
+
+void CWriteQueue::start()
+{
+   if(s_thread)
+   {
+      return;
+   }
+
+   s_thread=new QThread();
+   s_thread->setObjectName(s_connection);
+   s_context=new QObject();
+   s_context->moveToThread(s_thread);
+   s_thread->start();
+
+   QMetaObject::invokeMethod(s_context, [](){
+      QSqlDatabase db=CConnection::open(s_connection);
+      // Writes of this process are committed by this connection only
+      CChangeFeed::install(db);
+   }, Qt::QueuedConnection);
+
+   QObject::connect(qApp, &QCoreApplication::aboutToQuit, &CWriteQueue::stop);
+}
+
+
+void CWriteQueue::stop()
+{
+   if(!s_thread)
+   {
+      return;
+   }
+
+   // Nothing queued is lost
+   QMetaObject::invokeMethod(s_context, [](){
+      drain();
+      s_statements.clear();
+      CConnection::close(s_connection);
+   }, Qt::BlockingQueuedConnection);
+
+   s_thread->quit();
+   s_thread->wait();
+   delete s_context;
+   delete s_thread;
+   s_context=nullptr;
+   s_thread=nullptr;
+}
+
+
+void CWriteQueue::insert(const QString &table, const QHash<QString, QVariant> &values
+                         , const void *origin, QObject *receiver, const Callback &done)
+{
+   CWrite *write=new CWrite;
+   QStringList columns;
+   QStringList placeholders;
+
+   for(auto it=values.constBegin(); it!=values.constEnd(); ++it)
+   {
+      columns << CConnection::escapeField(it.key());
+      placeholders << "?";
+      write->values << it.value();
+   }
+
+   write->kind=CQueryProfiler::Insert;
+   write->table=table;
+   write->statement=columns.isEmpty()
+         ? QString("INSERT INTO %1 DEFAULT VALUES").arg(CConnection::escapeTable(table))
+         : QString("INSERT INTO %1 (%2) VALUES (%3)")
+           .arg(CConnection::escapeTable(table), columns.join(", "), placeholders.join(", "));
+   write->origin=origin;
+   write->receiver=receiver;
+   write->done=done;
+
+   push(write);
+}
+
+
+void CWriteQueue::update(const QString &table, qint64 id, const QHash<QString, QVariant> &values
+                         , const void *origin, QObject *receiver, const Callback &done)
+{
+   CWrite *write=new CWrite;
+   QStringList assignments;
+
+   for(auto it=values.constBegin(); it!=values.constEnd(); ++it)
+   {
+      assignments << CConnection::escapeField(it.key()) + "=?";
+      write->values << it.value();
+   }
+   write->values << id;
+
+   write->kind=CQueryProfiler::Update;
+   write->table=table;
+   write->statement=QString("UPDATE %1 SET %2 WHERE id=?")
+         .arg(CConnection::escapeTable(table), assignments.join(", "));
+   write->id=id;
+   write->origin=origin;
+   write->receiver=receiver;
+   write->done=done;
+
+   push(write);
+}
+
+
+void CWriteQueue::remove(const QString &table, qint64 id
+                         , const void *origin, QObject *receiver, const Callback &done)
+{
+   CWrite *write=new CWrite;
+
+   write->kind=CQueryProfiler::Delete;
+   write->table=table;
+   write->statement=QString("DELETE FROM %1 WHERE id=?").arg(CConnection::escapeTable(table));
+   write->values << id;
+   write->id=id;
+   write->origin=origin;
+   write->receiver=receiver;
+   write->done=done;
+
+   push(write);
+}
+
+
+void CWriteQueue::run(const std::function<void(const QSqlDatabase &db)> &job)
+{
+   CWrite *write=new CWrite;
+
+   write->job=job;
+
+   push(write);
+}
+
+
+/*--- Fin ------------------------------------------------------------------*/
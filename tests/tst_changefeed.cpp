@@ -0,0 +1,217 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_changefeed.cpp
+ * @brief      Rows reported by the hooks of the change feed
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <changefeed.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief A second connection holds a read lock to make a COMMIT fail
+ */
+class CChangeFeedTest : public QObject
+{
+   Q_OBJECT
+
+   QTemporaryDir m_dir;
+   CChanges m_changes;
+
+   /** @brief Changes reported once the queued dispatch ran */
+   CChanges changes();
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void init();
+   void reportsRows();
+   void dropsRolledBack();
+   void dropsFailedCommit();
+   void tagsOrigin();
+   void mergesManyRows();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CChangeFeedTest::initTestCase()
+{
+   QVERIFY( m_dir.isValid() );
+
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+   db.setDatabaseName( m_dir.filePath("changefeed.sqlite") );
+   // A locked file fails at once instead of after the default timeout
+   db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=0");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT)") );
+
+   connect(CChangeFeed::instance(), &CChangeFeed::changed, this, [this](const CChanges &changes){
+      m_changes += changes;
+   });
+   if( !CChangeFeed::install(db) )
+   {
+      QSKIP("Qt uses another SQLite library; the hooks can not be installed");
+   }
+}
+
+
+void CChangeFeedTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+void CChangeFeedTest::init()
+{
+   m_changes.clear();
+}
+
+
+CChanges CChangeFeedTest::changes()
+{
+   QTest::qWait(50);
+
+   return(m_changes);
+}
+
+
+void CChangeFeedTest::reportsRows()
+{
+   QSqlQuery query;
+
+   QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Bolt')") );
+   qint64 id=query.lastInsertId().toLongLong();
+   QVERIFY( query.exec( QString("UPDATE Parts SET Name='Nut' WHERE id=%1").arg(id) ) );
+   QVERIFY( query.exec( QString("DELETE FROM Parts WHERE id=%1").arg(id) ) );
+
+   CChanges reported=changes();
+   QCOMPARE( reported.size(), 3 );
+   QCOMPARE( reported[0].op, CChange::Insert );
+   QCOMPARE( reported[1].op, CChange::Update );
+   QCOMPARE( reported[2].op, CChange::Delete );
+   for(const CChange &change: reported)
+   {
+      QCOMPARE( change.table, QString("Parts") );
+      QCOMPARE( change.rowid, id );
+      QVERIFY( change.origin == nullptr );
+   }
+}
+
+
+void CChangeFeedTest::dropsRolledBack()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QSqlQuery query;
+
+   QVERIFY( db.transaction() );
+   QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Bolt')") );
+   QVERIFY( db.rollback() );
+
+   QVERIFY( changes().isEmpty() );
+}
+
+
+void CChangeFeedTest::dropsFailedCommit()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QSqlQuery query;
+
+   QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Bolt'), ('Nut')") );
+   changes();
+   m_changes.clear();
+
+   {
+      // A statement not finished keeps the file locked for reading
+      QSqlDatabase other=QSqlDatabase::addDatabase("QSQLITE", "reader");
+      other.setDatabaseName( db.databaseName() );
+      QVERIFY( other.open() );
+      QSqlQuery reading(other);
+      QVERIFY( reading.exec("SELECT id FROM Parts") );
+      QVERIFY( reading.next() );
+
+      QVERIFY( db.transaction() );
+      QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Washer')") );
+      QVERIFY( !db.commit() );
+      QVERIFY( changes().isEmpty() );
+
+      QVERIFY( db.rollback() );
+      reading.finish();
+   }
+   QSqlDatabase::removeDatabase("reader");
+   QVERIFY( changes().isEmpty() );
+
+   // Once the COMMIT succeeds the rows are reported again
+   QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Screw')") );
+   QCOMPARE( changes().size(), 1 );
+   QCOMPARE( m_changes.first().op, CChange::Insert );
+}
+
+
+void CChangeFeedTest::tagsOrigin()
+{
+   QSqlQuery query;
+   int origin=0;
+
+   {
+      CChangeOrigin tag(&origin);
+      QVERIFY( CChangeOrigin::current() == &origin );
+      QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Bolt')") );
+   }
+   QVERIFY( CChangeOrigin::current() == nullptr );
+   QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES ('Nut')") );
+
+   CChanges reported=changes();
+   QCOMPARE( reported.size(), 2 );
+   QVERIFY( reported[0].origin == &origin );
+   QVERIFY( reported[1].origin == nullptr );
+}
+
+
+void CChangeFeedTest::mergesManyRows()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   QSqlQuery query;
+
+   QVERIFY( db.transaction() );
+   QVERIFY( query.prepare("INSERT INTO Parts (Name) VALUES (?)") );
+   for(int i1=0; i1<=CChangeFeed::MaxRows; i1++)
+   {
+      query.addBindValue( QString("Part %1").arg(i1) );
+      QVERIFY( query.exec() );
+   }
+   QVERIFY( db.commit() );
+
+   // The first ones one by one, then the table once
+   CChanges reported=changes();
+   QCOMPARE( reported.size(), int(CChangeFeed::MaxRows) + 1 );
+   QCOMPARE( reported.last().op, CChange::Unknown );
+   QCOMPARE( reported.last().rowid, qint64(-1) );
+   QCOMPARE( reported.first().op, CChange::Insert );
+}
+
+
+QTEST_GUILESS_MAIN(CChangeFeedTest)
+#include "tst_changefeed.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,219 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_editbuffer.cpp
+ * @brief      Writing the batched edits in one transaction
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <editbuffer.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief A second connection holds a read lock to make the COMMIT fail
+ */
+class CEditBufferTest : public QObject
+{
+   Q_OBJECT
+
+   QTemporaryDir m_dir;
+
+   QString nameOf(qint64 id) const;
+   /** @brief No transaction is left open on the default connection */
+   bool isIdle() const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void init();
+   void keepsLatestValue();
+   void writesAllRows();
+   void rollsBackFailedRow();
+   void rollsBackFailedCommit();
+   void revertDrops();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CEditBufferTest::initTestCase()
+{
+   QVERIFY( m_dir.isValid() );
+   qRegisterMetaType< QList<qint64> >();
+
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+   db.setDatabaseName( m_dir.filePath("editbuffer.sqlite") );
+   // A locked file fails at once instead of after the default timeout
+   db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=0");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY"
+                       ", Name TEXT NOT NULL UNIQUE, Count INTEGER)") );
+}
+
+
+void CEditBufferTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+void CEditBufferTest::init()
+{
+   QSqlQuery query;
+
+   QVERIFY( query.exec("DELETE FROM Parts") );
+   QVERIFY( query.exec("INSERT INTO Parts (id, Name) VALUES (1, 'Bolt'), (2, 'Nut')") );
+}
+
+
+QString CEditBufferTest::nameOf(qint64 id) const
+{
+   QSqlQuery query;
+
+   query.exec( QString("SELECT Name FROM Parts WHERE id=%1").arg(id) );
+
+   return( query.next() ? query.value(0).toString() : QString() );
+}
+
+
+bool CEditBufferTest::isIdle() const
+{
+   QSqlDatabase db=QSqlDatabase::database();
+
+   // BEGIN fails within a transaction
+   if(!db.transaction())
+   {
+      return(false);
+   }
+   db.rollback();
+
+   return(true);
+}
+
+
+void CEditBufferTest::keepsLatestValue()
+{
+   CEditBuffer buffer("Parts");
+
+   buffer.set(1, "Name", "Screw");
+   buffer.set(1, "Name", "Washer");
+   buffer.set(1, "Count", 3);
+   QVERIFY( buffer.isDirty() );
+   QVERIFY( buffer.isDirty(1) );
+   QVERIFY( !buffer.isDirty(2) );
+   QCOMPARE( buffer.values(1).value("Name").toString(), QString("Washer") );
+   QCOMPARE( buffer.values(1).size(), 2 );
+
+   // Nothing is written before flushing
+   QCOMPARE( nameOf(1), QString("Bolt") );
+}
+
+
+void CEditBufferTest::writesAllRows()
+{
+   CEditBuffer buffer("Parts");
+   QSignalSpy flushed(&buffer, &CEditBuffer::flushed);
+   QSignalSpy dirty(&buffer, &CEditBuffer::dirtyChanged);
+
+   buffer.set(1, "Name", "Screw");
+   buffer.set(2, "Name", "Washer");
+   QVERIFY( buffer.flush() );
+
+   QCOMPARE( nameOf(1), QString("Screw") );
+   QCOMPARE( nameOf(2), QString("Washer") );
+   QVERIFY( !buffer.isDirty() );
+   QCOMPARE( flushed.size(), 1 );
+   QCOMPARE( flushed.first().at(0).value< QList<qint64> >().size(), 2 );
+   QCOMPARE( dirty.last().at(0).toBool(), false );
+   QVERIFY( isIdle() );
+}
+
+
+void CEditBufferTest::rollsBackFailedRow()
+{
+   CEditBuffer buffer("Parts");
+   QSignalSpy failed(&buffer, &CEditBuffer::flushFailed);
+
+   // The second Name is taken by the first row, so neither is written
+   buffer.set(1, "Name", "Screw");
+   buffer.set(2, "Name", "Screw");
+   QVERIFY( !buffer.flush() );
+
+   QCOMPARE( failed.size(), 1 );
+   QCOMPARE( nameOf(1), QString("Bolt") );
+   QCOMPARE( nameOf(2), QString("Nut") );
+   QVERIFY( buffer.isDirty(1) );
+   QVERIFY( buffer.isDirty(2) );
+   QVERIFY( isIdle() );
+}
+
+
+void CEditBufferTest::rollsBackFailedCommit()
+{
+   QSqlDatabase db=QSqlDatabase::database();
+   CEditBuffer buffer("Parts");
+   QSignalSpy failed(&buffer, &CEditBuffer::flushFailed);
+
+   {
+      // A statement not finished keeps the file locked for reading
+      QSqlDatabase other=QSqlDatabase::addDatabase("QSQLITE", "reader");
+      other.setDatabaseName( db.databaseName() );
+      QVERIFY( other.open() );
+      QSqlQuery reading(other);
+      QVERIFY( reading.exec("SELECT id FROM Parts") );
+      QVERIFY( reading.next() );
+
+      buffer.set(1, "Name", "Screw");
+      QVERIFY( !buffer.flush() );
+      reading.finish();
+   }
+   QSqlDatabase::removeDatabase("reader");
+
+   QCOMPARE( failed.size(), 1 );
+   QVERIFY( isIdle() );
+   QCOMPARE( nameOf(1), QString("Bolt") );
+
+   // Kept, so the next flush writes them
+   QVERIFY( buffer.isDirty(1) );
+   QVERIFY( buffer.flush() );
+   QCOMPARE( nameOf(1), QString("Screw") );
+}
+
+
+void CEditBufferTest::revertDrops()
+{
+   CEditBuffer buffer("Parts");
+   QSignalSpy dirty(&buffer, &CEditBuffer::dirtyChanged);
+
+   buffer.set(1, "Name", "Screw");
+   buffer.revert();
+   QVERIFY( !buffer.isDirty() );
+   QCOMPARE( dirty.last().at(0).toBool(), false );
+   QVERIFY( buffer.flush() );
+   QCOMPARE( nameOf(1), QString("Bolt") );
+}
+
+
+QTEST_GUILESS_MAIN(CEditBufferTest)
+#include "tst_editbuffer.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
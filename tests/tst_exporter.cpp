@@ -0,0 +1,185 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_exporter.cpp
+ * @brief      Exporting tables as Textile, CSV and JSON Lines
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <exporter.hpp>
+#include <schema.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+class CExporterTest : public QObject
+{
+   Q_OBJECT
+
+   /** @brief Text written for 'table' in 'format' */
+   QByteArray exported(const QString &table, CExporter::Format format) const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void writesCsv();
+   void writesTextile();
+   void writesJsonLines();
+   void escapesJsonControls();
+   void parsesFormats();
+   void reportsMissingTable();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CExporterTest::initTestCase()
+{
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+
+   db.setDatabaseName(":memory:");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Location (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT, Count INTEGER"
+                       ", Weight REAL, Location_id_Name INTEGER, Data BLOB)") );
+   QVERIFY( query.exec("CREATE TABLE Notes (id INTEGER PRIMARY KEY, Text TEXT)") );
+   QVERIFY( query.exec("INSERT INTO Location (id, Name) VALUES (1, 'Shelf')") );
+   // A dangling and a NULL key are exported as NULL
+   QVERIFY( query.exec("INSERT INTO Parts VALUES (1, 'Bolt', 3, 1.5, 1, NULL)"
+                       ", (2, 'Nut, \"M4\"', NULL, NULL, 9, X'0102')"
+                       ", (3, 'Line' || char(10) || 'break|pipe', 0, NULL, NULL, NULL)") );
+   QVERIFY( query.exec("INSERT INTO Notes VALUES (1, 'tab' || char(9) || 'bell' || char(7)"
+                       " || 'back\\slash' || char(13) || char(10))") );
+   QVERIFY( CSchema::load(db) );
+}
+
+
+void CExporterTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+QByteArray CExporterTest::exported(const QString &table, CExporter::Format format) const
+{
+   QByteArray data;
+   QBuffer buffer(&data);
+   CExporter exporter(format);
+
+   buffer.open(QIODevice::WriteOnly);
+   if( exporter.write(table, &buffer) < 0 )
+   {
+      return("<error>");
+   }
+
+   return(data);
+}
+
+
+void CExporterTest::writesCsv()
+{
+   // Only cells with separators, quotes or line breaks are quoted
+   QCOMPARE( exported("Parts", CExporter::FormatCsv), QByteArray(
+         "id,Name,Count,Weight,Location_id_Name,Data\n"
+         "1,Bolt,3,1.5,Shelf,\n"
+         "2,\"Nut, \"\"M4\"\"\",,,,AQI=\n"
+         "3,\"Line\nbreak|pipe\",0,,,\n") );
+}
+
+
+void CExporterTest::writesTextile()
+{
+   QCOMPARE( exported("Parts", CExporter::FormatTextile), QByteArray(
+         "|_. id |_. Name |_. Count |_. Weight |_. Location_id_Name |_. Data |\n"
+         "| 1 | Bolt | 3 | 1.5 | Shelf |  |\n"
+         "| 2 | Nut, \"M4\" |  |  |  | AQI= |\n"
+         "| 3 | Line<br>break&#124;pipe | 0 |  |  |  |\n") );
+}
+
+
+void CExporterTest::writesJsonLines()
+{
+   QByteArray data=exported("Parts", CExporter::FormatJsonLines);
+
+   QCOMPARE( data, QByteArray(
+         "{\"id\":1,\"Name\":\"Bolt\",\"Count\":3,\"Weight\":1.5"
+         ",\"Location_id_Name\":\"Shelf\",\"Data\":null}\n"
+         "{\"id\":2,\"Name\":\"Nut, \\\"M4\\\"\",\"Count\":null,\"Weight\":null"
+         ",\"Location_id_Name\":null,\"Data\":\"AQI=\"}\n"
+         "{\"id\":3,\"Name\":\"Line\\nbreak|pipe\",\"Count\":0,\"Weight\":null"
+         ",\"Location_id_Name\":null,\"Data\":null}\n") );
+
+   // Every line is an object of its own
+   QList<QByteArray> lines=data.split('\n');
+   QCOMPARE( lines.size(), 4 );
+   QVERIFY( lines.last().isEmpty() );
+   for(int i1=0; i1<3; i1++)
+   {
+      QJsonParseError error;
+      QJsonDocument document=QJsonDocument::fromJson(lines[i1], &error);
+      QCOMPARE( error.error, QJsonParseError::NoError );
+      QCOMPARE( document.object().value("id").toInt(), i1 + 1 );
+   }
+}
+
+
+void CExporterTest::escapesJsonControls()
+{
+   QByteArray data=exported("Notes", CExporter::FormatJsonLines);
+
+   QCOMPARE( data, QByteArray(
+         "{\"id\":1,\"Text\":\"tab\\tbell\\u0007back\\\\slash\\r\\n\"}\n") );
+
+   QJsonParseError error;
+   QJsonDocument document=QJsonDocument::fromJson(data.trimmed(), &error);
+   QCOMPARE( error.error, QJsonParseError::NoError );
+   QCOMPARE( document.object().value("Text").toString()
+             , QString("tab\tbell\aback\\slash\r\n") );
+}
+
+
+void CExporterTest::parsesFormats()
+{
+   CExporter::Format format=CExporter::FormatTextile;
+
+   QVERIFY( CExporter::parseFormat("CSV", format) );
+   QCOMPARE( format, CExporter::FormatCsv );
+   QVERIFY( CExporter::parseFormat("json", format) );
+   QCOMPARE( format, CExporter::FormatJsonLines );
+   QVERIFY( CExporter::parseFormat("textile", format) );
+   QCOMPARE( format, CExporter::FormatTextile );
+   QVERIFY( !CExporter::parseFormat("xml", format) );
+   QCOMPARE( CExporter::suffix(CExporter::FormatJsonLines), QString("jsonl") );
+}
+
+
+void CExporterTest::reportsMissingTable()
+{
+   QCOMPARE( exported("Screws", CExporter::FormatCsv), QByteArray("<error>") );
+}
+
+
+QTEST_GUILESS_MAIN(CExporterTest)
+#include "tst_exporter.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
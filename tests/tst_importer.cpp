@@ -0,0 +1,217 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_importer.cpp
+ * @brief      Importing JSON Lines records into a table
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QBuffer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <importer.hpp>
+#include <schema.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+class CImporterTest : public QObject
+{
+   Q_OBJECT
+
+   /** @brief Import 'lines' into 'Parts' */
+   CImportReport import(const QByteArray &lines) const;
+   /** @brief Values of 'column' of all parts, in the order inserted */
+   QVariantList column(const QString &column) const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void init();
+   void mapsKeysByName();
+   void reportsUnknownKeys();
+   void resolvesForeignKeys();
+   void keepsNestedValuesAsText();
+   void rejectsRecords();
+   void reportsMissingTable();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CImporterTest::initTestCase()
+{
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+
+   db.setDatabaseName(":memory:");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Location (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT NOT NULL"
+                       ", Count INTEGER DEFAULT 7, Location_id_Name INTEGER, Notes TEXT)") );
+   QVERIFY( query.exec("INSERT INTO Location (Name) VALUES ('Shelf'), ('Drawer')") );
+   QVERIFY( CSchema::load(db) );
+}
+
+
+void CImporterTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+void CImporterTest::init()
+{
+   QSqlQuery query;
+
+   QVERIFY( query.exec("DELETE FROM Parts") );
+}
+
+
+CImportReport CImporterTest::import(const QByteArray &lines) const
+{
+   QByteArray data=lines;
+   QBuffer buffer(&data);
+   CImporter importer("Parts");
+
+   buffer.open(QIODevice::ReadOnly);
+
+   return( importer.run(&buffer, CImporter::FormatJsonLines) );
+}
+
+
+QVariantList CImporterTest::column(const QString &column) const
+{
+   QSqlQuery query;
+   QVariantList values;
+
+   query.exec( QString("SELECT %1 FROM Parts ORDER BY id").arg(column) );
+   while(query.next())
+   {
+      values << query.value(0);
+   }
+
+   return(values);
+}
+
+
+void CImporterTest::mapsKeysByName()
+{
+   CImportReport report=import(
+         "{\"Name\": \"Bolt\", \"Count\": 3}\n"
+         "{\"Count\": 4, \"Name\": \"Nut\"}\n"
+         "\n"
+         "{\"Name\": \"Washer\"}\n" );
+
+   QVERIFY( report.error.isEmpty() );
+   QCOMPARE( report.inserted, qint64(3) );
+   QCOMPARE( report.rejectedCount, qint64(0) );
+   QVERIFY( report.ignored.isEmpty() );
+   QCOMPARE( column("Name"), QVariantList({ "Bolt", "Nut", "Washer" }) );
+   // A key missing in the record keeps the default of the column
+   QCOMPARE( column("Count"), QVariantList({ 3, 4, 7 }) );
+}
+
+
+void CImporterTest::reportsUnknownKeys()
+{
+   CImportReport report=import(
+         "{\"Name\": \"Bolt\", \"Color\": \"red\"}\n"
+         "{\"Name\": \"Nut\"}\n"
+         "{\"Weight\": 2, \"Name\": \"Washer\", \"Color\": \"blue\"}\n" );
+
+   // Inserted without the unknown keys
+   QCOMPARE( report.inserted, qint64(3) );
+   QCOMPARE( report.rejectedCount, qint64(0) );
+   QCOMPARE( report.ignored.size(), 2 );
+   QVERIFY( report.ignored.contains("Color") );
+   QVERIFY( report.ignored.contains("Weight") );
+   QCOMPARE( report.unknown.size(), 2 );
+   QCOMPARE( report.unknown[0].first, qint64(1) );
+   QCOMPARE( report.unknown[0].second, QString("Color") );
+   QCOMPARE( report.unknown[1].first, qint64(3) );
+   QVERIFY( report.unknown[1].second.contains("Color") );
+   QVERIFY( report.unknown[1].second.contains("Weight") );
+}
+
+
+void CImporterTest::resolvesForeignKeys()
+{
+   CImportReport report=import(
+         "{\"Name\": \"Bolt\", \"Location_id_Name\": \"Drawer\"}\n"
+         "{\"Name\": \"Nut\", \"Location_id_Name\": \"Attic\"}\n"
+         "{\"Name\": \"Washer\", \"Location_id_Name\": \"\"}\n" );
+
+   QCOMPARE( report.inserted, qint64(2) );
+   QCOMPARE( report.rejectedCount, qint64(1) );
+   QCOMPARE( report.rejected.first().first, qint64(2) );
+   QVERIFY( report.rejected.first().second.contains("Attic") );
+   QCOMPARE( column("Name"), QVariantList({ "Bolt", "Washer" }) );
+   QCOMPARE( column("Location_id_Name").first().toLongLong(), qint64(2) );
+   QVERIFY( column("Location_id_Name").last().isNull() );
+}
+
+
+void CImporterTest::keepsNestedValuesAsText()
+{
+   CImportReport report=import(
+         "{\"Name\": \"Bolt\", \"Notes\": {\"thread\": \"M4\"}}\n"
+         "{\"Name\": \"Nut\", \"Notes\": [1, 2]}\n" );
+
+   QCOMPARE( report.inserted, qint64(2) );
+   QCOMPARE( column("Notes"), QVariantList({ "{\"thread\":\"M4\"}", "[1,2]" }) );
+}
+
+
+void CImporterTest::rejectsRecords()
+{
+   CImportReport report=import(
+         "{\"Name\": \"Bolt\"}\n"
+         "{\"Name\": \n"
+         "{\"Color\": \"red\"}\n"
+         "{\"Count\": 5}\n"
+         "{\"Name\": \"Nut\"}\n" );
+
+   // Not JSON, no known key, NOT NULL violated; the others are inserted
+   QCOMPARE( report.inserted, qint64(2) );
+   QCOMPARE( report.rejectedCount, qint64(3) );
+   QCOMPARE( report.rejected.size(), 3 );
+   QCOMPARE( report.rejected[0].first, qint64(2) );
+   QCOMPARE( report.rejected[1].first, qint64(3) );
+   QCOMPARE( report.rejected[2].first, qint64(4) );
+   QCOMPARE( column("Name"), QVariantList({ "Bolt", "Nut" }) );
+}
+
+
+void CImporterTest::reportsMissingTable()
+{
+   QByteArray data("{\"Name\": \"Bolt\"}\n");
+   QBuffer buffer(&data);
+   CImporter importer("Screws");
+
+   buffer.open(QIODevice::ReadOnly);
+   CImportReport report=importer.run(&buffer, CImporter::FormatJsonLines);
+
+   QVERIFY( !report.error.isEmpty() );
+   QCOMPARE( report.inserted, qint64(0) );
+}
+
+
+QTEST_GUILESS_MAIN(CImporterTest)
+#include "tst_importer.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
@@ -0,0 +1,175 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_reconcile.cpp
+ * @brief      Rows hidden by foreign keys which do not resolve
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <reconcile.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief Parts with a NULL, a dangling and resolving foreign keys
+ */
+class CReconcileTest : public QObject
+{
+   Q_OBJECT
+
+   /** @brief Reconciler of 'Parts' with both relations */
+   CReconciler parts() const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void countsHiddenRows();
+   void appliesFilter();
+   void limitsMissing();
+   void checksOneRow();
+   void listsVisibleRows();
+   void withoutRelations();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CReconcileTest::initTestCase()
+{
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+
+   db.setDatabaseName(":memory:");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Location (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE TABLE Supplier (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT"
+                       ", Location_id_Name INTEGER, Supplier_id_Name INTEGER)") );
+   QVERIFY( query.exec("INSERT INTO Location (id, Name) VALUES (1, 'Shelf'), (2, 'Drawer')") );
+   QVERIFY( query.exec("INSERT INTO Supplier (id, Name) VALUES (1, 'Acme'), (2, 'Bolts Inc')") );
+   // Nut has no location, Washer one which is gone, Screw no supplier
+   QVERIFY( query.exec("INSERT INTO Parts VALUES (1, 'Bolt', 1, 1), (2, 'Nut', NULL, 1)"
+                       ", (3, 'Washer', 9, 1), (4, 'Screw', 2, NULL), (5, 'Hexbolt', 2, 2)") );
+}
+
+
+void CReconcileTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+CReconciler CReconcileTest::parts() const
+{
+   CReconciler reconciler("Parts");
+
+   reconciler.addRelation("Location_id_Name", "Location");
+   reconciler.addRelation("Supplier_id_Name", "Supplier");
+
+   return(reconciler);
+}
+
+
+void CReconcileTest::countsHiddenRows()
+{
+   CReconcileReport report=parts().run();
+
+   QCOMPARE( report.total, 5 );
+   QCOMPARE( report.visible, 2 );
+   QCOMPARE( report.missingCount, 3 );
+   QCOMPARE( report.missing.size(), 3 );
+   QCOMPARE( report.missing[0].first, qint64(2) );
+   QCOMPARE( report.missing[0].second, QString("Nut") );
+   QCOMPARE( report.missing[1].first, qint64(3) );
+   QCOMPARE( report.missing[2].first, qint64(4) );
+   QCOMPARE( report.missing[2].second, QString("Screw") );
+}
+
+
+void CReconcileTest::appliesFilter()
+{
+   // The filter limits the visible rows only
+   CReconcileReport report=parts().run("Parts.Name LIKE '%bolt%'");
+
+   QCOMPARE( report.total, 5 );
+   QCOMPARE( report.visible, 2 );
+   QCOMPARE( report.missingCount, 3 );
+
+   report=parts().run("Parts.Name = 'Nut'");
+   QCOMPARE( report.visible, 0 );
+   QCOMPARE( report.missingCount, 3 );
+}
+
+
+void CReconcileTest::limitsMissing()
+{
+   CReconcileReport report=parts().run(QString(), 2);
+
+   QCOMPARE( report.missingCount, 3 );
+   QCOMPARE( report.missing.size(), 2 );
+   QCOMPARE( report.missing.last().first, qint64(3) );
+
+   // Counted only
+   report=parts().run(QString(), 0);
+   QCOMPARE( report.missingCount, 3 );
+   QVERIFY( report.missing.isEmpty() );
+}
+
+
+void CReconcileTest::checksOneRow()
+{
+   CReconciler reconciler=parts();
+
+   QVERIFY( !reconciler.isMissing(1) );
+   QVERIFY( reconciler.isMissing(2) );
+   QVERIFY( reconciler.isMissing(3) );
+   QVERIFY( reconciler.isMissing(4) );
+   QVERIFY( !reconciler.isMissing(5) );
+}
+
+
+void CReconcileTest::listsVisibleRows()
+{
+   CRowQuery rows=parts().rowQuery( CSearchClause() );
+   QSqlQuery query;
+
+   // Like the relational model, which inner-joins every relation
+   QVERIFY( query.exec( rows.countStatement() ) );
+   QVERIFY( query.next() );
+   QCOMPARE( query.value(0).toLongLong(), qint64(2) );
+}
+
+
+void CReconcileTest::withoutRelations()
+{
+   CReconciler reconciler("Parts");
+   CReconcileReport report=reconciler.run();
+
+   QVERIFY( reconciler.missingStatement().isEmpty() );
+   QCOMPARE( report.total, 5 );
+   QCOMPARE( report.visible, 5 );
+   QCOMPARE( report.missingCount, 0 );
+   QVERIFY( !reconciler.isMissing(2) );
+}
+
+
+QTEST_GUILESS_MAIN(CReconcileTest)
+#include "tst_reconcile.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
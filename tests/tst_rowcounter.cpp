@@ -0,0 +1,234 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_rowcounter.cpp
+ * @brief      Row counts kept current by the change feed without hooks
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <changefeed.hpp>
+#include <rowcounter.hpp>
+#include <workerpool.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief The hooks are never installed, as if Qt used another SQLite
+ *
+ * The workers count with connections of their own, so the database is a
+ * file.
+ */
+class CRowCounterTest : public QObject
+{
+   Q_OBJECT
+
+   QTemporaryDir m_dir;
+   CChanges m_changes;
+
+   void insert(const QString &table, int rows);
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void init();
+   void countDoesNotCount();
+   void requestCountsOnce();
+   void writtenCountsAgain();
+   void writtenMergesTables();
+   void recountWhileCounting();
+   void searchesAreNotKept();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CRowCounterTest::initTestCase()
+{
+   QVERIFY( m_dir.isValid() );
+
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+   db.setDatabaseName( m_dir.filePath("rowcounter.sqlite") );
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE TABLE Location (id INTEGER PRIMARY KEY, Name TEXT)") );
+   insert("Parts", 10);
+   insert("Location", 2);
+
+   QVERIFY( !CChangeFeed::isInstalled() );
+   connect(CChangeFeed::instance(), &CChangeFeed::changed, this, [this](const CChanges &changes){
+      m_changes += changes;
+   });
+}
+
+
+void CRowCounterTest::cleanupTestCase()
+{
+   CWorkerPool::shutdown();
+   QSqlDatabase::database().close();
+}
+
+
+void CRowCounterTest::init()
+{
+   m_changes.clear();
+}
+
+
+void CRowCounterTest::insert(const QString &table, int rows)
+{
+   QSqlQuery query;
+
+   for(int i1=0; i1<rows; i1++)
+   {
+      QVERIFY( query.exec( QString("INSERT INTO %1 (Name) VALUES ('Row %2')")
+                           .arg(table).arg(i1) ) );
+   }
+}
+
+
+void CRowCounterTest::countDoesNotCount()
+{
+   QCOMPARE( CRowCounter::count("Parts"), qint64(-1) );
+   QVERIFY( !CRowCounter::isCounting("Parts") );
+   QCOMPARE( CRowCounter::count("Parts"), qint64(-1) );
+}
+
+
+void CRowCounterTest::requestCountsOnce()
+{
+   QSignalSpy counted(CRowCounter::instance(), &CRowCounter::counted);
+
+   CRowCounter::request("Parts");
+   QVERIFY( CRowCounter::isCounting("Parts") );
+   QTRY_COMPARE( CRowCounter::count("Parts"), qint64(10) );
+   QCOMPARE( counted.size(), 1 );
+   QCOMPARE( counted.first().at(0).toString(), QString("Parts") );
+   QCOMPARE( counted.first().at(1).toLongLong(), qint64(10) );
+
+   // Known, so neither counted nor reported again
+   CRowCounter::request("Parts");
+   QVERIFY( !CRowCounter::isCounting("Parts") );
+   QTest::qWait(50);
+   QCOMPARE( counted.size(), 1 );
+}
+
+
+void CRowCounterTest::writtenCountsAgain()
+{
+   int origin=0;
+
+   CRowCounter::request("Parts");
+   QTRY_VERIFY( !CRowCounter::isCounting("Parts") );
+   qint64 before=CRowCounter::count("Parts");
+
+   // Without the hooks the rows written are not seen
+   insert("Parts", 5);
+   QTest::qWait(50);
+   QCOMPARE( CRowCounter::count("Parts"), before );
+
+   CChangeFeed::written("Parts", &origin);
+   QTRY_COMPARE( m_changes.size(), 1 );
+   QCOMPARE( m_changes.first().table, QString("Parts") );
+   QCOMPARE( m_changes.first().op, CChange::Unknown );
+   QCOMPARE( m_changes.first().rowid, qint64(-1) );
+   QVERIFY( m_changes.first().origin == &origin );
+   QTRY_COMPARE( CRowCounter::count("Parts"), before + 5 );
+
+   // Nobody asked for it, so it is not counted
+   CChangeFeed::written("Location", &origin);
+   QTRY_COMPARE( m_changes.size(), 2 );
+   QVERIFY( !CRowCounter::isCounting("Location") );
+   QCOMPARE( CRowCounter::count("Location"), qint64(-1) );
+}
+
+
+void CRowCounterTest::writtenMergesTables()
+{
+   int first=0;
+   int second=0;
+
+   // Reported once per pass; by several writers the origin is unknown
+   CChangeFeed::written("Parts", &first);
+   CChangeFeed::written("Parts", &first);
+   CChangeFeed::written("Location", &first);
+   CChangeFeed::written("Location", &second);
+   QTRY_COMPARE( m_changes.size(), 2 );
+   QTest::qWait(50);
+   QCOMPARE( m_changes.size(), 2 );
+
+   for(const CChange &change: m_changes)
+   {
+      QCOMPARE( change.op, CChange::Unknown );
+      if( change.table == "Parts" )
+      {
+         QVERIFY( change.origin == &first );
+      }
+      else
+      {
+         QCOMPARE( change.table, QString("Location") );
+         QVERIFY( change.origin == nullptr );
+      }
+   }
+   QTRY_VERIFY( !CRowCounter::isCounting("Parts") );
+}
+
+
+void CRowCounterTest::recountWhileCounting()
+{
+   QSignalSpy counted(CRowCounter::instance(), &CRowCounter::counted);
+
+   CRowCounter::request("Parts");
+   QTRY_VERIFY( !CRowCounter::isCounting("Parts") );
+   qint64 before=CRowCounter::count("Parts");
+
+   // Rows written while counting may be missed; the count is repeated
+   CRowCounter::recount("Parts");
+   QVERIFY( CRowCounter::isCounting("Parts") );
+   insert("Parts", 3);
+   CChangeFeed::written("Parts", nullptr);
+   CRowCounter::recount("Parts");
+   QTRY_VERIFY( !CRowCounter::isCounting("Parts") );
+   QCOMPARE( CRowCounter::count("Parts"), before + 3 );
+   QCOMPARE( counted.last().at(1).toLongLong(), before + 3 );
+}
+
+
+void CRowCounterTest::searchesAreNotKept()
+{
+   CRowQuery query;
+   int generation=0;
+
+   query.from="\"Parts\"";
+   query.id="\"Parts\".id";
+   query.name="\"Parts\".Name";
+   query.table="Parts";
+
+   // Writes of this process would not drop the number
+   CRowCounter::cached(query, &generation);
+   CRowCounter::remember(query, 42, generation);
+   QCOMPARE( CRowCounter::cached(query, &generation), qint64(-1) );
+}
+
+
+QTEST_GUILESS_MAIN(CRowCounterTest)
+#include "tst_rowcounter.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
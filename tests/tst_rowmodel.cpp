@@ -0,0 +1,280 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_rowmodel.cpp
+ * @brief      Seeking and matching Names in the keyset paged row model
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <rowmodel.hpp>
+#include <searchindex.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+class CRowModelTest : public QObject
+{
+   Q_OBJECT
+
+   enum
+   {
+      /** @brief Rows with a Name; several pages */
+      Rows=1000,
+      /** @brief Rows without a Name, sorted first */
+      Nulls=3,
+   };
+
+   /** @brief Query of all parts; sorted by Name with 'byName' */
+   CRowQuery query(bool byName, bool descending) const;
+   /** @brief Show 'query' like the search worker does */
+   void show(CRowModel &model, const CRowQuery &query) const;
+   QString nameAt(const CRowModel &model, int row) const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void prefixEnd();
+   void seekAscending();
+   void seekDescending();
+   void seekWithoutMatch();
+   void matchByName();
+   void matchReadRowsOnly();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CRowModelTest::initTestCase()
+{
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+
+   db.setDatabaseName(":memory:");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("CREATE INDEX PartsName ON Parts (Name, id)") );
+   QVERIFY( db.transaction() );
+   // Inserted backwards, so the ids are not in the order of the Names
+   QVERIFY( query.prepare("INSERT INTO Parts (Name) VALUES (?)") );
+   for(int i1=Rows-1; i1>=0; i1--)
+   {
+      query.addBindValue( QString("Part %1").arg(i1, 4, 10, QChar('0')) );
+      QVERIFY( query.exec() );
+   }
+   for(int i1=0; i1<Nulls; i1++)
+   {
+      QVERIFY( query.exec("INSERT INTO Parts (Name) VALUES (NULL)") );
+   }
+   QVERIFY( db.commit() );
+}
+
+
+void CRowModelTest::cleanupTestCase()
+{
+   QSqlDatabase::database().close();
+}
+
+
+CRowQuery CRowModelTest::query(bool byName, bool descending) const
+{
+   CRowQuery query;
+
+   query.from="\"Parts\"";
+   query.id="\"Parts\".id";
+   query.name="\"Parts\".Name";
+   query.key=byName ? query.name : QString();
+   query.descending=descending;
+   query.table="Parts";
+
+   return(query);
+}
+
+
+void CRowModelTest::show(CRowModel &model, const CRowQuery &query) const
+{
+   QSqlQuery page;
+   CRows rows;
+
+   QVERIFY( page.exec( query.pageStatement(false, CRowModel::PageSize) ) );
+   while(page.next())
+   {
+      rows.append( { page.value(0).toLongLong(), page.value(1).toString()
+                   , query.key.isEmpty() ? QVariant() : page.value(2) } );
+   }
+   model.setQuery(query, Rows + Nulls, rows);
+}
+
+
+QString CRowModelTest::nameAt(const CRowModel &model, int row) const
+{
+   return( model.data( model.index(row, CRowModel::ColumnName) ).toString() );
+}
+
+
+void CRowModelTest::prefixEnd()
+{
+   QCOMPARE( CSearchIndex::prefixEnd("Part 05"), QString("Part 06") );
+   QCOMPARE( CSearchIndex::prefixEnd("Part 09"), QString("Part 0:") );
+   // Nothing sorts after the largest code point
+   QCOMPARE( CSearchIndex::prefixEnd( QString::fromUcs4(U"\U0010FFFF") ), QString() );
+}
+
+
+void CRowModelTest::seekAscending()
+{
+   CRowModel model;
+
+   show(model, query(true, false));
+
+   // NULL Names are sorted first
+   int row=model.seek("Part 05");
+   QCOMPARE( row, Nulls + 500 );
+   QCOMPARE( nameAt(model, row), QString("Part 0500") );
+   QCOMPARE( nameAt(model, row - 1), QString("Part 0499") );
+
+   row=model.seek("Part 0999");
+   QCOMPARE( row, Nulls + Rows - 1 );
+   QCOMPARE( nameAt(model, row), QString("Part 0999") );
+}
+
+
+void CRowModelTest::seekDescending()
+{
+   CRowModel model;
+
+   show(model, query(true, true));
+
+   // The largest Name starting with the prefix comes first
+   int row=model.seek("Part 05");
+   QCOMPARE( row, 400 );
+   QCOMPARE( nameAt(model, row), QString("Part 0599") );
+   QCOMPARE( nameAt(model, row + 1), QString("Part 0598") );
+
+   row=model.seek("Part 0000");
+   QCOMPARE( row, Rows - 1 );
+   QCOMPARE( nameAt(model, row), QString("Part 0000") );
+}
+
+
+void CRowModelTest::seekWithoutMatch()
+{
+   CRowModel ascending;
+   CRowModel descending;
+   CRowModel byId;
+
+   show(ascending, query(true, false));
+   show(descending, query(true, true));
+   show(byId, query(false, false));
+
+   // Lands between two Names or behind the last one
+   QCOMPARE( ascending.seek("Part 05x"), -1 );
+   QCOMPARE( ascending.seek("Part 1"), -1 );
+   QCOMPARE( ascending.seek("Bolt"), -1 );
+   QCOMPARE( descending.seek("Part 05x"), -1 );
+   QCOMPARE( descending.seek("Part 1"), -1 );
+   QCOMPARE( descending.seek("Bolt"), -1 );
+   QCOMPARE( ascending.seek(QString()), -1 );
+   // Positions are only known in the order of the Names
+   QCOMPARE( byId.seek("Part 05"), -1 );
+}
+
+
+void CRowModelTest::matchByName()
+{
+   CRowModel model;
+
+   show(model, query(true, false));
+
+   QModelIndexList matches=model.match(model.index(0, CRowModel::ColumnName)
+                                       , Qt::DisplayRole, "Part 07");
+   QCOMPARE( matches.size(), 1 );
+   QCOMPARE( matches.first().row(), Nulls + 700 );
+   QCOMPARE( matches.first().column(), int(CRowModel::ColumnName) );
+
+   matches=model.match(model.index(0, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 07x");
+   QVERIFY( matches.isEmpty() );
+
+   // Binary like the index
+   matches=model.match(model.index(0, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "part 07");
+   QVERIFY( matches.isEmpty() );
+
+   // Typing again goes on from the current row
+   matches=model.match(model.index(Nulls + 750, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 07");
+   QCOMPARE( matches.size(), 1 );
+   QCOMPARE( matches.first().row(), Nulls + 750 );
+
+   // Behind the rows starting with the text only with wrapping
+   matches=model.match(model.index(Nulls + 900, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 07");
+   QCOMPARE( matches.size(), 1 );
+   QCOMPARE( matches.first().row(), Nulls + 700 );
+   matches=model.match(model.index(Nulls + 900, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 07", 1, Qt::MatchStartsWith);
+   QVERIFY( matches.isEmpty() );
+}
+
+
+void CRowModelTest::matchReadRowsOnly()
+{
+   CRowModel model;
+
+   show(model, query(false, false));
+
+   // The first ids got the last Names
+   QModelIndexList matches=model.match(model.index(0, CRowModel::ColumnName)
+                                       , Qt::DisplayRole, "Part 0999");
+   QCOMPARE( matches.size(), 1 );
+   QCOMPARE( matches.first().row(), 0 );
+
+   // Case sensitive like seeking
+   matches=model.match(model.index(0, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "part 0999");
+   QVERIFY( matches.isEmpty() );
+
+   // In the order of the rows, from 'start' on
+   matches=model.match(model.index(10, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 09", 3);
+   QCOMPARE( matches.size(), 3 );
+   QCOMPARE( matches[0].row(), 10 );
+   QCOMPARE( matches[1].row(), 11 );
+   QCOMPARE( matches[2].row(), 12 );
+
+   // Rows 0 to 99 are 'Part 09..'; after them only with wrapping
+   matches=model.match(model.index(200, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 09");
+   QCOMPARE( matches.size(), 1 );
+   QCOMPARE( matches.first().row(), 0 );
+   matches=model.match(model.index(200, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 09", 1, Qt::MatchStartsWith);
+   QVERIFY( matches.isEmpty() );
+
+   // Not read yet, so not searched
+   matches=model.match(model.index(0, CRowModel::ColumnName)
+                       , Qt::DisplayRole, "Part 0000");
+   QVERIFY( matches.isEmpty() );
+}
+
+
+QTEST_GUILESS_MAIN(CRowModelTest)
+#include "tst_rowmodel.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
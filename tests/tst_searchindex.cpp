@@ -0,0 +1,228 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_searchindex.cpp
+ * @brief      Clauses of the search box and the tables of the index
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <searchindex.hpp>
+#include <connection.hpp>
+#include <schema.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+class CSearchIndexTest : public QObject
+{
+   Q_OBJECT
+
+   /** @brief Names of the parts selected by 'clause', in its order */
+   QStringList names(const CSearchClause &clause) const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void likeEscapesWildcards();
+   void matchQuotesWords();
+   void matchRanksPrefixes();
+   void idClause();
+   void knowsIndexTables();
+   void prefixEnd();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CSearchIndexTest::initTestCase()
+{
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+
+   db.setDatabaseName(":memory:");
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY, Name TEXT, Notes TEXT)") );
+   // Named like the tables of an index, but a table of the user
+   QVERIFY( query.exec("CREATE TABLE Stock_data (id INTEGER PRIMARY KEY, Name TEXT)") );
+   QVERIFY( query.exec("INSERT INTO Parts (Name, Notes) VALUES"
+                       " ('Bolt', '50% off'), ('Nut', '50 pieces'), ('Washer', 'a_b')"
+                       ", ('Screw', 'back\\slash'), ('Bolt AND Nut', 'set')"
+                       ", ('Hexbolt', 'bolt \"M4\"')") );
+   QVERIFY( CSchema::load(db) );
+   CSearchIndex::readIndexes(db);
+}
+
+
+void CSearchIndexTest::cleanupTestCase()
+{
+   CSearchIndex::setEnabled(false);
+   QSqlDatabase::database().close();
+}
+
+
+QStringList CSearchIndexTest::names(const CSearchClause &clause) const
+{
+   QSqlQuery query;
+   QStringList names;
+   QString table=CConnection::escapeTable("Parts");
+   QString statement=QString("SELECT %1.Name FROM %1").arg(table) + clause.join;
+
+   if( !clause.where.isEmpty() )
+   {
+      statement += " WHERE " + clause.where;
+   }
+   statement += " ORDER BY " + ( clause.order.isEmpty() ? table + ".id" : clause.order );
+
+   if( !query.prepare(statement) )
+   {
+      qWarning("%s: %s", qPrintable(statement), qPrintable(query.lastError().text()));
+      return( { "<error>" } );
+   }
+   for(const QVariant &value: clause.values)
+   {
+      query.addBindValue(value);
+   }
+   if( !query.exec() )
+   {
+      qWarning("%s: %s", qPrintable(statement), qPrintable(query.lastError().text()));
+      return( { "<error>" } );
+   }
+   while(query.next())
+   {
+      names << query.value(0).toString();
+   }
+
+   return(names);
+}
+
+
+void CSearchIndexTest::likeEscapesWildcards()
+{
+   CSearchIndex index("Parts");
+
+   CSearchIndex::setEnabled(false);
+   QVERIFY( !index.open() );
+
+   // Wildcards and the escape character are found as typed
+   QCOMPARE( names( index.clause("50%") ), QStringList({ "Bolt" }) );
+   QCOMPARE( names( index.clause("a_b") ), QStringList({ "Washer" }) );
+   QCOMPARE( names( index.clause("k\\s") ), QStringList({ "Screw" }) );
+   // Any column, case insensitive
+   QCOMPARE( names( index.clause("BOLT") ), QStringList({ "Bolt", "Bolt AND Nut", "Hexbolt" }) );
+   QVERIFY( index.clause("  ").where.isEmpty() );
+}
+
+
+void CSearchIndexTest::matchQuotesWords()
+{
+   CSearchIndex index("Parts");
+
+   CSearchIndex::setEnabled(true);
+   if( !CSearchIndex::isAvailable() )
+   {
+      QSKIP("SQLite has no FTS5 support");
+   }
+   QVERIFY( index.open() );
+
+   // FTS5 syntax typed by the user is searched as words
+   QCOMPARE( names( index.clause("AND") ), QStringList({ "Bolt AND Nut" }) );
+   QCOMPARE( names( index.clause("\"M4") ), QStringList({ "Hexbolt" }) );
+   QCOMPARE( names( index.clause("NEAR( *") ), QStringList() );
+   // A word without letters is no term
+   QStringList nuts=names( index.clause("- Nut") );
+   nuts.sort();
+   QCOMPARE( nuts, QStringList({ "Bolt AND Nut", "Nut" }) );
+}
+
+
+void CSearchIndexTest::matchRanksPrefixes()
+{
+   CSearchIndex index("Parts");
+
+   CSearchIndex::setEnabled(true);
+   if( !CSearchIndex::isAvailable() )
+   {
+      QSKIP("SQLite has no FTS5 support");
+   }
+   QVERIFY( index.open() );
+
+   // Every word is a prefix, all words have to match
+   QCOMPARE( names( index.clause("pie") ), QStringList({ "Nut" }) );
+   QCOMPARE( names( index.clause("bol nu") ), QStringList({ "Bolt AND Nut" }) );
+   QStringList bolts=names( index.clause("bolt") );
+   bolts.sort();
+   QCOMPARE( bolts, QStringList({ "Bolt", "Bolt AND Nut", "Hexbolt" }) );
+   QCOMPARE( index.clause("bolt").order, QString("fts.rank") );
+}
+
+
+void CSearchIndexTest::idClause()
+{
+   CSearchIndex index("Parts");
+
+   QCOMPARE( names( index.idClause(" 2 ") ), QStringList({ "Nut" }) );
+   QCOMPARE( names( index.idClause("Nut") ), QStringList() );
+   QVERIFY( index.idClause("").where.isEmpty() );
+}
+
+
+void CSearchIndexTest::knowsIndexTables()
+{
+   CSearchIndex index("Parts");
+
+   CSearchIndex::setEnabled(true);
+   if( !CSearchIndex::isAvailable() )
+   {
+      QSKIP("SQLite has no FTS5 support");
+   }
+   QVERIFY( index.open() );
+
+   QVERIFY( CSearchIndex::isIndexTable("Parts__fts") );
+   QVERIFY( CSearchIndex::isIndexTable("Parts__fts_data") );
+   QVERIFY( CSearchIndex::isIndexTable("Parts__fts_config") );
+   QVERIFY( !CSearchIndex::isIndexTable("Parts") );
+   QVERIFY( !CSearchIndex::isIndexTable("Stock_data") );
+
+   // Found again when the file is opened
+   QVERIFY( CSchema::load() );
+   CSearchIndex::readIndexes();
+   QVERIFY( CSearchIndex::isIndexTable("Parts__fts_idx") );
+   QVERIFY( !CSearchIndex::isIndexTable("Stock_data") );
+}
+
+
+void CSearchIndexTest::prefixEnd()
+{
+   QCOMPARE( CSearchIndex::prefixEnd("Bo"), QString("Bp") );
+   QCOMPARE( CSearchIndex::prefixEnd(""), QString() );
+   // Beyond the surrogates and beyond U+FFFF
+   QCOMPARE( CSearchIndex::prefixEnd( QString( QChar(0xD7FF) ) ), QString( QChar(0xE000) ) );
+   QCOMPARE( CSearchIndex::prefixEnd( QString( QChar(0xFFFF) ) )
+             , QString::fromUcs4( U"\U00010000" ) );
+   // The largest code point has no successor
+   QCOMPARE( CSearchIndex::prefixEnd( "a" + QString::fromUcs4( U"\U0010FFFF" ) ), QString("b") );
+   QCOMPARE( CSearchIndex::prefixEnd( QString::fromUcs4( U"\U0010FFFF" ) ), QString() );
+}
+
+
+QTEST_GUILESS_MAIN(CSearchIndexTest)
+#include "tst_searchindex.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/
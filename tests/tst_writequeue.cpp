@@ -0,0 +1,267 @@
+/**---------------------------------------------------------------------------
+ *
+ * @file       tst_writequeue.cpp
+ * @brief      Order and failures of the writes behind
+ *
+ * See README.md for further information
+ *
+ * @date      20250729
+ * @author    Maximilian Seesslen <dev@seesslen.net>
+ * @copyright SPDX-License-Identifier: Apache-2.0
+ *
+ *--------------------------------------------------------------------------*/
+
+
+/*--- Includes -------------------------------------------------------------*/
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <writequeue.hpp>
+#include <changefeed.hpp>
+
+
+/*--- Declaration ----------------------------------------------------------*/
+
+
+/** @brief The writer has a connection of its own, so the database is a file
+ */
+class CWriteQueueTest : public QObject
+{
+   Q_OBJECT
+
+   /** @brief Callback of one write */
+   struct Result
+   {
+      int write;
+      qint64 id;
+      QString error;
+   };
+
+   QTemporaryDir m_dir;
+   QVector<Result> m_results;
+
+   /** @brief Callback recording the result of write number 'write' */
+   CWriteQueue::Callback record(int write);
+   QStringList names() const;
+   qint64 idOf(const QString &name) const;
+
+private slots:
+   void initTestCase();
+   void cleanupTestCase();
+   void init();
+   void keepsOrder();
+   void failsAlone();
+   void skipsDeletedReceiver();
+   void runsAfterGroup();
+   void writesOnStop();
+};
+
+
+/*--- Implementation -------------------------------------------------------*/
+
+
+void CWriteQueueTest::initTestCase()
+{
+   QVERIFY( m_dir.isValid() );
+
+   QSqlDatabase db=QSqlDatabase::addDatabase("QSQLITE");
+   db.setDatabaseName( m_dir.filePath("writequeue.sqlite") );
+   QVERIFY( db.open() );
+
+   QSqlQuery query(db);
+   QVERIFY( query.exec("CREATE TABLE Parts (id INTEGER PRIMARY KEY"
+                       ", Name TEXT NOT NULL UNIQUE, Count INTEGER)") );
+
+   // Created by the GUI thread, like when opening the database
+   CChangeFeed::instance();
+   CWriteQueue::start();
+   QVERIFY( CWriteQueue::isRunning() );
+}
+
+
+void CWriteQueueTest::cleanupTestCase()
+{
+   CWriteQueue::stop();
+   QSqlDatabase::database().close();
+}
+
+
+void CWriteQueueTest::init()
+{
+   QSqlQuery query;
+
+   // The writer is idle, all callbacks of the last test arrived
+   QVERIFY( query.exec("DELETE FROM Parts") );
+   m_results.clear();
+}
+
+
+CWriteQueue::Callback CWriteQueueTest::record(int write)
+{
+   return( [this, write](qint64 id, const QString &error){
+      m_results.append( { write, id, error } );
+   } );
+}
+
+
+QStringList CWriteQueueTest::names() const
+{
+   QSqlQuery query;
+   QStringList names;
+
+   query.exec("SELECT Name FROM Parts ORDER BY id");
+   while(query.next())
+   {
+      names << query.value(0).toString();
+   }
+
+   return(names);
+}
+
+
+qint64 CWriteQueueTest::idOf(const QString &name) const
+{
+   QSqlQuery query;
+
+   query.prepare("SELECT id FROM Parts WHERE Name=?");
+   query.addBindValue(name);
+   if( !query.exec() || !query.next() )
+   {
+      return(-1);
+   }
+
+   return( query.value(0).toLongLong() );
+}
+
+
+void CWriteQueueTest::keepsOrder()
+{
+   enum { Writes=50 };
+   QStringList expected;
+
+   // Pushed faster than written, so several groups of several writes
+   for(int i1=0; i1<Writes; i1++)
+   {
+      QString name=QString("Part %1").arg(i1, 2, 10, QChar('0'));
+      CWriteQueue::insert("Parts", { { "Name", name } }, this, this, record(i1));
+      expected << name;
+   }
+   QTRY_COMPARE( m_results.size(), int(Writes) );
+
+   // Written and reported in the order queued
+   QCOMPARE( names(), expected );
+   for(int i1=0; i1<Writes; i1++)
+   {
+      QCOMPARE( m_results[i1].write, i1 );
+      QVERIFY( m_results[i1].error.isEmpty() );
+      QCOMPARE( m_results[i1].id, idOf(expected[i1]) );
+   }
+
+   // Later writes of the same row win
+   qint64 id=m_results[0].id;
+   qint64 removed=m_results[1].id;
+   m_results.clear();
+   CWriteQueue::update("Parts", id, { { "Count", 1 } }, this, this, record(0));
+   CWriteQueue::update("Parts", removed, { { "Count", 1 } }, this, this, record(1));
+   CWriteQueue::update("Parts", id, { { "Count", 2 } }, this, this, record(2));
+   CWriteQueue::remove("Parts", removed, this, this, record(3));
+   CWriteQueue::update("Parts", id, { { "Count", 3 } }, this, this, record(4));
+   QTRY_COMPARE( m_results.size(), 5 );
+
+   QSqlQuery query;
+   QVERIFY( query.exec( QString("SELECT Count FROM Parts WHERE id=%1").arg(id) ) );
+   QVERIFY( query.next() );
+   QCOMPARE( query.value(0).toInt(), 3 );
+   QCOMPARE( idOf(expected[1]), qint64(-1) );
+}
+
+
+void CWriteQueueTest::failsAlone()
+{
+   // The duplicate and the missing Name violate constraints
+   CWriteQueue::insert("Parts", { { "Name", "Bolt" } }, this, this, record(0));
+   CWriteQueue::insert("Parts", { { "Name", "Bolt" } }, this, this, record(1));
+   CWriteQueue::insert("Parts", { { "Count", 4 } }, this, this, record(2));
+   CWriteQueue::insert("Parts", { { "Name", "Nut" } }, this, this, record(3));
+   CWriteQueue::update("Parts", 0, { { "Nam", "Washer" } }, this, this, record(4));
+   QTRY_COMPARE( m_results.size(), 5 );
+
+   QVERIFY( m_results[0].error.isEmpty() );
+   QVERIFY( !m_results[1].error.isEmpty() );
+   QVERIFY( !m_results[2].error.isEmpty() );
+   QVERIFY( m_results[3].error.isEmpty() );
+   QVERIFY( !m_results[4].error.isEmpty() );
+   // Rolled back alone; the others of the group are committed
+   QCOMPARE( names(), QStringList({ "Bolt", "Nut" }) );
+   QCOMPARE( m_results[0].id, idOf("Bolt") );
+   QCOMPARE( m_results[3].id, idOf("Nut") );
+
+   // The failed statements do not hurt the next group
+   m_results.clear();
+   CWriteQueue::insert("Parts", { { "Name", "Washer" } }, this, this, record(0));
+   QTRY_COMPARE( m_results.size(), 1 );
+   QVERIFY( m_results[0].error.isEmpty() );
+   QCOMPARE( names(), QStringList({ "Bolt", "Nut", "Washer" }) );
+}
+
+
+void CWriteQueueTest::skipsDeletedReceiver()
+{
+   QObject *receiver=new QObject();
+   bool called=false;
+
+   CWriteQueue::insert("Parts", { { "Name", "Bolt" } }, this, receiver
+                       , [&called](qint64, const QString &){ called=true; });
+   delete receiver;
+   CWriteQueue::insert("Parts", { { "Name", "Nut" } }, this, this, record(0));
+   QTRY_COMPARE( m_results.size(), 1 );
+   QTest::qWait(50);
+
+   // Written anyway, but nobody is told
+   QVERIFY( !called );
+   QCOMPARE( names(), QStringList({ "Bolt", "Nut" }) );
+}
+
+
+void CWriteQueueTest::runsAfterGroup()
+{
+   QAtomicInt rows(-1);
+
+   CWriteQueue::insert("Parts", { { "Name", "Bolt" } }, this, this, record(0));
+   CWriteQueue::insert("Parts", { { "Name", "Nut" } }, this, this, record(1));
+   CWriteQueue::run( [&rows](const QSqlDatabase &db){
+      QSqlQuery query(db);
+      if( query.exec("SELECT COUNT(*) FROM Parts") && query.next() )
+      {
+         rows.storeRelease( query.value(0).toInt() );
+      }
+   } );
+   QTRY_COMPARE( rows.loadAcquire(), 2 );
+   QTRY_COMPARE( m_results.size(), 2 );
+}
+
+
+void CWriteQueueTest::writesOnStop()
+{
+   CWriteQueue::insert("Parts", { { "Name", "Bolt" } }, this, this, record(0));
+   CWriteQueue::stop();
+   QVERIFY( !CWriteQueue::isRunning() );
+
+   // Nothing queued is lost
+   QCOMPARE( names(), QStringList({ "Bolt" }) );
+   QTRY_COMPARE( m_results.size(), 1 );
+   QVERIFY( m_results[0].error.isEmpty() );
+
+   CWriteQueue::start();
+   QVERIFY( CWriteQueue::isRunning() );
+}
+
+
+QTEST_GUILESS_MAIN(CWriteQueueTest)
+#include "tst_writequeue.moc"
+
+
+/*--- Fin ------------------------------------------------------------------*/